@@ -0,0 +1,60 @@
+/**
+ * @file crc_bench.cpp
+ * @brief Google Benchmark comparison of the CRC-8 kernels.
+ * @details Built when FTX_BUILD_BENCHMARKS is enabled:
+ *          @code
+ *          cmake -S . -B build -DFTX_BUILD_BENCHMARKS=ON
+ *          cmake --build build --target ftx_crc_bench
+ *          ./build/ftx_crc_bench
+ *          @endcode
+ *          Buffer sizes span a single SRL1 header up to a full 64 KB USB
+ *          read packet.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "crc.hpp"
+
+namespace {
+
+std::vector<unsigned char> MakeBuffer(std::size_t size)
+{
+    std::mt19937 rng(0x5A7u);
+    std::vector<unsigned char> buffer(size);
+    for (auto& byte : buffer)
+    {
+        byte = static_cast<unsigned char>(rng());
+    }
+    return buffer;
+}
+
+template <crc8::crc_t (*Kernel)(crc8::crc_t, const unsigned char*, std::size_t) noexcept>
+void BM_Crc8(benchmark::State& state)
+{
+    const std::vector<unsigned char> buffer = MakeBuffer(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Kernel(0, buffer.data(), buffer.size()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BufferSizes(benchmark::internal::Benchmark* b)
+{
+    b->RangeMultiplier(8)->Range(8, 64 * 1024);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Crc8, crc8::detail::crc_update_bytewise)->Apply(BufferSizes);
+BENCHMARK_TEMPLATE(BM_Crc8, crc8::detail::crc_update_slice8)->Apply(BufferSizes);
+#if FTX_CRC8_HAVE_CLMUL
+BENCHMARK_TEMPLATE(BM_Crc8, crc8::detail::crc_update_clmul)->Apply(BufferSizes);
+#endif
+BENCHMARK_TEMPLATE(BM_Crc8, crc8::crc_update)->Apply(BufferSizes);
+
+BENCHMARK_MAIN();
@@ -1,7 +1,10 @@
 /**
  * @file crc.hpp
  * @brief CRC-8 checksum computation utilities.
- * @details Provides efficient CRC-8 calculation using a lookup table.
+ * @details Provides efficient CRC-8 calculation using lookup tables. The
+ *          public entry point dispatches at runtime to the fastest kernel
+ *          the CPU supports (PCLMULQDQ folding on x86-64, slicing-by-8
+ *          elsewhere); every kernel yields the same value.
  */
 
 #ifndef CRC_HPP
@@ -10,6 +13,15 @@
 #include <cstddef>
 #include <cstdint>
 
+/**
+ * @brief Non-zero when the PCLMULQDQ kernel is compiled in.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FTX_CRC8_HAVE_CLMUL 1
+#else
+#define FTX_CRC8_HAVE_CLMUL 0
+#endif
+
 /**
  * @namespace crc8
  * @brief CRC-8 checksum operations.
@@ -25,9 +37,10 @@ using crc_t = uint8_t;
 /**
  * @brief Update CRC-8 value with a block of data.
  *
- * Uses a precomputed lookup table for O(n) efficient computation.
- * Combines multiple bytes into a single CRC value suitable for
- * Saturn cartridge communication protocols.
+ * Runs the kernel picked once at first use: carry-less multiply folding
+ * (detail::crc_update_clmul) when the CPU has PCLMULQDQ and SSSE3,
+ * slicing-by-8 (detail::crc_update_slice8) otherwise. Both match the
+ * bytewise table reference for any length and alignment.
  *
  * @param crc Current CRC value (initialize with 0 for new computation).
  * @param data Pointer to input data buffer.
@@ -37,6 +50,38 @@ using crc_t = uint8_t;
  */
 crc_t crc_update(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept;
 
+/**
+ * @brief Name of the kernel selected by crc_update ("pclmul" or "slice8").
+ */
+const char* kernel_name() noexcept;
+
+/**
+ * @namespace crc8::detail
+ * @brief Individual CRC-8 kernels, exposed for benchmarking.
+ */
+namespace detail {
+
+/**
+ * @brief Reference kernel: one table lookup per byte.
+ */
+crc_t crc_update_bytewise(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept;
+
+/**
+ * @brief Slicing-by-8 kernel: eight table lookups per 8-byte word.
+ */
+crc_t crc_update_slice8(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept;
+
+#if FTX_CRC8_HAVE_CLMUL
+/**
+ * @brief Carry-less multiply folding kernel.
+ * @warning Requires a CPU with PCLMULQDQ and SSSE3; use crc_update() unless
+ *          support was checked.
+ */
+crc_t crc_update_clmul(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept;
+#endif
+
+} // namespace detail
+
 } // namespace crc8
 
 #endif // CRC_HPP
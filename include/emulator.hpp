@@ -0,0 +1,194 @@
+/**
+ * @file emulator.hpp
+ * @brief In-process software model of the USB dev cart firmware.
+ * @details The emulator consumes the exact byte stream the host would send
+ *          over USB and produces the bytes the cartridge would answer with.
+ *          It implements:
+ *          - the USBDC_FUNC_* memory protocol (download, upload, exec,
+ *            exec-ext, buffer address, copy-exec) against a sparse RAM image;
+ *          - the raw SD sector upload against an in-memory sector store;
+ *          - the SRL1 remote-IO protocol and its tagged SRL2 extension (see
+ *            remote_io.hpp) against an in-memory, case-insensitive FAT-like
+ *            directory tree, including block delta PATCH uploads and
+ *            on-card COPY;
+ *          - the LZF decompressor stub ABI (see lzf_upload.hpp): executing
+ *            LZF_UPLOAD_STUB_ADDRESS expands the staged stream in place.
+ *
+ *          Bound to a transport with transport::MakeEmulatorTransport() it
+ *          lets every xfer, WebDAV and sync code path run on machines
+ *          without hardware.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace transport {
+class Transport;
+}
+
+/**
+ * @namespace emu
+ * @brief Cartridge emulator.
+ */
+namespace emu {
+
+/**
+ * @brief File or directory stored on the emulated SD card.
+ */
+struct SdNode {
+    std::string name;          ///< Name as created (case preserved)
+    bool is_dir = false;       ///< True for directories
+    std::vector<uint8_t> data; ///< File contents
+    std::time_t mtime = 0;     ///< Last modification time
+};
+
+/**
+ * @brief Byte-level model of the cartridge firmware.
+ * @note Not thread-safe; the emulator transport serializes access.
+ */
+class CartEmulator {
+public:
+    CartEmulator();
+
+    /**
+     * @brief Copy a host folder into the root of the emulated SD card.
+     * @param dir Host directory to import recursively.
+     * @return true on success.
+     */
+    bool LoadSdFromDirectory(const std::string& dir);
+
+    /**
+     * @brief Feed bytes sent by the host and process every complete request.
+     * @param data Host to cartridge bytes.
+     * @param size Number of bytes.
+     */
+    void Feed(const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief Take bytes the cartridge has queued for the host.
+     * @param out Destination buffer.
+     * @param max Capacity of @p out.
+     * @return Number of bytes copied.
+     */
+    std::size_t Drain(unsigned char* out, std::size_t max);
+
+    /**
+     * @brief Number of cartridge to host bytes waiting to be drained.
+     */
+    std::size_t Pending() const { return out_.size() - out_pos_; }
+
+    /**
+     * @brief Drop partially received requests and undrained replies.
+     */
+    void ResetLink();
+
+    /**
+     * @brief Read emulated RAM (unwritten bytes read as zero).
+     */
+    std::vector<uint8_t> ReadRam(uint32_t address, std::size_t size) const;
+
+    /**
+     * @brief Write emulated RAM.
+     */
+    void WriteRam(uint32_t address, const uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Address passed by the last execute command (0 if none).
+     */
+    uint32_t LastExecAddress() const { return last_exec_address_; }
+
+    /**
+     * @brief Look up a file or directory on the emulated SD card.
+     * @param path Absolute or relative card path (case-insensitive).
+     * @return Pointer to the node, or nullptr if it does not exist.
+     */
+    const SdNode* FindSd(const std::string& path) const;
+
+    /**
+     * @brief Create or replace a file on the emulated SD card.
+     * @return true if the parent directory exists and the path is not a directory.
+     */
+    bool WriteSdFile(const std::string& path, const std::vector<uint8_t>& data);
+
+    /**
+     * @brief Answer an SRL1 command with UNSUPPORTED, like firmware that predates it.
+     * @param command RemoteIoCommand code (see remote_io.hpp).
+     */
+    void DisableRemoteIoCommand(uint8_t command) { disabled_commands_.insert(command); }
+
+    /**
+     * @brief Number of host to cartridge bytes fed so far.
+     */
+    uint64_t BytesReceived() const { return bytes_received_; }
+
+private:
+    /// Streaming data phase currently being received.
+    enum class Sink { NONE, RAM, EXEC_RAM, SD_RAW, SD_FILE_SIZE, SD_FILE, SD_PATCH_HEADER, SD_PATCH };
+
+    bool Step();
+    bool StepCommand();
+    bool StepSink();
+    void FinishSink(uint8_t host_crc);
+    void RunDecompressorStub();
+
+    void HandleRemoteIo(uint8_t command, const std::string& arg);
+    void Reply(uint8_t status, const std::string& payload = std::string(), bool more = false);
+    void ReplyStream(const std::vector<std::string>& packets);
+    void Emit(const uint8_t* data, std::size_t size);
+    void EmitByte(uint8_t value);
+
+    std::string ListDirectory(const std::string& key, bool long_format) const;
+    std::vector<std::string> Children(const std::string& key) const;
+    void AppendTree(const std::string& key, const std::string& rel, std::string& stream) const;
+    bool MakeDir(const std::string& path);
+    bool Remove(const std::string& path, bool dirs_only);
+    bool Rename(const std::string& from, const std::string& to);
+    bool ApplySdPatch(const std::string& path, const std::vector<uint8_t>& script);
+
+    static std::string NormalizeKey(const std::string& path);
+    static std::string ParentKey(const std::string& key);
+    static std::string BaseName(const std::string& path);
+
+    // Link buffers
+    std::vector<uint8_t> in_;
+    std::size_t in_pos_ = 0;
+    std::vector<uint8_t> out_;
+    std::size_t out_pos_ = 0;
+
+    // Streaming state
+    Sink sink_ = Sink::NONE;
+    uint32_t sink_address_ = 0;
+    uint32_t sink_start_ = 0;
+    uint32_t sink_remaining_ = 0;
+    uint8_t sink_crc_ = 0;
+    std::string sink_path_;
+    std::vector<uint8_t> sink_buffer_;
+    uint32_t patch_size_ = 0;          ///< New file size announced by a PATCH
+    std::vector<uint8_t> patch_digest_; ///< New file SHA-1 announced by a PATCH
+    int reply_tag_ = -1; ///< Request ID echoed by Reply(), -1 for SRL1
+    bool framed_replies_ = false; ///< Host asked for MORE/FINAL flagged replies
+
+    // Backing stores
+    std::map<uint32_t, std::vector<uint8_t>> ram_pages_;
+    std::map<uint32_t, std::vector<uint8_t>> sd_sectors_;
+    std::map<std::string, SdNode> sd_;
+    uint32_t last_exec_address_ = 0;
+    std::set<uint8_t> disabled_commands_;
+    uint64_t bytes_received_ = 0;
+};
+
+/**
+ * @brief Emulator behind a transport made by transport::MakeEmulatorTransport().
+ * @note Only touch it while no transfer is running on @p link.
+ * @return nullptr if @p link is another kind of transport.
+ */
+CartEmulator* EmulatorOf(transport::Transport& link);
+
+} // namespace emu
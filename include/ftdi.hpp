@@ -47,6 +47,9 @@
 #include <ftdi.h>
 #include <string>
 #include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
 
 namespace ftdi {
 
@@ -56,6 +59,33 @@ extern std::atomic<bool> g_interrupt_flag;
 // Global FTDI device context
 extern struct ftdi_context g_Device;
 
+/**
+ * @brief Default idle timeout for asynchronous transfers, in milliseconds.
+ * @details A transfer is abandoned once no bytes have moved for this long.
+ */
+constexpr int kAsyncIdleTimeoutMs = 5000;
+
+/**
+ * @brief Write a buffer to the device using libftdi's asynchronous API.
+ * @details The buffer is split into bulk transfers of the configured write
+ *          chunk size and several of them are kept in flight at once. The
+ *          call returns once every queued transfer has completed.
+ * @param data Bytes to send; must stay valid until the call returns.
+ * @param size Number of bytes to send.
+ * @return true if all bytes were written, false on error, timeout or interrupt.
+ */
+bool WriteAsync(const unsigned char* data, std::size_t size);
+
+/**
+ * @brief Read exactly @p size bytes from the device using libftdi's asynchronous API.
+ * @param data Destination buffer.
+ * @param size Number of bytes to read.
+ * @param idle_timeout_ms Give up after this many milliseconds without progress.
+ * @return Number of bytes read (less than @p size on timeout or interrupt),
+ *         or -1 on a USB error.
+ */
+long ReadAsync(unsigned char* data, std::size_t size, int idle_timeout_ms = kAsyncIdleTimeoutMs);
+
 /**
  * @brief Initialize FTDI device communication.
  * @param VID USB Vendor ID.
@@ -95,15 +125,55 @@ void DoConsole(bool enable_stdin, bool acknowledge = false);
  * @brief Start a raw TCP proxy that forwards bytes between TCP and FTDI.
  * @param port TCP port to listen on (default 1234).
  * @param verbose If true, prints traced RSP commands with GDB>/Target> prefixes.
+ * @param memory_cache If true, answers repeated GDB memory reads of the BIOS
+ *        and work RAM from a proxy-side cache.
+ * @param native_load If true, sends bulk GDB memory writes (e.g. `load`) as
+ *        USBDC_FUNC_UPLOAD blocks; the stub must serve the cartridge
+ *        protocol while the target is stopped.
+ * @details The first client controls the target; clients connecting while
+ *          it is attached may only read memory and registers.
  * @return Exit status code.
  */
-int DoTcpProxy(uint16_t port = 1234, bool verbose = false);
+int DoTcpProxy(uint16_t port = 1234, bool verbose = false, bool memory_cache = false, bool native_load = false);
 
 /**
  * @brief Start a WebDAV server that exposes the Saturn FAT filesystem.
  * @param port TCP port to listen on (default 8080).
+ * @param cache_ttl Seconds a cached directory listing stays valid; 0 keeps it
+ *        until an SD card changing request is sent.
+ * @return Exit status code.
+ */
+int DoWebDavServer(uint16_t port = 8080, unsigned cache_ttl = 0);
+
+/**
+ * @brief Callback executing one forwarded ftx command line.
+ * @details Receives the arguments without the program name and returns the
+ *          process exit status the client should report.
+ */
+using DaemonCommandFn = std::function<int(const std::vector<std::string>&)>;
+
+/**
+ * @brief Default Unix domain socket of the daemon.
+ * @return $XDG_RUNTIME_DIR/ftx.sock, or /tmp/ftx-<uid>.sock.
+ */
+std::string DefaultDaemonSocketPath();
+
+/**
+ * @brief Keep the device open and run commands received on a Unix socket.
+ * @details Commands from all clients are executed one at a time in arrival
+ *          order; their stdout/stderr are relayed to the requesting client.
+ * @param socket_path Socket to listen on.
+ * @param run_command Executes one forwarded command line.
  * @return Exit status code.
  */
-int DoWebDavServer(uint16_t port = 8080);
+int DoDaemon(const std::string& socket_path, const DaemonCommandFn& run_command);
+
+/**
+ * @brief Forward a command line to a running daemon and relay its output.
+ * @param socket_path Daemon socket.
+ * @param args Arguments to forward (without the program name).
+ * @return Exit status of the remote command.
+ */
+int DoDaemonClient(const std::string& socket_path, const std::vector<std::string>& args);
 
 } // namespace ftdi
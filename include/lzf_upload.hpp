@@ -0,0 +1,81 @@
+/**
+ * @file lzf_upload.hpp
+ * @brief Memory layout of LZF-compressed uploads (ftx -u/-x --compress).
+ * @details A compressed upload stages three things in Saturn RAM:
+ *          - the decompressor stub at FC_DECOMPRESSOR_EXEC, at most
+ *            FC_DECOMPRESSOR_LENGTH bytes;
+ *          - a parameter block of big-endian dwords right below the stub.
+ *            Indexes 0..3 follow the flash firmware FC_*_INDEX parameters
+ *            (image length, destination/execution address, stream length,
+ *            stream CRC-8); index 4 is the stream address, index 5 the flags;
+ *          - the compressed stream, placed inside the destination range so
+ *            it can be expanded in place. The stream is a sequence of
+ *            blocks, each a 4-byte big-endian length followed by a
+ *            comp_exec() record (see sc_compress.h) of at most
+ *            LZF_UPLOAD_CHUNK_SIZE decompressed bytes.
+ *
+ *          The host then executes the stub, which expands the blocks in
+ *          order, checks the stream CRC and either returns to the firmware
+ *          or jumps to the destination when LZF_UPLOAD_FLAG_EXECUTE is set.
+ *          The host places the stream so that no block's output overlaps
+ *          its own input.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include "sc_common.h"
+}
+
+namespace xfer {
+
+/**
+ * @brief Decompressed size of one stream block.
+ */
+constexpr std::size_t LZF_UPLOAD_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * @brief Size of the per-block length prefix.
+ */
+constexpr std::size_t LZF_UPLOAD_BLOCK_HEADER_SIZE = 4;
+
+/**
+ * @brief Load and execution address of the decompressor stub.
+ */
+constexpr uint32_t LZF_UPLOAD_STUB_ADDRESS = FC_DECOMPRESSOR_EXEC;
+
+/**
+ * @brief Largest decompressor stub accepted.
+ */
+constexpr std::size_t LZF_UPLOAD_STUB_MAX_SIZE = FC_DECOMPRESSOR_LENGTH;
+
+/**
+ * @brief Parameter block index of the compressed stream address.
+ */
+constexpr std::size_t LZF_UPLOAD_STREAMADDR_INDEX = 4;
+
+/**
+ * @brief Parameter block index of the LZF_UPLOAD_FLAG_* bits.
+ */
+constexpr std::size_t LZF_UPLOAD_FLAGS_INDEX = 5;
+
+/**
+ * @brief Number of dwords in the parameter block.
+ */
+constexpr std::size_t LZF_UPLOAD_PARAM_COUNT = 6;
+
+/**
+ * @brief Address of the parameter block (immediately below the stub).
+ */
+constexpr uint32_t LZF_UPLOAD_PARAMS_ADDRESS =
+    LZF_UPLOAD_STUB_ADDRESS - static_cast<uint32_t>(LZF_UPLOAD_PARAM_COUNT * 4);
+
+/**
+ * @brief Jump to the destination address once the image is expanded.
+ */
+constexpr uint32_t LZF_UPLOAD_FLAG_EXECUTE = 1u << 0;
+
+} // namespace xfer
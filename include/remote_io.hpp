@@ -0,0 +1,286 @@
+/**
+ * @file remote_io.hpp
+ * @brief Wire definitions of the SRL1 remote-IO protocol.
+ * @details SRL1 carries SD card file operations between the host and the
+ *          cartridge firmware. Every request and reply starts with a 7-byte
+ *          header:
+ *          - 4 bytes magic "SRL1"
+ *          - 1 byte command (request) or status (reply)
+ *          - 2 bytes big-endian payload length
+ *
+ *          Devices answering RemoteIoCommand::VERSION with a version of
+ *          REMOTE_IO_VERSION_TAGGED or later also accept tagged requests. The
+ *          tagged header is 9 bytes:
+ *          - 4 bytes magic "SRL2"
+ *          - 1 byte command (request) or status (reply)
+ *          - 2 bytes big-endian request ID, echoed in every reply packet
+ *          - 2 bytes big-endian payload length
+ *
+ *          The device executes tagged requests in arrival order, so the host
+ *          may keep up to the advertised pipeline depth in flight and match
+ *          the replies by ID. Commands with a data phase (UPLOAD, DOWNLOAD
+ *          and PATCH) are SRL1 only.
+ *
+ *          A host that sends REMOTE_IO_VERSION_FRAMED or later as the VERSION
+ *          payload switches the device to framed replies: the status byte of
+ *          every reply packet, SRL1 or tagged, carries REMOTE_IO_FLAG_MORE if
+ *          more packets of the same reply follow, or REMOTE_IO_FLAG_FINAL on
+ *          its last packet. Multi-packet replies then need neither the empty
+ *          OK sentinel nor an idle timeout to end.
+ *
+ *          Shared by the host implementation in xfer.cpp and the cartridge
+ *          emulator.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xfer {
+
+/**
+ * @brief Magic bytes opening every SRL1 header.
+ */
+constexpr uint8_t REMOTE_IO_MAGIC[4] = {'S', 'R', 'L', '1'};
+
+/**
+ * @brief Size of an SRL1 request/reply header in bytes.
+ */
+constexpr std::size_t REMOTE_IO_HEADER_SIZE = 7;
+
+/**
+ * @brief Magic bytes opening every tagged (SRL2) header.
+ */
+constexpr uint8_t REMOTE_IO_TAGGED_MAGIC[4] = {'S', 'R', 'L', '2'};
+
+/**
+ * @brief Size of a tagged request/reply header in bytes.
+ */
+constexpr std::size_t REMOTE_IO_TAGGED_HEADER_SIZE = 9;
+
+/**
+ * @brief First protocol version accepting tagged requests.
+ * @details The VERSION reply payload is the version byte followed by the
+ *          number of tagged requests the device can buffer.
+ */
+constexpr uint8_t REMOTE_IO_VERSION_TAGGED = 2;
+
+/**
+ * @brief First protocol version supporting framed replies.
+ */
+constexpr uint8_t REMOTE_IO_VERSION_FRAMED = 3;
+
+/**
+ * @brief First protocol version supporting the chunked READ and WRITE commands.
+ */
+constexpr uint8_t REMOTE_IO_VERSION_CHUNKED = 4;
+
+/**
+ * @brief Framed reply status flag: more packets of this reply follow.
+ */
+constexpr uint8_t REMOTE_IO_FLAG_MORE = 0x80;
+
+/**
+ * @brief Framed reply status flag: last packet of this reply.
+ */
+constexpr uint8_t REMOTE_IO_FLAG_FINAL = 0x40;
+
+/**
+ * @brief Status byte bits holding the RemoteIoStatus value.
+ */
+constexpr uint8_t REMOTE_IO_STATUS_MASK = 0x3F;
+
+/**
+ * @brief Largest payload an SRL1 packet can carry.
+ */
+constexpr std::size_t REMOTE_IO_MAX_PAYLOAD = 0xFFFF;
+
+/**
+ * @brief Command byte of the raw SD sector upload (not SRL1 framed).
+ */
+constexpr uint8_t SDRAW_UPLOAD_COMMAND = 0x10;
+
+/**
+ * @brief SRL1 request command codes.
+ */
+enum class RemoteIoCommand : uint8_t
+{
+  LIST = 1,
+  REMOVE = 2,
+  CRC = 3,
+  UPLOAD = 4,
+  MKDIR = 5,
+  RMDIR = 6,
+  RENAME = 7,
+  DOWNLOAD = 8,
+  VERSION = 9,
+  TREE = 10,
+  HASH = 11,
+  BLOCK_SUMS = 12,
+  PATCH = 13,
+  READ = 14,
+  WRITE = 15,
+  COPY = 16
+};
+
+/**
+ * @brief Size of the fixed part of a TREE record.
+ * @details A TREE reply lists the requested directory and everything below
+ *          it as a binary stream of records, parents before children:
+ *          - 1 byte FAT attributes
+ *          - 4 bytes big-endian file size (0 for directories)
+ *          - 2 bytes big-endian FAT date, 2 bytes big-endian FAT time
+ *          - 2 bytes big-endian path length, then the '/' separated path
+ *            relative to the requested directory
+ *
+ *          Records may span reply packets; the stream ends with an empty OK
+ *          packet, like a LIST reply.
+ */
+constexpr std::size_t REMOTE_IO_TREE_RECORD_HEADER_SIZE = 11;
+
+/**
+ * @brief FAT attribute bit of directories in TREE records.
+ */
+constexpr uint8_t REMOTE_IO_ATTR_DIRECTORY = 0x10;
+
+/**
+ * @brief FAT attribute bit of files in TREE records.
+ */
+constexpr uint8_t REMOTE_IO_ATTR_ARCHIVE = 0x20;
+
+/**
+ * @brief Size of an OK reply to HASH.
+ * @details 4 bytes big-endian file size followed by the SHA-1 digest of the
+ *          file contents (see sha1.hpp). Hashing a large file takes longer
+ *          than the host reply timeout, so the final reply may be preceded by
+ *          progress packets (see REMOTE_IO_HASH_PROGRESS_SIZE).
+ */
+constexpr std::size_t REMOTE_IO_HASH_REPLY_SIZE = 4 + 20;
+
+/**
+ * @brief Size of a HASH progress packet.
+ * @details An OK packet holding the big-endian number of bytes hashed so far,
+ *          flagged REMOTE_IO_FLAG_MORE when replies are framed. The device
+ *          sends one at least every REMOTE_IO_HASH_PROGRESS_BYTES; each one
+ *          restarts the host reply timeout.
+ */
+constexpr std::size_t REMOTE_IO_HASH_PROGRESS_SIZE = 4;
+
+/**
+ * @brief Bytes hashed between two HASH progress packets.
+ */
+constexpr std::size_t REMOTE_IO_HASH_PROGRESS_BYTES = 256 * 1024;
+
+/**
+ * @brief Block size of BLOCK_SUMS signatures and PATCH copy operations.
+ * @details A BLOCK_SUMS reply describes an existing file as a stream of
+ *          4 bytes big-endian file size followed by one REMOTE_IO_BLOCK_SUM_SIZE
+ *          record per complete block: the big-endian RemoteIoWeakSum() of the
+ *          block, then the first REMOTE_IO_BLOCK_STRONG_SIZE bytes of its SHA-1
+ *          digest. The stream spans packets like a TREE reply.
+ */
+constexpr std::size_t REMOTE_IO_DELTA_BLOCK_SIZE = 512;
+
+/**
+ * @brief Size of the strong checksum in a BLOCK_SUMS record.
+ */
+constexpr std::size_t REMOTE_IO_BLOCK_STRONG_SIZE = 8;
+
+/**
+ * @brief Size of one BLOCK_SUMS record.
+ */
+constexpr std::size_t REMOTE_IO_BLOCK_SUM_SIZE = 4 + REMOTE_IO_BLOCK_STRONG_SIZE;
+
+/**
+ * @brief Size of the header of a PATCH data phase.
+ * @details After an OK reply to PATCH the host sends 4 bytes big-endian new
+ *          file size, the 20-byte SHA-1 digest of the new contents and
+ *          4 bytes big-endian script length, then the script and its CRC-8.
+ *          The script is a sequence of operations building the new file
+ *          front to back:
+ *          - REMOTE_IO_PATCH_COPY, 4 bytes first block, 4 bytes block count:
+ *            copy blocks of the current file;
+ *          - REMOTE_IO_PATCH_DATA, 4 bytes length, then the bytes.
+ *
+ *          The device builds the new file separately and replaces the old one
+ *          only if size and digest match; it answers with one byte, 0 on
+ *          success, like an UPLOAD.
+ */
+constexpr std::size_t REMOTE_IO_PATCH_HEADER_SIZE = 4 + 20 + 4;
+
+/**
+ * @brief PATCH operation copying blocks of the current file.
+ */
+constexpr uint8_t REMOTE_IO_PATCH_COPY = 1;
+
+/**
+ * @brief PATCH operation carrying literal bytes.
+ */
+constexpr uint8_t REMOTE_IO_PATCH_DATA = 2;
+
+/**
+ * @brief Weak checksum of a BLOCK_SUMS record (the rsync rolling checksum).
+ * @details With a the sum of the bytes and b the sum of the running values of
+ *          a, both modulo 2^16, the checksum is (b << 16) | a. Both halves can
+ *          be rolled one byte forward in constant time, which lets the host
+ *          find blocks of the old file at any offset of the new one.
+ */
+inline uint32_t RemoteIoWeakSum(const uint8_t* data, std::size_t size)
+{
+  uint32_t a = 0;
+  uint32_t b = 0;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    a += data[i];
+    b += a;
+  }
+  return ((b & 0xFFFF) << 16) | (a & 0xFFFF);
+}
+
+/**
+ * @brief Largest data chunk of a READ or WRITE request.
+ * @details Chunked transfers address file data by offset, so an interrupted
+ *          transfer can continue from the last acknowledged chunk:
+ *          - READ: 4 bytes big-endian offset, 4 bytes big-endian length, then
+ *            the path. The OK reply is the 4-byte big-endian file size, the
+ *            data at offset (short at end of file) and its CRC-8. A zero
+ *            length only returns the size.
+ *          - WRITE: 4 bytes big-endian offset, 2 bytes big-endian path length,
+ *            the path, the data and its CRC-8. Offset 0 creates or truncates
+ *            the file; any other offset must be the current file size, as the
+ *            FAT layer can only append. The reply carries the 4-byte
+ *            big-endian file size: with OK once the data is written, with ERR
+ *            if the offset or CRC was rejected and nothing was written.
+ *
+ *          Both fit in one packet and may be pipelined as tagged requests.
+ */
+constexpr std::size_t REMOTE_IO_CHUNK_SIZE = 32 * 1024;
+
+/**
+ * @brief Largest number of bytes copied by one COPY request.
+ * @details COPY duplicates a file on the card without sending it over the
+ *          link. The request is 4 bytes big-endian offset, then the source
+ *          path, a NUL byte and the destination path. The device appends the
+ *          source bytes from offset on, at most REMOTE_IO_COPY_STEP of them,
+ *          to the destination. Offset 0 creates or truncates the destination;
+ *          any other offset must be its current size. The OK reply is the
+ *          4-byte big-endian source size and the 4-byte big-endian number of
+ *          bytes copied; the host repeats the request from the next offset
+ *          until the whole file is copied, so no request outlasts the reply
+ *          timeout. Devices without COPY reply UNSUPPORTED.
+ */
+constexpr std::size_t REMOTE_IO_COPY_STEP = 1024 * 1024;
+
+/**
+ * @brief SRL1 reply status codes.
+ */
+enum class RemoteIoStatus : uint8_t
+{
+  OK = 0,
+  ERR = 1,
+  UNSUPPORTED = 2,
+  BAD_REQUEST = 3
+};
+
+} // namespace xfer
@@ -44,4 +44,29 @@ constexpr std::size_t bios_size = 524288;
  */
 constexpr uint32_t bios_address = 0x00000000;
 
+/**
+ * @brief Sega Saturn low work RAM address.
+ */
+constexpr uint32_t work_ram_low_address = 0x00200000;
+
+/**
+ * @brief Sega Saturn low work RAM size in bytes.
+ */
+constexpr std::size_t work_ram_low_size = 1048576;
+
+/**
+ * @brief Sega Saturn high work RAM address.
+ */
+constexpr uint32_t work_ram_high_address = 0x06000000;
+
+/**
+ * @brief Sega Saturn high work RAM size in bytes.
+ */
+constexpr std::size_t work_ram_high_size = 1048576;
+
+/**
+ * @brief SH-2 address bit selecting the cache-through mirror of an area.
+ */
+constexpr uint32_t cache_through_bit = 0x20000000;
+
 } // namespace saturn
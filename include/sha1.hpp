@@ -0,0 +1,82 @@
+/**
+ * @file sha1.hpp
+ * @brief SHA-1 message digest.
+ * @details Used to detect changed files during SD card synchronization. The
+ *          cartridge answers the remote-IO HASH command with the same digest,
+ *          so host and card contents can be compared without transferring
+ *          them.
+ */
+
+#ifndef SHA1_HPP
+#define SHA1_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @namespace sha1
+ * @brief SHA-1 digest operations.
+ */
+namespace sha1 {
+
+/**
+ * @brief Size of a SHA-1 digest in bytes.
+ */
+constexpr std::size_t kDigestSize = 20;
+
+/**
+ * @typedef std::array<uint8_t, kDigestSize> digest_t
+ * @brief SHA-1 digest value.
+ */
+using digest_t = std::array<uint8_t, kDigestSize>;
+
+/**
+ * @brief Incremental SHA-1 computation.
+ */
+class Hasher {
+public:
+    Hasher() noexcept;
+
+    /**
+     * @brief Add a block of data to the digest.
+     * @param data Pointer to input data buffer.
+     * @param data_len Number of bytes in data buffer.
+     */
+    void update(const unsigned char* data, std::size_t data_len) noexcept;
+
+    /**
+     * @brief Pad the message and return its digest.
+     * @note The hasher must not be updated afterwards.
+     */
+    digest_t finish() noexcept;
+
+private:
+    void compress(const unsigned char* block) noexcept;
+
+    uint32_t state_[5];
+    uint64_t length_ = 0;
+    unsigned char block_[64];
+    std::size_t block_used_ = 0;
+};
+
+/**
+ * @brief Digest of a complete buffer.
+ */
+digest_t hash(const unsigned char* data, std::size_t data_len) noexcept;
+
+/**
+ * @brief Lowercase hexadecimal form of a digest.
+ */
+std::string to_hex(const digest_t& digest);
+
+/**
+ * @brief Parse the form written by to_hex().
+ * @return true if @p hex holds exactly kDigestSize hexadecimal byte pairs.
+ */
+bool from_hex(const std::string& hex, digest_t& digest) noexcept;
+
+} // namespace sha1
+
+#endif // SHA1_HPP
@@ -0,0 +1,105 @@
+/**
+ * @file transport.hpp
+ * @brief Byte-stream link between the host and the Saturn cartridge.
+ * @details Every protocol module (xfer, console, GDB proxy, WebDAV) talks to
+ *          the cartridge through the active Transport instead of the global
+ *          FTDI context. Two backends exist:
+ *          - the FTDI backend, driving the USB dev cart through libftdi;
+ *          - the cartridge emulator (see emulator.hpp), an in-process model
+ *            of the cartridge firmware used for tests and benchmarks on
+ *            machines without hardware.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @namespace transport
+ * @brief Host <-> cartridge link abstraction.
+ */
+namespace transport {
+
+/**
+ * @brief Abstract bidirectional byte link to the cartridge.
+ * @details One thread may read while another writes (the GDB proxy reads
+ *          on a thread of its own); Purge() waits for both.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Short backend name used in log messages (e.g. "ftdi").
+     */
+    virtual const char* Name() const = 0;
+
+    /**
+     * @brief Write all bytes to the cartridge.
+     * @param data Bytes to send; must stay valid until the call returns.
+     * @param size Number of bytes to send.
+     * @return true if every byte was accepted, false on error or interrupt.
+     */
+    virtual bool Write(const unsigned char* data, std::size_t size) = 0;
+
+    /**
+     * @brief Read exactly @p size bytes from the cartridge.
+     * @param data Destination buffer.
+     * @param size Number of bytes to read.
+     * @param idle_timeout_ms Give up after this many milliseconds without progress.
+     * @return Number of bytes read (less than @p size on timeout or
+     *         interrupt), or -1 on a link error.
+     */
+    virtual long Read(unsigned char* data, std::size_t size, int idle_timeout_ms) = 0;
+
+    /**
+     * @brief Read whatever the cartridge has sent so far.
+     * @details May block for about one USB latency period when nothing is
+     *          pending. Used by the streaming console and GDB proxy loops.
+     * @param data Destination buffer.
+     * @param size Capacity of @p data.
+     * @return Number of bytes read (0 if none were pending), or -1 on error.
+     */
+    virtual int ReadSome(unsigned char* data, std::size_t size) = 0;
+
+    /**
+     * @brief Discard any data buffered in either direction.
+     * @return true on success.
+     */
+    virtual bool Purge() = 0;
+
+    /**
+     * @brief Human-readable description of the last link error.
+     */
+    virtual std::string LastError() const = 0;
+};
+
+/**
+ * @brief Access the transport selected for this process.
+ * @details Defaults to the FTDI backend when nothing was installed.
+ * @return Reference to the active transport.
+ */
+Transport& Active();
+
+/**
+ * @brief Install the transport used by all protocol modules.
+ * @param link New transport (ownership is taken).
+ */
+void SetActive(std::unique_ptr<Transport> link);
+
+/**
+ * @brief Create the libftdi-backed transport for the already opened ftdi::g_Device.
+ */
+std::unique_ptr<Transport> MakeFtdiTransport();
+
+/**
+ * @brief Create a transport bound to an in-process cartridge emulator.
+ * @param sd_seed_dir Optional host folder copied into the emulated SD card
+ *                    (empty string for a blank card).
+ * @return The transport, or nullptr if the seed folder could not be loaded.
+ */
+std::unique_ptr<Transport> MakeEmulatorTransport(const std::string& sd_seed_dir);
+
+} // namespace transport
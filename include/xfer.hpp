@@ -40,6 +40,10 @@
 #include <ftdi.h>
 #include <string>
 #include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "remote_io.hpp"
 
 /**
  * @namespace xfer
@@ -128,6 +132,67 @@ int DoRmdir(const char *path);
  */
 int DoCrc(const char *filename);
 
+/**
+ * @brief Number of requests sent so far that can change the SD card contents.
+ * @details Removes, directory changes, renames, uploads, patches, chunked writes
+ *          and raw sector uploads all count, whichever call sends them. Code
+ *          caching card contents compares it to notice they may be stale.
+ * @return Request count, wrapping around.
+ */
+uint32_t SdModificationCount();
+
+/**
+ * @brief One request of a DoRemoteIoBatch() call.
+ */
+struct RemoteIoBatchItem
+{
+  RemoteIoCommand command = RemoteIoCommand::LIST; ///< LIST, TREE, REMOVE, CRC, MKDIR, RMDIR or RENAME
+  std::string argument;  ///< Request payload (RENAME: old path, '\0', new path)
+  RemoteIoStatus status = RemoteIoStatus::ERR; ///< Reply status
+  std::string reply;     ///< Reply payload; LIST and TREE collect every packet
+};
+
+/**
+ * @brief Run several SD card requests with as few round trips as possible.
+ * @details Keeps up to the device pipeline depth of tagged requests in flight
+ *          and matches the replies by request ID. Devices without tagged
+ *          request support get the requests one at a time. Requests are
+ *          executed in order, so a MKDIR may be followed by a request inside
+ *          the new directory. Nothing is printed for non-OK replies.
+ * @param items Requests in; status and reply payload out.
+ * @return 1 if every request got a reply, 0 on link or protocol error.
+ */
+int DoRemoteIoBatch(std::vector<RemoteIoBatchItem> &items);
+
+/**
+ * @brief One file or directory of an SD card subtree.
+ */
+struct SdTreeEntry
+{
+  std::string path;        ///< Path relative to the listed directory
+  bool is_dir = false;     ///< True for directories
+  uint32_t size = 0;       ///< File size (0 for directories)
+  uint16_t fat_date = 0;   ///< FAT date: year-1980 << 9 | month << 5 | day
+  uint16_t fat_time = 0;   ///< FAT time: hours << 11 | minutes << 5 | seconds / 2
+  uint8_t attributes = 0;  ///< FAT attribute bits
+};
+
+/**
+ * @brief Decode the record stream of a TREE reply.
+ * @param stream Concatenated reply payloads.
+ * @param entries Decoded entries, appended in stream order.
+ * @return true if the stream holds only complete records.
+ */
+bool DecodeSdTree(const std::string &stream, std::vector<SdTreeEntry> &entries);
+
+/**
+ * @brief List a directory and everything below it with one request.
+ * @param path Directory on the target.
+ * @param entries Subtree entries, parents before children.
+ * @return 1 on success, 0 on error, -1 if the device lacks the TREE command.
+ */
+int DoListTree(const char *path, std::vector<SdTreeEntry> &entries);
+
 /**
  * @brief Download data from device and write to file.
  * @param filename Output file name.
@@ -147,20 +212,133 @@ int DoDownload(const char* filename, uint32_t address, std::size_t size);
 int DoUpload(const char* filename, uint32_t address, const bool execute = false);
 
 /**
- * @brief Copy a local file to a raw SD card range.
+ * @brief Upload a memory buffer to the device with USBDC_FUNC_UPLOAD.
+ * @param address Device address to write to.
+ * @param data Bytes to write.
+ * @param size Number of bytes.
+ * @return 1 on success, 0 on error.
+ */
+int DoUploadBuffer(uint32_t address, const unsigned char* data, std::size_t size);
+
+/**
+ * @brief Upload an LZF-compressed image and expand it on the cartridge.
+ * @details The file is compressed on all host cores, uploaded with the
+ *          decompressor stub and expanded in place by the stub (see
+ *          lzf_upload.hpp). Images that do not compress fall back to
+ *          DoUpload().
+ * @param filename Input file name.
+ * @param address Destination address of the expanded image.
+ * @param decompressor Decompressor stub binary built for LZF_UPLOAD_STUB_ADDRESS.
+ * @param execute If true, the stub jumps to @p address once done.
+ * @return 1 on success, 0 on error.
+ */
+int DoCompressedUpload(const char* filename, uint32_t address, const char* decompressor, const bool execute = false);
+
+/**
+ * @brief Copy a local file to a raw SD card range or the SD card FAT filesystem.
+ * @details FAT uploads go out in CRC-checked RemoteIoCommand::WRITE chunks
+ *          when the firmware supports them; a glitch only costs the chunks
+ *          that were not acknowledged.
  * @param host_filename Input file name.
- * @param saturn_sd_path Raw SD target path, typically sdraw:\<start\>:\<count\>.
+ * @param saturn_sd_path Raw SD target path, typically sdraw:\<start\>:\<count\>,
+ *        or an absolute FAT path.
+ * @param resume Continue an interrupted upload of the same file, tracked in
+ *        \<host_filename\>.ftxpart until it completes.
  * @return 1 on success, 0 on error.
  */
-int DoSdUpload(const char *host_filename, const char *saturn_sd_path);
+int DoSdUpload(const char *host_filename, const char *saturn_sd_path, bool resume = false);
+
+/**
+ * @brief Update a file on the SD card FAT filesystem by sending only what changed.
+ * @details The card returns per-block weak and strong checksums of its copy
+ *          (RemoteIoCommand::BLOCK_SUMS); the host matches them against the
+ *          local file and sends a PATCH script of block copies and literal
+ *          data (see remote_io.hpp). Falls back to DoSdUpload() for raw SD
+ *          targets, files not yet on the card, firmware without delta support
+ *          and files that share nothing with the card copy.
+ * @param host_filename Input file name.
+ * @param saturn_sd_path Target path on the SD card FAT filesystem.
+ * @return 1 on success, 0 on error.
+ */
+int DoSdDeltaUpload(const char *host_filename, const char *saturn_sd_path);
 
 /**
  * @brief Download a file from the Saturn SD card to a local file.
  * @param saturn_sd_path Source path on the SD card FAT filesystem.
  * @param host_filename Target local file name.
+ * @param resume Continue an interrupted download into @p host_filename,
+ *        tracked in \<host_filename\>.ftxpart until it completes.
+ * @return 1 on success, 0 on error.
+ */
+int DoSdDownload(const char *saturn_sd_path, const char *host_filename, bool resume = false);
+
+/**
+ * @brief Pulls the data of a streamed upload.
+ * @details Fills up to @p size bytes at @p data and returns how many were
+ *          stored, 0 at the end of the data or -1 on error.
+ */
+using SdUploadSource = std::function<long(uint8_t* data, std::size_t size)>;
+
+/**
+ * @brief Receives the data of a streamed download in file order.
+ * @return false to abort the transfer.
+ */
+using SdDownloadSink = std::function<bool(const uint8_t* data, std::size_t size)>;
+
+/**
+ * @brief Told the size of a streamed download before any data reaches the sink.
+ * @return false to abort the transfer.
+ */
+using SdSizeCallback = std::function<bool(uint32_t size)>;
+
+/**
+ * @brief Upload a stream to the SD card FAT filesystem without staging it in a file.
+ * @details Only the last batch of chunks is held in memory. Firmware without
+ *          chunked transfers needs the size up front.
+ * @param saturn_sd_path Target path on the SD card FAT filesystem.
+ * @param source Data source, read until it reports the end of the data.
+ * @param size Number of bytes @p source delivers, or -1 if unknown.
+ * @return 1 on success, 0 on error.
+ */
+int DoSdUploadStream(const char *saturn_sd_path, const SdUploadSource &source, int64_t size = -1);
+
+/**
+ * @brief Download a file from the SD card into a sink without staging it in a file.
+ * @details Chunked transfers only pass CRC-checked data to @p sink. With older
+ *          firmware the CRC-8 covers the whole file and is checked after the
+ *          last byte reached @p sink.
+ * @param saturn_sd_path Source path on the SD card FAT filesystem.
+ * @param on_size Called with the file size first; may be empty.
+ * @param sink Data sink.
+ * @return 1 on success, 0 on error.
+ */
+int DoSdDownloadStream(const char *saturn_sd_path, const SdSizeCallback &on_size, const SdDownloadSink &sink);
+
+/**
+ * @brief Download part of a file from the SD card into a sink.
+ * @details Firmware with chunked transfers reads only the requested bytes;
+ *          older firmware streams the whole file and the other bytes are
+ *          dropped on the host.
+ * @param saturn_sd_path Source path on the SD card FAT filesystem.
+ * @param offset First byte to download.
+ * @param length Number of bytes; fewer reach @p sink if the file ends first.
+ * @param on_size Called with the whole file size first; may be empty.
+ * @param sink Data sink.
+ * @return 1 on success, 0 on error.
+ */
+int DoSdDownloadRange(const char *saturn_sd_path, uint32_t offset, uint32_t length,
+                      const SdSizeCallback &on_size, const SdDownloadSink &sink);
+
+/**
+ * @brief Copy a file to another path on the SD card.
+ * @details The cartridge copies the data itself with COPY requests, so nothing
+ *          crosses the link. Firmware without COPY gets the file downloaded to a
+ *          temporary host file and uploaded again.
+ * @param saturn_source Existing file on the SD card.
+ * @param saturn_target Destination path, created or replaced.
  * @return 1 on success, 0 on error.
  */
-int DoSdDownload(const char *saturn_sd_path, const char *host_filename);
+int DoSdCopy(const char *saturn_source, const char *saturn_target);
 
 /**
  * @brief Synchronize a local directory with a Sega Saturn SD card directory recursively.
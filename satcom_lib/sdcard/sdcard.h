@@ -264,6 +264,16 @@ sdc_ret_t sdc_fat_write_file(char* filename, unsigned long length, unsigned char
 **/
 sdc_ret_t sdc_fat_append_file(char* filename, unsigned long length, unsigned char* buffer, unsigned long* write_length);
 
+/**
+ * Copy part of a file to the end of another one, on the SD card only.
+ * Copies at most length bytes of src from offset on, through buffer.
+ * Offset 0 creates or truncates dst; any other offset must be its size.
+ *
+ * Return SDC_OK when successed, with the number of bytes copied in
+ * copy_length (less than length at end of src).
+**/
+sdc_ret_t sdc_fat_copy_file(char* src, char* dst, unsigned long offset, unsigned long length, unsigned char* buffer, unsigned long buffer_size, unsigned long* copy_length);
+
 /**
  * Create specified directory.
  *
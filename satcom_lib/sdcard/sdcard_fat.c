@@ -271,6 +271,94 @@ sdc_ret_t sdc_fat_append_file(char* filename, unsigned long length, unsigned cha
     return SDC_OK;
 }
 
+sdc_ret_t sdc_fat_copy_file(char* src, char* dst, unsigned long offset, unsigned long length, unsigned char* buffer, unsigned long buffer_size, unsigned long* copy_length)
+{
+    sdcard_t* sd = sc_get_sdcard_buff();
+    FL_FILE *in;
+    FL_FILE *out;
+    unsigned long dst_size;
+    unsigned long copied = 0;
+    int got;
+
+    if(copy_length)
+    {
+        *copy_length = 0;
+    }
+
+    /* Verify if need to reinitialize SPI & FAT library. */
+    if((!sd->init_ok) || (sdc_is_reinsert()))
+    {
+        sdc_fat_init();
+    }
+
+    /* Can't use SD card ? */
+    if(!sd->init_ok)
+    {
+        return SDC_FAILURE;
+    }
+
+    /* FAT library can only append : continue where the previous step ended. */
+    if(offset != 0)
+    {
+        if((sdc_fat_file_size(dst, &dst_size) != SDC_OK) || (dst_size != offset))
+        {
+            sdc_logout("sdc_fat_copy_file destination size mismatch (offset=%d) !", offset);
+            return SDC_FATERROR;
+        }
+    }
+
+    in = fl_fopen(src, "rb");
+    if(!in)
+    {
+        sdc_logout("sdc_fat_copy_file fl_fopen failure (%s) !", src);
+        return SDC_NOFILE;
+    }
+    if(fl_fseek(in, offset, SEEK_SET) != 0)
+    {
+        sdc_logout("sdc_fat_copy_file fl_fseek failure !", 0);
+        fl_fclose(in);
+        return SDC_FATERROR;
+    }
+
+    out = fl_fopen(dst, (offset == 0) ? "wb" : "ab");
+    if(!out)
+    {
+        sdc_logout("sdc_fat_copy_file fl_fopen failure (%s) !", dst);
+        fl_fclose(in);
+        return SDC_NOFILE;
+    }
+
+    while(copied < length)
+    {
+        got = fl_fread(buffer, 1, (int)(((length - copied) < buffer_size) ? (length - copied) : buffer_size), in);
+        if(got <= 0)
+        {
+            /* End of source file. */
+            break;
+        }
+        if(fl_fwrite(buffer, 1, got, out) != got)
+        {
+            sdc_logout("sdc_fat_copy_file fl_fwrite failure (copied=%d) !", copied);
+            fl_fclose(out);
+            fl_fclose(in);
+            return SDC_FATERROR;
+        }
+        copied += got;
+    }
+
+    if(copy_length)
+    {
+        *copy_length = copied;
+    }
+
+    sdc_logout("sdc_fat_copy_file OK, length = %d", copied);
+
+    fl_fclose(out);
+    fl_fclose(in);
+
+    return SDC_OK;
+}
+
 sdc_ret_t sdc_fat_mkdir(char* directory)
 {
     sdcard_t* sd = sc_get_sdcard_buff();
@@ -29,6 +29,10 @@
 
 #include "crc.hpp"
 
+#if FTX_CRC8_HAVE_CLMUL
+#include <immintrin.h>
+#endif
+
 namespace crc8 {
 
 /**
@@ -54,9 +58,31 @@ static const crc_t crc_table[256] = {
 };
 
 /**
- * @copydoc crc8::crc_update
+ * @brief Slicing-by-8 tables: slice_table[k][x] is the CRC of byte x followed by k zero bytes.
  */
-crc_t crc_update(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept {
+struct SliceTables {
+    crc_t t[8][256];
+
+    SliceTables() noexcept {
+        for (unsigned int x = 0; x < 256; ++x) {
+            t[0][x] = crc_table[x];
+        }
+        for (unsigned int k = 1; k < 8; ++k) {
+            for (unsigned int x = 0; x < 256; ++x) {
+                t[k][x] = crc_table[t[k - 1][x]];
+            }
+        }
+    }
+};
+
+static const SliceTables slice_tables;
+
+namespace detail {
+
+/**
+ * @copydoc crc8::detail::crc_update_bytewise
+ */
+crc_t crc_update_bytewise(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept {
     unsigned int tbl_idx;
     while (data_len--) {
         tbl_idx = ((crc >> 0) ^ *data) & 0xff;
@@ -66,4 +92,105 @@ crc_t crc_update(crc_t crc, const unsigned char* data, std::size_t data_len) noe
     return crc & 0xff;
 }
 
+/**
+ * @copydoc crc8::detail::crc_update_slice8
+ */
+crc_t crc_update_slice8(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept {
+    const auto& t = slice_tables.t;
+    while (data_len >= 8) {
+        crc = t[7][crc ^ data[0]] ^ t[6][data[1]] ^ t[5][data[2]] ^ t[4][data[3]] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        data_len -= 8;
+    }
+    return crc_update_bytewise(crc, data, data_len);
+}
+
+#if FTX_CRC8_HAVE_CLMUL
+
+/**
+ * @copydoc crc8::detail::crc_update_clmul
+ * @details The message is treated as one big-endian polynomial M(x), so the
+ *          register value equals (crc * x^(8n) + M(x) * x^8) mod P(x) with
+ *          P(x) = x^8 + x^2 + x + 1. A 128-bit accumulator is folded over
+ *          each following 16-byte block using x^192 and x^128 mod P; the
+ *          final accumulator and the sub-block tail go through the table.
+ */
+__attribute__((target("pclmul,ssse3")))
+crc_t crc_update_clmul(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept {
+    if (data_len < 32) {
+        return crc_update_slice8(crc, data, data_len);
+    }
+
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i fold_k = _mm_set_epi64x(0x26 /* x^192 mod P */, 0x02 /* x^128 mod P */);
+
+    // Seed: the running CRC is XORed into the first message byte (bits 127..120).
+    __m128i acc = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), bswap);
+    acc = _mm_xor_si128(acc, _mm_set_epi64x(static_cast<long long>(static_cast<uint64_t>(crc) << 56), 0));
+    data += 16;
+    data_len -= 16;
+
+    while (data_len >= 16) {
+        const __m128i block = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), bswap);
+        const __m128i hi = _mm_clmulepi64_si128(acc, fold_k, 0x11);
+        const __m128i lo = _mm_clmulepi64_si128(acc, fold_k, 0x00);
+        acc = _mm_xor_si128(_mm_xor_si128(hi, lo), block);
+        data += 16;
+        data_len -= 16;
+    }
+
+    alignas(16) unsigned char folded[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(folded), _mm_shuffle_epi8(acc, bswap));
+    crc = crc_update_slice8(0, folded, sizeof(folded));
+    return crc_update_slice8(crc, data, data_len);
+}
+
+#endif // FTX_CRC8_HAVE_CLMUL
+
+} // namespace detail
+
+namespace {
+
+using kernel_fn = crc_t (*)(crc_t, const unsigned char*, std::size_t) noexcept;
+
+struct Kernel {
+    kernel_fn fn;
+    const char* name;
+};
+
+/**
+ * @brief Pick the fastest kernel supported by the running CPU.
+ */
+Kernel select_kernel() noexcept {
+#if FTX_CRC8_HAVE_CLMUL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+        return {detail::crc_update_clmul, "pclmul"};
+    }
+#endif
+    return {detail::crc_update_slice8, "slice8"};
+}
+
+const Kernel& active_kernel() noexcept {
+    static const Kernel kernel = select_kernel();
+    return kernel;
+}
+
+} // namespace
+
+/**
+ * @copydoc crc8::crc_update
+ */
+crc_t crc_update(crc_t crc, const unsigned char* data, std::size_t data_len) noexcept {
+    return active_kernel().fn(crc, data, data_len);
+}
+
+/**
+ * @copydoc crc8::kernel_name
+ */
+const char* kernel_name() noexcept {
+    return active_kernel().name;
+}
+
 } // namespace crc8
@@ -0,0 +1,1378 @@
+/**
+ * @file emulator.cpp
+ * @brief Cartridge firmware emulator and its transport binding.
+ * @details See emulator.hpp for the protocol coverage. Requests are parsed
+ *          incrementally, so the host may split its writes at any byte
+ *          boundary exactly as USB bulk transfers do.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+
+#include "crc.hpp"
+#include "emulator.hpp"
+#include "ftdi.hpp"
+#include "log.hpp"
+#include "lzf_upload.hpp"
+#include "remote_io.hpp"
+#include "sha1.hpp"
+#include "transport.hpp"
+
+// satcom_lib headers are C (sc_common.h pulls in sc_compress.h).
+extern "C" {
+#include "sc_common.h"
+#include "sc_compress.h"
+}
+
+namespace emu {
+
+namespace {
+
+constexpr uint32_t kRamPageSize = 0x10000;
+constexpr uint32_t kSdSectorSize = 512;
+/// Exec buffer reported by USBDC_FUNC_GET_BUFF_ADDR (low work RAM).
+constexpr uint32_t kExecBufferAddress = 0x00200000;
+/// Listing packet size, mimicking the firmware's small reply buffer.
+constexpr std::size_t kListPacketSize = 512;
+
+// Tagged SRL2 requests the modelled firmware buffers
+constexpr uint8_t kRemoteIoPipelineDepth = 8;
+
+uint32_t ReadBe32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+std::string Be32String(uint32_t value)
+{
+    return {static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8),
+            static_cast<char>(value)};
+}
+
+} // namespace
+
+CartEmulator::CartEmulator()
+{
+    SdNode root;
+    root.is_dir = true;
+    root.mtime = std::time(nullptr);
+    sd_["/"] = root;
+}
+
+/**
+ * @copydoc emu::CartEmulator::LoadSdFromDirectory
+ */
+bool CartEmulator::LoadSdFromDirectory(const std::string& dir)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    const fs::path base(dir);
+    if (!fs::is_directory(base, ec))
+    {
+        std::cerr << "[Emulator] SD seed folder not found: " << dir << std::endl;
+        return false;
+    }
+
+    for (fs::recursive_directory_iterator it(base, ec), end; it != end && !ec; it.increment(ec))
+    {
+        const std::string rel = "/" + fs::relative(it->path(), base, ec).generic_string();
+        if (it->is_directory(ec))
+        {
+            MakeDir(rel);
+            continue;
+        }
+
+        std::ifstream file(it->path(), std::ios::binary);
+        std::vector<uint8_t> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        WriteSdFile(rel, contents);
+    }
+    cdbg << "[Emulator] Loaded SD image from '" << dir << "' (" << sd_.size() << " entries)" << std::endl;
+    return !ec;
+}
+
+/**
+ * @copydoc emu::CartEmulator::Feed
+ */
+void CartEmulator::Feed(const unsigned char* data, std::size_t size)
+{
+    in_.insert(in_.end(), data, data + size);
+    bytes_received_ += size;
+    while (Step())
+    {
+    }
+
+    // Compact the input buffer once everything parsed so far is consumed.
+    if (in_pos_ == in_.size())
+    {
+        in_.clear();
+        in_pos_ = 0;
+    }
+    else if (in_pos_ > kRamPageSize)
+    {
+        in_.erase(in_.begin(), in_.begin() + static_cast<std::ptrdiff_t>(in_pos_));
+        in_pos_ = 0;
+    }
+}
+
+/**
+ * @copydoc emu::CartEmulator::Drain
+ */
+std::size_t CartEmulator::Drain(unsigned char* out, std::size_t max)
+{
+    const std::size_t n = std::min(max, Pending());
+    if (n > 0)
+    {
+        std::memcpy(out, out_.data() + out_pos_, n);
+        out_pos_ += n;
+    }
+    if (out_pos_ == out_.size())
+    {
+        out_.clear();
+        out_pos_ = 0;
+    }
+    return n;
+}
+
+/**
+ * @copydoc emu::CartEmulator::ResetLink
+ */
+void CartEmulator::ResetLink()
+{
+    in_.clear();
+    in_pos_ = 0;
+    out_.clear();
+    out_pos_ = 0;
+    sink_ = Sink::NONE;
+    sink_buffer_.clear();
+}
+
+/**
+ * @copydoc emu::CartEmulator::ReadRam
+ */
+std::vector<uint8_t> CartEmulator::ReadRam(uint32_t address, std::size_t size) const
+{
+    std::vector<uint8_t> result(size, 0);
+    std::size_t done = 0;
+    while (done < size)
+    {
+        const uint32_t addr = address + static_cast<uint32_t>(done);
+        const uint32_t offset = addr % kRamPageSize;
+        const std::size_t chunk = std::min<std::size_t>(kRamPageSize - offset, size - done);
+        auto it = ram_pages_.find(addr / kRamPageSize);
+        if (it != ram_pages_.end())
+        {
+            std::memcpy(result.data() + done, it->second.data() + offset, chunk);
+        }
+        done += chunk;
+    }
+    return result;
+}
+
+/**
+ * @copydoc emu::CartEmulator::WriteRam
+ */
+void CartEmulator::WriteRam(uint32_t address, const uint8_t* data, std::size_t size)
+{
+    std::size_t done = 0;
+    while (done < size)
+    {
+        const uint32_t addr = address + static_cast<uint32_t>(done);
+        const uint32_t offset = addr % kRamPageSize;
+        const std::size_t chunk = std::min<std::size_t>(kRamPageSize - offset, size - done);
+        std::vector<uint8_t>& page = ram_pages_[addr / kRamPageSize];
+        if (page.empty())
+        {
+            page.assign(kRamPageSize, 0);
+        }
+        std::memcpy(page.data() + offset, data + done, chunk);
+        done += chunk;
+    }
+}
+
+/**
+ * @copydoc emu::CartEmulator::FindSd
+ */
+const SdNode* CartEmulator::FindSd(const std::string& path) const
+{
+    auto it = sd_.find(NormalizeKey(path));
+    return it != sd_.end() ? &it->second : nullptr;
+}
+
+/**
+ * @copydoc emu::CartEmulator::WriteSdFile
+ */
+bool CartEmulator::WriteSdFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    const std::string key = NormalizeKey(path);
+    if (key == "/")
+    {
+        return false;
+    }
+    auto parent = sd_.find(ParentKey(key));
+    if (parent == sd_.end() || !parent->second.is_dir)
+    {
+        return false;
+    }
+
+    SdNode& node = sd_[key];
+    if (node.is_dir)
+    {
+        return false;
+    }
+    if (node.name.empty())
+    {
+        node.name = BaseName(path);
+    }
+    node.data = data;
+    node.mtime = std::time(nullptr);
+    return true;
+}
+
+/**
+ * @brief Process one request or data slice from the input buffer.
+ * @return true if input was consumed and parsing should continue.
+ */
+bool CartEmulator::Step()
+{
+    return (sink_ == Sink::NONE) ? StepCommand() : StepSink();
+}
+
+/**
+ * @brief Parse and execute one command once all of its header bytes are buffered.
+ */
+bool CartEmulator::StepCommand()
+{
+    const std::size_t avail = in_.size() - in_pos_;
+    if (avail == 0)
+    {
+        return false;
+    }
+    const uint8_t* p = in_.data() + in_pos_;
+
+    // SRL1 remote-IO request
+    if (p[0] == xfer::REMOTE_IO_MAGIC[0])
+    {
+        const std::size_t probe = std::min(avail, sizeof(xfer::REMOTE_IO_MAGIC));
+        if (std::memcmp(p, xfer::REMOTE_IO_MAGIC, probe) == 0)
+        {
+            if (avail < xfer::REMOTE_IO_HEADER_SIZE)
+            {
+                return false;
+            }
+            const std::size_t len = (static_cast<std::size_t>(p[5]) << 8) | p[6];
+            if (avail < xfer::REMOTE_IO_HEADER_SIZE + len)
+            {
+                return false;
+            }
+            const uint8_t command = p[4];
+            const std::string arg(reinterpret_cast<const char*>(p + xfer::REMOTE_IO_HEADER_SIZE), len);
+            in_pos_ += xfer::REMOTE_IO_HEADER_SIZE + len;
+            HandleRemoteIo(command, arg);
+            return true;
+        }
+
+        // Tagged SRL2 request: same handler, replies carry the request ID
+        if (std::memcmp(p, xfer::REMOTE_IO_TAGGED_MAGIC, probe) == 0)
+        {
+            if (avail < xfer::REMOTE_IO_TAGGED_HEADER_SIZE)
+            {
+                return false;
+            }
+            const std::size_t len = (static_cast<std::size_t>(p[7]) << 8) | p[8];
+            if (avail < xfer::REMOTE_IO_TAGGED_HEADER_SIZE + len)
+            {
+                return false;
+            }
+            const uint8_t command = p[4];
+            const uint16_t tag = static_cast<uint16_t>((p[5] << 8) | p[6]);
+            const std::string arg(reinterpret_cast<const char*>(p + xfer::REMOTE_IO_TAGGED_HEADER_SIZE), len);
+            in_pos_ += xfer::REMOTE_IO_TAGGED_HEADER_SIZE + len;
+
+            reply_tag_ = tag;
+            const auto cmd = static_cast<xfer::RemoteIoCommand>(command);
+            if (cmd == xfer::RemoteIoCommand::UPLOAD || cmd == xfer::RemoteIoCommand::DOWNLOAD ||
+                cmd == xfer::RemoteIoCommand::PATCH)
+            {
+                Reply(static_cast<uint8_t>(xfer::RemoteIoStatus::BAD_REQUEST));
+            }
+            else
+            {
+                HandleRemoteIo(command, arg);
+            }
+            reply_tag_ = -1;
+            return true;
+        }
+    }
+
+    switch (p[0])
+    {
+    case USBDC_FUNC_DOWNLOAD:
+    {
+        if (avail < 9)
+        {
+            return false;
+        }
+        const uint32_t address = ReadBe32(p + 1);
+        const uint32_t size = ReadBe32(p + 5);
+        in_pos_ += 9;
+        const std::vector<uint8_t> data = ReadRam(address, size);
+        Emit(data.data(), data.size());
+        EmitByte(crc8::crc_update(0, data.data(), data.size()));
+        return true;
+    }
+
+    case USBDC_FUNC_UPLOAD:
+    case USBDC_FUNC_EXEC_EXT:
+    {
+        const std::size_t header = (p[0] == USBDC_FUNC_EXEC_EXT) ? 13 : 9;
+        if (avail < header)
+        {
+            return false;
+        }
+        sink_ = (p[0] == USBDC_FUNC_EXEC_EXT) ? Sink::EXEC_RAM : Sink::RAM;
+        sink_address_ = ReadBe32(p + 1);
+        sink_start_ = sink_address_;
+        sink_remaining_ = ReadBe32(p + 5);
+        sink_crc_ = 0;
+        in_pos_ += header;
+        return true;
+    }
+
+    case USBDC_FUNC_EXEC:
+        if (avail < 5)
+        {
+            return false;
+        }
+        last_exec_address_ = ReadBe32(p + 1);
+        in_pos_ += 5;
+        cdbg << "[Emulator] Execute at 0x" << std::hex << last_exec_address_ << std::dec << std::endl;
+        if (last_exec_address_ == xfer::LZF_UPLOAD_STUB_ADDRESS)
+        {
+            RunDecompressorStub();
+        }
+        return true;
+
+    case USBDC_FUNC_GET_BUFF_ADDR:
+    {
+        in_pos_ += 1;
+        const uint8_t reply[4] = {
+            static_cast<uint8_t>(kExecBufferAddress >> 24), static_cast<uint8_t>(kExecBufferAddress >> 16),
+            static_cast<uint8_t>(kExecBufferAddress >> 8), static_cast<uint8_t>(kExecBufferAddress)};
+        Emit(reply, sizeof(reply));
+        return true;
+    }
+
+    case USBDC_FUNC_COPYEXEC:
+        if (avail < 13)
+        {
+            return false;
+        }
+        last_exec_address_ = ReadBe32(p + 9);
+        in_pos_ += 13;
+        return true;
+
+    case xfer::SDRAW_UPLOAD_COMMAND:
+    {
+        if (avail < 5)
+        {
+            return false;
+        }
+        const uint32_t name_len = ReadBe32(p + 1);
+        if (avail < 5 + static_cast<std::size_t>(name_len) + 8)
+        {
+            return false;
+        }
+        const uint8_t* tail = p + 5 + name_len;
+        sink_ = Sink::SD_RAW;
+        sink_address_ = ReadBe32(tail);
+        sink_remaining_ = ReadBe32(tail + 4);
+        sink_crc_ = 0;
+        sink_buffer_.clear();
+        in_pos_ += 5 + name_len + 8;
+        return true;
+    }
+
+    default:
+        // The firmware ignores unknown command bytes.
+        in_pos_ += 1;
+        return true;
+    }
+}
+
+/**
+ * @brief Consume the data phase of an upload-style command.
+ */
+bool CartEmulator::StepSink()
+{
+    const std::size_t avail = in_.size() - in_pos_;
+    if (avail == 0)
+    {
+        return false;
+    }
+    const uint8_t* p = in_.data() + in_pos_;
+
+    if (sink_ == Sink::SD_FILE_SIZE)
+    {
+        if (avail < 4)
+        {
+            return false;
+        }
+        sink_remaining_ = ReadBe32(p);
+        in_pos_ += 4;
+        sink_ = Sink::SD_FILE;
+        sink_crc_ = 0;
+        sink_buffer_.clear();
+        sink_buffer_.reserve(sink_remaining_);
+        return true;
+    }
+
+    if (sink_ == Sink::SD_PATCH_HEADER)
+    {
+        if (avail < xfer::REMOTE_IO_PATCH_HEADER_SIZE)
+        {
+            return false;
+        }
+        patch_size_ = ReadBe32(p);
+        patch_digest_.assign(p + 4, p + 24);
+        sink_remaining_ = ReadBe32(p + 24);
+        in_pos_ += xfer::REMOTE_IO_PATCH_HEADER_SIZE;
+        sink_ = Sink::SD_PATCH;
+        sink_crc_ = 0;
+        sink_buffer_.clear();
+        sink_buffer_.reserve(sink_remaining_);
+        return true;
+    }
+
+    if (sink_remaining_ > 0)
+    {
+        const std::size_t n = std::min<std::size_t>(avail, sink_remaining_);
+        sink_crc_ = crc8::crc_update(sink_crc_, p, n);
+        if (sink_ == Sink::RAM || sink_ == Sink::EXEC_RAM)
+        {
+            WriteRam(sink_address_, p, n);
+            sink_address_ += static_cast<uint32_t>(n);
+        }
+        else
+        {
+            sink_buffer_.insert(sink_buffer_.end(), p, p + n);
+        }
+        sink_remaining_ -= static_cast<uint32_t>(n);
+        in_pos_ += n;
+        return true;
+    }
+
+    // Data complete: the next byte is the host CRC.
+    const uint8_t host_crc = p[0];
+    in_pos_ += 1;
+    FinishSink(host_crc);
+    return true;
+}
+
+/**
+ * @brief Behave like the LZF decompressor stub staged by DoCompressedUpload.
+ * @details Blocks are read back from emulated RAM one at a time right before
+ *          they are expanded, so a stream placed where its output would
+ *          overwrite unread input is corrupted exactly as on hardware.
+ */
+void CartEmulator::RunDecompressorStub()
+{
+    const std::vector<uint8_t> raw = ReadRam(xfer::LZF_UPLOAD_PARAMS_ADDRESS, xfer::LZF_UPLOAD_PARAM_COUNT * 4);
+    uint32_t params[xfer::LZF_UPLOAD_PARAM_COUNT];
+    for (std::size_t i = 0; i < xfer::LZF_UPLOAD_PARAM_COUNT; ++i)
+    {
+        params[i] = ReadBe32(raw.data() + i * 4);
+    }
+    const uint32_t image_len = params[FC_PDATALEN_INDEX];
+    const uint32_t dest = params[FC_EXEADDRS_INDEX];
+    const uint32_t stream_len = params[FC_COMPDATALEN_INDEX];
+    const uint32_t stream_addr = params[xfer::LZF_UPLOAD_STREAMADDR_INDEX];
+
+    const std::vector<uint8_t> stream = ReadRam(stream_addr, stream_len);
+    if (crc8::crc_update(0, stream.data(), stream.size()) != static_cast<uint8_t>(params[FC_COMPDATACRC_INDEX]))
+    {
+        std::cerr << "[Emulator] Decompressor: stream CRC mismatch" << std::endl;
+        return;
+    }
+
+    uint32_t in = 0;
+    uint32_t out = 0;
+    while (in + xfer::LZF_UPLOAD_BLOCK_HEADER_SIZE <= stream_len)
+    {
+        const uint32_t block_len = ReadBe32(ReadRam(stream_addr + in, 4).data());
+        in += static_cast<uint32_t>(xfer::LZF_UPLOAD_BLOCK_HEADER_SIZE);
+        std::vector<uint8_t> block = ReadRam(stream_addr + in, block_len);
+        std::vector<uint8_t> expanded(decomp_getsize(block.data(), block_len));
+        const unsigned long n = decomp_exec(block.data(), block_len, expanded.data());
+        WriteRam(dest + out, expanded.data(), n);
+        in += block_len;
+        out += static_cast<uint32_t>(n);
+    }
+    if (out != image_len)
+    {
+        std::cerr << "[Emulator] Decompressor: expanded " << out << " of " << image_len << " bytes" << std::endl;
+        return;
+    }
+
+    cdbg << "[Emulator] Decompressor: expanded " << stream_len << " -> " << out << " bytes at 0x" << std::hex << dest
+         << std::dec << std::endl;
+    if (params[xfer::LZF_UPLOAD_FLAGS_INDEX] & xfer::LZF_UPLOAD_FLAG_EXECUTE)
+    {
+        last_exec_address_ = dest;
+    }
+}
+
+/**
+ * @brief Verify the CRC of a completed data phase, commit it and acknowledge.
+ */
+void CartEmulator::FinishSink(uint8_t host_crc)
+{
+    const bool ok = (host_crc == sink_crc_);
+    const Sink finished = sink_;
+    sink_ = Sink::NONE;
+
+    if (ok && finished == Sink::SD_RAW)
+    {
+        for (std::size_t offset = 0; offset < sink_buffer_.size(); offset += kSdSectorSize)
+        {
+            std::vector<uint8_t>& sector = sd_sectors_[sink_address_ + static_cast<uint32_t>(offset / kSdSectorSize)];
+            sector.assign(kSdSectorSize, 0);
+            const std::size_t n = std::min<std::size_t>(kSdSectorSize, sink_buffer_.size() - offset);
+            std::memcpy(sector.data(), sink_buffer_.data() + offset, n);
+        }
+    }
+
+    bool committed = ok;
+    if (ok && finished == Sink::SD_FILE)
+    {
+        committed = WriteSdFile(sink_path_, sink_buffer_);
+    }
+    if (ok && finished == Sink::SD_PATCH)
+    {
+        committed = ApplySdPatch(sink_path_, sink_buffer_);
+    }
+    if (ok && finished == Sink::EXEC_RAM)
+    {
+        last_exec_address_ = sink_start_;
+    }
+
+    sink_buffer_.clear();
+    sink_buffer_.shrink_to_fit();
+    EmitByte(committed ? 0x00 : 0x01);
+}
+
+/**
+ * @brief Execute one SRL1 request.
+ * @param command Raw command byte.
+ * @param arg Request payload.
+ */
+void CartEmulator::HandleRemoteIo(uint8_t command, const std::string& arg)
+{
+    using xfer::RemoteIoCommand;
+    using xfer::RemoteIoStatus;
+    const auto ok = static_cast<uint8_t>(RemoteIoStatus::OK);
+    const auto err = static_cast<uint8_t>(RemoteIoStatus::ERR);
+
+    if (disabled_commands_.count(command) != 0)
+    {
+        Reply(static_cast<uint8_t>(RemoteIoStatus::UNSUPPORTED));
+        return;
+    }
+
+    switch (static_cast<RemoteIoCommand>(command))
+    {
+    case RemoteIoCommand::LIST:
+    {
+        std::string path = arg;
+        bool long_format = false;
+        if (path.rfind("-l", 0) == 0)
+        {
+            long_format = true;
+            path = path.substr(2);
+            path.erase(0, path.find_first_not_of(' '));
+        }
+        const std::string key = NormalizeKey(path);
+        auto it = sd_.find(key);
+        if (it == sd_.end() || !it->second.is_dir)
+        {
+            Reply(err, "Directory not found\n");
+            return;
+        }
+
+        // Split at line boundaries like the firmware.
+        const std::string listing = ListDirectory(key, long_format);
+        std::vector<std::string> packets;
+        std::size_t pos = 0;
+        while (pos < listing.size())
+        {
+            std::size_t end = std::min(listing.size(), pos + kListPacketSize);
+            if (end < listing.size())
+            {
+                const std::size_t nl = listing.rfind('\n', end - 1);
+                if (nl != std::string::npos && nl >= pos)
+                {
+                    end = nl + 1;
+                }
+            }
+            packets.push_back(listing.substr(pos, end - pos));
+            pos = end;
+        }
+        ReplyStream(packets);
+        return;
+    }
+
+    case RemoteIoCommand::REMOVE:
+        Reply(Remove(arg, false) ? ok : err);
+        return;
+
+    case RemoteIoCommand::RMDIR:
+        Reply(Remove(arg, true) ? ok : err);
+        return;
+
+    case RemoteIoCommand::MKDIR:
+        Reply(MakeDir(arg) ? ok : err);
+        return;
+
+    case RemoteIoCommand::RENAME:
+    {
+        const std::size_t sep = arg.find('\0');
+        if (sep == std::string::npos)
+        {
+            Reply(static_cast<uint8_t>(RemoteIoStatus::BAD_REQUEST));
+            return;
+        }
+        Reply(Rename(arg.substr(0, sep), arg.substr(sep + 1)) ? ok : err);
+        return;
+    }
+
+    case RemoteIoCommand::CRC:
+    {
+        const SdNode* node = FindSd(arg);
+        if (node == nullptr || node->is_dir)
+        {
+            Reply(err, "File not found\n");
+            return;
+        }
+        char line[64];
+        std::snprintf(line, sizeof(line), " CRC-8 = 0x%02X\n",
+                      crc8::crc_update(0, node->data.data(), node->data.size()));
+        Reply(ok, arg + line);
+        return;
+    }
+
+    case RemoteIoCommand::UPLOAD:
+    {
+        const std::string key = NormalizeKey(arg);
+        auto parent = sd_.find(ParentKey(key));
+        auto existing = sd_.find(key);
+        if (key == "/" || parent == sd_.end() || !parent->second.is_dir ||
+            (existing != sd_.end() && existing->second.is_dir))
+        {
+            Reply(err);
+            return;
+        }
+        Reply(ok);
+        sink_ = Sink::SD_FILE_SIZE;
+        sink_path_ = arg;
+        return;
+    }
+
+    case RemoteIoCommand::DOWNLOAD:
+    {
+        const SdNode* node = FindSd(arg);
+        if (node == nullptr || node->is_dir)
+        {
+            Reply(err);
+            return;
+        }
+        const uint32_t size = static_cast<uint32_t>(node->data.size());
+        const char size_buf[4] = {
+            static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+            static_cast<char>(size >> 8), static_cast<char>(size)};
+        Reply(ok, std::string(size_buf, sizeof(size_buf)));
+        Emit(node->data.data(), node->data.size());
+        EmitByte(crc8::crc_update(0, node->data.data(), node->data.size()));
+        return;
+    }
+
+    case RemoteIoCommand::TREE:
+    {
+        const std::string key = NormalizeKey(arg);
+        auto it = sd_.find(key);
+        if (it == sd_.end() || !it->second.is_dir)
+        {
+            Reply(err);
+            return;
+        }
+        std::string stream;
+        AppendTree(key, std::string(), stream);
+        std::vector<std::string> packets;
+        for (std::size_t pos = 0; pos < stream.size(); pos += kListPacketSize)
+        {
+            packets.push_back(stream.substr(pos, kListPacketSize));
+        }
+        ReplyStream(packets);
+        return;
+    }
+
+    case RemoteIoCommand::HASH:
+    {
+        const SdNode* node = FindSd(arg);
+        if (node == nullptr || node->is_dir)
+        {
+            Reply(err, "File not found\n");
+            return;
+        }
+        const uint32_t size = static_cast<uint32_t>(node->data.size());
+        sha1::Hasher hasher;
+        for (std::size_t pos = 0; pos < node->data.size(); pos += xfer::REMOTE_IO_HASH_PROGRESS_BYTES)
+        {
+            const std::size_t len = std::min(node->data.size() - pos, xfer::REMOTE_IO_HASH_PROGRESS_BYTES);
+            hasher.update(node->data.data() + pos, len);
+            if (pos + len < node->data.size())
+            {
+                const uint32_t done = static_cast<uint32_t>(pos + len);
+                Reply(ok, {static_cast<char>(done >> 24), static_cast<char>(done >> 16),
+                           static_cast<char>(done >> 8), static_cast<char>(done)}, true);
+            }
+        }
+        const sha1::digest_t digest = hasher.finish();
+        std::string payload = {static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+                               static_cast<char>(size >> 8), static_cast<char>(size)};
+        payload.append(reinterpret_cast<const char*>(digest.data()), digest.size());
+        Reply(ok, payload);
+        return;
+    }
+
+    case RemoteIoCommand::BLOCK_SUMS:
+    {
+        const SdNode* node = FindSd(arg);
+        if (node == nullptr || node->is_dir)
+        {
+            Reply(err, "File not found\n");
+            return;
+        }
+        const std::vector<uint8_t>& data = node->data;
+        const uint32_t size = static_cast<uint32_t>(data.size());
+        std::string stream = {static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+                              static_cast<char>(size >> 8), static_cast<char>(size)};
+        for (std::size_t pos = 0; pos + xfer::REMOTE_IO_DELTA_BLOCK_SIZE <= data.size();
+             pos += xfer::REMOTE_IO_DELTA_BLOCK_SIZE)
+        {
+            const uint32_t weak = xfer::RemoteIoWeakSum(data.data() + pos, xfer::REMOTE_IO_DELTA_BLOCK_SIZE);
+            const sha1::digest_t strong = sha1::hash(data.data() + pos, xfer::REMOTE_IO_DELTA_BLOCK_SIZE);
+            stream.push_back(static_cast<char>(weak >> 24));
+            stream.push_back(static_cast<char>(weak >> 16));
+            stream.push_back(static_cast<char>(weak >> 8));
+            stream.push_back(static_cast<char>(weak));
+            stream.append(reinterpret_cast<const char*>(strong.data()), xfer::REMOTE_IO_BLOCK_STRONG_SIZE);
+        }
+        std::vector<std::string> packets;
+        for (std::size_t pos = 0; pos < stream.size(); pos += kListPacketSize)
+        {
+            packets.push_back(stream.substr(pos, kListPacketSize));
+        }
+        ReplyStream(packets);
+        return;
+    }
+
+    case RemoteIoCommand::PATCH:
+    {
+        const SdNode* node = FindSd(arg);
+        if (node == nullptr || node->is_dir)
+        {
+            Reply(err);
+            return;
+        }
+        Reply(ok);
+        sink_ = Sink::SD_PATCH_HEADER;
+        sink_path_ = arg;
+        return;
+    }
+
+    case RemoteIoCommand::READ:
+    {
+        if (arg.size() < 8)
+        {
+            Reply(static_cast<uint8_t>(RemoteIoStatus::BAD_REQUEST));
+            return;
+        }
+        const auto* p = reinterpret_cast<const uint8_t*>(arg.data());
+        const uint32_t offset = ReadBe32(p);
+        const uint32_t length = ReadBe32(p + 4);
+        const SdNode* node = FindSd(arg.substr(8));
+        if (node == nullptr || node->is_dir)
+        {
+            Reply(err);
+            return;
+        }
+        const uint32_t size = static_cast<uint32_t>(node->data.size());
+        if (offset > size)
+        {
+            Reply(err, Be32String(size));
+            return;
+        }
+        const std::size_t n = std::min<std::size_t>({length, size - offset, xfer::REMOTE_IO_CHUNK_SIZE});
+        const uint8_t* data = node->data.data() + offset;
+        std::string payload = Be32String(size);
+        payload.append(reinterpret_cast<const char*>(data), n);
+        payload.push_back(static_cast<char>(crc8::crc_update(0, data, n)));
+        Reply(ok, payload);
+        return;
+    }
+
+    case RemoteIoCommand::WRITE:
+    {
+        const auto* p = reinterpret_cast<const uint8_t*>(arg.data());
+        const std::size_t path_len = (arg.size() >= 6) ? ((static_cast<std::size_t>(p[4]) << 8) | p[5]) : 0;
+        if (arg.size() < 6 + path_len + 1)
+        {
+            Reply(static_cast<uint8_t>(RemoteIoStatus::BAD_REQUEST));
+            return;
+        }
+        const uint32_t offset = ReadBe32(p);
+        const std::string path = arg.substr(6, path_len);
+        const uint8_t* data = p + 6 + path_len;
+        const std::size_t n = arg.size() - 6 - path_len - 1;
+
+        auto it = sd_.find(NormalizeKey(path));
+        const bool exists = (it != sd_.end() && !it->second.is_dir);
+        const uint32_t size = exists ? static_cast<uint32_t>(it->second.data.size()) : 0;
+        if (offset != 0 && !exists)
+        {
+            Reply(err);
+            return;
+        }
+        if ((offset != 0 && offset != size) || crc8::crc_update(0, data, n) != p[arg.size() - 1])
+        {
+            Reply(err, Be32String(size));
+            return;
+        }
+        if (offset == 0)
+        {
+            if (!WriteSdFile(path, std::vector<uint8_t>(data, data + n)))
+            {
+                Reply(err);
+                return;
+            }
+            it = sd_.find(NormalizeKey(path));
+        }
+        else
+        {
+            it->second.data.insert(it->second.data.end(), data, data + n);
+            it->second.mtime = std::time(nullptr);
+        }
+        Reply(ok, Be32String(static_cast<uint32_t>(it->second.data.size())));
+        return;
+    }
+
+    case RemoteIoCommand::COPY:
+    {
+        const std::size_t sep = arg.find('\0', 4);
+        if (arg.size() < 4 || sep == std::string::npos)
+        {
+            Reply(static_cast<uint8_t>(RemoteIoStatus::BAD_REQUEST));
+            return;
+        }
+        const uint32_t offset = ReadBe32(reinterpret_cast<const uint8_t*>(arg.data()));
+        const std::string from = arg.substr(4, sep - 4);
+        const std::string to = arg.substr(sep + 1);
+        const SdNode* source = FindSd(from);
+        const SdNode* target = FindSd(to);
+        if (source == nullptr || source->is_dir || NormalizeKey(from) == NormalizeKey(to) ||
+            offset > source->data.size() ||
+            (offset != 0 && (target == nullptr || target->is_dir || target->data.size() != offset)))
+        {
+            Reply(err);
+            return;
+        }
+        const std::size_t n = std::min(xfer::REMOTE_IO_COPY_STEP, source->data.size() - offset);
+        const uint32_t size = static_cast<uint32_t>(source->data.size());
+        std::vector<uint8_t> chunk(source->data.begin() + offset, source->data.begin() + offset + n);
+        if (offset == 0)
+        {
+            if (!WriteSdFile(to, chunk))
+            {
+                Reply(err);
+                return;
+            }
+        }
+        else
+        {
+            SdNode& node = sd_[NormalizeKey(to)];
+            node.data.insert(node.data.end(), chunk.begin(), chunk.end());
+            node.mtime = std::time(nullptr);
+        }
+        Reply(ok, Be32String(size) + Be32String(static_cast<uint32_t>(n)));
+        return;
+    }
+
+    case RemoteIoCommand::VERSION:
+    {
+        const char version[2] = {static_cast<char>(xfer::REMOTE_IO_VERSION_CHUNKED),
+                                 static_cast<char>(kRemoteIoPipelineDepth)};
+        Reply(ok, std::string(version, sizeof(version)));
+        // The payload carries the host protocol version.
+        framed_replies_ = !arg.empty() &&
+                          static_cast<uint8_t>(arg[0]) >= xfer::REMOTE_IO_VERSION_FRAMED;
+        return;
+    }
+
+    default:
+        Reply(static_cast<uint8_t>(RemoteIoStatus::UNSUPPORTED));
+        return;
+    }
+}
+
+/**
+ * @brief Queue the packets of a multi-packet OK reply.
+ * @details Framed replies flag every packet but the last as continued; legacy
+ *          replies end with an empty OK packet.
+ */
+void CartEmulator::ReplyStream(const std::vector<std::string>& packets)
+{
+    const auto ok = static_cast<uint8_t>(xfer::RemoteIoStatus::OK);
+    for (std::size_t i = 0; i < packets.size(); ++i)
+    {
+        const bool last = (i + 1 == packets.size());
+        if (framed_replies_ && last)
+        {
+            Reply(ok, packets[i]);
+            return;
+        }
+        Reply(ok, packets[i], true);
+    }
+    Reply(ok);
+}
+
+/**
+ * @brief Queue an SRL1 reply packet, or a tagged one while serving an SRL2 request.
+ * @param more Framed replies only: more packets of this reply follow.
+ */
+void CartEmulator::Reply(uint8_t status, const std::string& payload, bool more)
+{
+    if (framed_replies_)
+    {
+        status |= more ? xfer::REMOTE_IO_FLAG_MORE : xfer::REMOTE_IO_FLAG_FINAL;
+    }
+    const std::size_t len = std::min(payload.size(), xfer::REMOTE_IO_MAX_PAYLOAD);
+    if (reply_tag_ >= 0)
+    {
+        const uint8_t header[xfer::REMOTE_IO_TAGGED_HEADER_SIZE] = {
+            xfer::REMOTE_IO_TAGGED_MAGIC[0], xfer::REMOTE_IO_TAGGED_MAGIC[1],
+            xfer::REMOTE_IO_TAGGED_MAGIC[2], xfer::REMOTE_IO_TAGGED_MAGIC[3],
+            status, static_cast<uint8_t>(reply_tag_ >> 8), static_cast<uint8_t>(reply_tag_),
+            static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len)};
+        Emit(header, sizeof(header));
+        Emit(reinterpret_cast<const uint8_t*>(payload.data()), len);
+        return;
+    }
+    const uint8_t header[xfer::REMOTE_IO_HEADER_SIZE] = {
+        xfer::REMOTE_IO_MAGIC[0], xfer::REMOTE_IO_MAGIC[1], xfer::REMOTE_IO_MAGIC[2], xfer::REMOTE_IO_MAGIC[3],
+        status, static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len)};
+    Emit(header, sizeof(header));
+    Emit(reinterpret_cast<const uint8_t*>(payload.data()), len);
+}
+
+void CartEmulator::Emit(const uint8_t* data, std::size_t size)
+{
+    out_.insert(out_.end(), data, data + size);
+}
+
+void CartEmulator::EmitByte(uint8_t value)
+{
+    out_.push_back(value);
+}
+
+/**
+ * @brief Render a directory listing in the firmware's "[D]/[F] size date time name" format.
+ */
+std::string CartEmulator::ListDirectory(const std::string& key, bool long_format) const
+{
+    std::string listing;
+    for (const std::string& child : Children(key))
+    {
+        const SdNode& node = sd_.at(child);
+        if (!long_format)
+        {
+            listing += node.name + (node.is_dir ? "/\n" : "\n");
+            continue;
+        }
+
+        char date[32] = "1980-01-01 00:00";
+        std::tm tm_buf = {};
+        const std::time_t t = node.mtime;
+        if (const std::tm* tm = std::localtime(&t))
+        {
+            tm_buf = *tm;
+            std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M", &tm_buf);
+        }
+        char line[64];
+        std::snprintf(line, sizeof(line), "%s %10zu %s ", node.is_dir ? "[D]" : "[F]",
+                      node.is_dir ? static_cast<std::size_t>(0) : node.data.size(), date);
+        listing += line + node.name + "\n";
+    }
+    return listing;
+}
+
+/**
+ * @brief Append the TREE records of everything below a directory.
+ * @param key Normalized directory key.
+ * @param rel Path of the directory relative to the TREE root ("" for the root).
+ * @param stream Record stream to extend.
+ */
+void CartEmulator::AppendTree(const std::string& key, const std::string& rel, std::string& stream) const
+{
+    for (const std::string& child : Children(key))
+    {
+        const SdNode& node = sd_.at(child);
+        const std::string path = rel.empty() ? node.name : rel + "/" + node.name;
+
+        uint16_t fat_date = (1 << 5) | 1; // 1980-01-01
+        uint16_t fat_time = 0;
+        const std::time_t t = node.mtime;
+        if (const std::tm* tm = std::localtime(&t))
+        {
+            if (tm->tm_year >= 80)
+            {
+                fat_date = static_cast<uint16_t>(((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday);
+                fat_time = static_cast<uint16_t>((tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2));
+            }
+        }
+
+        const uint32_t size = node.is_dir ? 0 : static_cast<uint32_t>(node.data.size());
+        const std::size_t len = std::min(path.size(), static_cast<std::size_t>(0xFFFF));
+        const char record[xfer::REMOTE_IO_TREE_RECORD_HEADER_SIZE] = {
+            static_cast<char>(node.is_dir ? xfer::REMOTE_IO_ATTR_DIRECTORY : xfer::REMOTE_IO_ATTR_ARCHIVE),
+            static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+            static_cast<char>(size >> 8), static_cast<char>(size),
+            static_cast<char>(fat_date >> 8), static_cast<char>(fat_date),
+            static_cast<char>(fat_time >> 8), static_cast<char>(fat_time),
+            static_cast<char>(len >> 8), static_cast<char>(len)};
+        stream.append(record, sizeof(record));
+        stream.append(path, 0, len);
+
+        if (node.is_dir)
+        {
+            AppendTree(child, path, stream);
+        }
+    }
+}
+
+/**
+ * @brief Keys of the direct children of a directory, in sorted order.
+ */
+std::vector<std::string> CartEmulator::Children(const std::string& key) const
+{
+    std::vector<std::string> children;
+    const std::string prefix = (key == "/") ? "/" : key + "/";
+    for (auto it = sd_.lower_bound(prefix); it != sd_.end(); ++it)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+        if (it->first.size() > prefix.size() && it->first.find('/', prefix.size()) == std::string::npos)
+        {
+            children.push_back(it->first);
+        }
+    }
+    return children;
+}
+
+bool CartEmulator::MakeDir(const std::string& path)
+{
+    const std::string key = NormalizeKey(path);
+    auto parent = sd_.find(ParentKey(key));
+    if (key == "/" || sd_.count(key) != 0 || parent == sd_.end() || !parent->second.is_dir)
+    {
+        return false;
+    }
+    SdNode node;
+    node.name = BaseName(path);
+    node.is_dir = true;
+    node.mtime = std::time(nullptr);
+    sd_[key] = node;
+    return true;
+}
+
+bool CartEmulator::Remove(const std::string& path, bool dirs_only)
+{
+    const std::string key = NormalizeKey(path);
+    auto it = sd_.find(key);
+    if (key == "/" || it == sd_.end())
+    {
+        return false;
+    }
+    if (dirs_only && !it->second.is_dir)
+    {
+        return false;
+    }
+    if (it->second.is_dir && !Children(key).empty())
+    {
+        return false;
+    }
+    sd_.erase(it);
+    return true;
+}
+
+bool CartEmulator::Rename(const std::string& from, const std::string& to)
+{
+    const std::string src = NormalizeKey(from);
+    const std::string dst = NormalizeKey(to);
+    auto parent = sd_.find(ParentKey(dst));
+    if (src == "/" || sd_.count(src) == 0 || sd_.count(dst) != 0 ||
+        parent == sd_.end() || !parent->second.is_dir ||
+        dst.compare(0, src.size() + 1, src + "/") == 0)
+    {
+        return false;
+    }
+
+    // Re-key the node and, for directories, its whole subtree.
+    std::vector<std::string> moved;
+    const std::string prefix = src + "/";
+    for (auto it = sd_.lower_bound(src); it != sd_.end(); ++it)
+    {
+        if (it->first != src && it->first.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+        moved.push_back(it->first);
+    }
+    for (const std::string& old_key : moved)
+    {
+        SdNode node = std::move(sd_[old_key]);
+        sd_.erase(old_key);
+        if (old_key == src)
+        {
+            node.name = BaseName(to);
+        }
+        sd_[dst + old_key.substr(src.size())] = std::move(node);
+    }
+    return true;
+}
+
+/**
+ * @brief Rebuild a file from a PATCH script, as the firmware does through the
+ *        FAT read and append calls.
+ * @return false on a malformed script or if the result does not match the
+ *         announced size and digest; the old file is then left untouched.
+ */
+bool CartEmulator::ApplySdPatch(const std::string& path, const std::vector<uint8_t>& script)
+{
+    const SdNode* node = FindSd(path);
+    if (node == nullptr || node->is_dir)
+    {
+        return false;
+    }
+    const std::vector<uint8_t>& old_data = node->data;
+    const std::size_t block_size = xfer::REMOTE_IO_DELTA_BLOCK_SIZE;
+
+    std::vector<uint8_t> result;
+    result.reserve(patch_size_);
+    std::size_t pos = 0;
+    while (pos < script.size())
+    {
+        const uint8_t op = script[pos++];
+        const std::size_t operands = (op == xfer::REMOTE_IO_PATCH_COPY) ? 8 : 4;
+        if (script.size() - pos < operands)
+        {
+            return false;
+        }
+        if (op == xfer::REMOTE_IO_PATCH_COPY)
+        {
+            const uint64_t first = ReadBe32(script.data() + pos);
+            const uint64_t count = ReadBe32(script.data() + pos + 4);
+            pos += 8;
+            if ((first + count) * block_size > old_data.size())
+            {
+                return false;
+            }
+            result.insert(result.end(), old_data.begin() + first * block_size,
+                          old_data.begin() + (first + count) * block_size);
+        }
+        else if (op == xfer::REMOTE_IO_PATCH_DATA)
+        {
+            const uint32_t len = ReadBe32(script.data() + pos);
+            pos += 4;
+            if (script.size() - pos < len)
+            {
+                return false;
+            }
+            result.insert(result.end(), script.begin() + pos, script.begin() + pos + len);
+            pos += len;
+        }
+        else
+        {
+            return false;
+        }
+        if (result.size() > patch_size_)
+        {
+            return false;
+        }
+    }
+
+    const sha1::digest_t digest = sha1::hash(result.data(), result.size());
+    if (result.size() != patch_size_ || !std::equal(digest.begin(), digest.end(), patch_digest_.begin()))
+    {
+        std::cerr << "[Emulator] PATCH result does not match the announced file" << std::endl;
+        return false;
+    }
+    cdbg << "[Emulator] Patched " << path << ": " << script.size() << " byte script -> " << result.size()
+         << " bytes" << std::endl;
+    return WriteSdFile(path, result);
+}
+
+/**
+ * @brief Canonical, case-folded lookup key for a card path ("/DIR/FILE.BIN").
+ */
+std::string CartEmulator::NormalizeKey(const std::string& path)
+{
+    std::string key = "/";
+    for (char c : path)
+    {
+        if (c == '\\')
+        {
+            c = '/';
+        }
+        if (c == '/' && key.back() == '/')
+        {
+            continue;
+        }
+        key += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (key.size() > 1 && key.back() == '/')
+    {
+        key.pop_back();
+    }
+    return key;
+}
+
+std::string CartEmulator::ParentKey(const std::string& key)
+{
+    const std::size_t slash = key.find_last_of('/');
+    return (slash == 0 || slash == std::string::npos) ? "/" : key.substr(0, slash);
+}
+
+std::string CartEmulator::BaseName(const std::string& path)
+{
+    std::string trimmed = path;
+    while (trimmed.size() > 1 && (trimmed.back() == '/' || trimmed.back() == '\\'))
+    {
+        trimmed.pop_back();
+    }
+    const std::size_t slash = trimmed.find_last_of("/\\");
+    return (slash == std::string::npos) ? trimmed : trimmed.substr(slash + 1);
+}
+
+} // namespace emu
+
+namespace transport {
+
+namespace {
+
+/**
+ * @brief Transport that loops host traffic through a CartEmulator.
+ * @details Replies become readable as soon as the request that produced
+ *          them is written, so measured times reflect host-side protocol
+ *          overhead only.
+ */
+class EmulatorTransport : public Transport {
+public:
+    const char* Name() const override { return "emulator"; }
+
+    emu::CartEmulator& Emulator() { return emulator_; }
+
+    bool Write(const unsigned char* data, std::size_t size) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            emulator_.Feed(data, size);
+        }
+        ready_.notify_all();
+        return !ftdi::g_interrupt_flag;
+    }
+
+    long Read(unsigned char* data, std::size_t size, int idle_timeout_ms) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::size_t got = 0;
+        while (got < size && !ftdi::g_interrupt_flag)
+        {
+            const std::size_t n = emulator_.Drain(data + got, size - got);
+            got += n;
+            if (got == size)
+            {
+                break;
+            }
+            if (n == 0 && !ready_.wait_for(lock, std::chrono::milliseconds(idle_timeout_ms),
+                                           [this] { return emulator_.Pending() > 0; }))
+            {
+                break;
+            }
+        }
+        return static_cast<long>(got);
+    }
+
+    int ReadSome(unsigned char* data, std::size_t size) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Block briefly like a USB latency period so callers do not spin.
+        ready_.wait_for(lock, std::chrono::milliseconds(1), [this] { return emulator_.Pending() > 0; });
+        return static_cast<int>(emulator_.Drain(data, size));
+    }
+
+    bool Purge() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        emulator_.ResetLink();
+        return true;
+    }
+
+    std::string LastError() const override { return "emulator link error"; }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    emu::CartEmulator emulator_;
+};
+
+} // namespace
+
+/**
+ * @copydoc transport::MakeEmulatorTransport
+ */
+std::unique_ptr<Transport> MakeEmulatorTransport(const std::string& sd_seed_dir)
+{
+    auto link = std::make_unique<EmulatorTransport>();
+    if (!sd_seed_dir.empty() && !link->Emulator().LoadSdFromDirectory(sd_seed_dir))
+    {
+        return nullptr;
+    }
+    cdbg << "[Emulator] Using in-process cartridge emulator" << std::endl;
+    return link;
+}
+
+} // namespace transport
+
+namespace emu {
+
+/**
+ * @copydoc emu::EmulatorOf
+ */
+CartEmulator* EmulatorOf(transport::Transport& link)
+{
+    auto* emulator_link = dynamic_cast<transport::EmulatorTransport*>(&link);
+    return emulator_link != nullptr ? &emulator_link->Emulator() : nullptr;
+}
+
+} // namespace emu
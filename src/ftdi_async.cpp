@@ -0,0 +1,247 @@
+/**
+ * @file ftdi_async.cpp
+ * @brief Asynchronous bulk transfer engine built on libftdi's submit API.
+ * @details Keeps several bulk OUT transfers queued on the endpoint so the bus
+ *          never idles between submissions, and drives bulk IN transfers
+ *          from libusb's event loop instead of sleep-polling ftdi_read_data.
+ */
+
+/*
+
+    Sega Saturn USB flash cart transfer utility
+    Copyright © 2012, 2013, 2015 Anders Montonen
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <ftdi.h>
+#include <libusb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <iostream>
+
+#include "ftdi.hpp"
+#include "log.hpp"
+#include "xfer.hpp"
+
+namespace ftdi {
+
+namespace {
+
+/**
+ * @brief Size of a single queued bulk OUT transfer.
+ * @details Matches the configured write chunk size so that each transfer
+ *          control maps onto exactly one libusb transfer.
+ */
+constexpr std::size_t kAsyncWriteSegment = xfer::USB_WRITEPACKET_SIZE;
+
+/**
+ * @brief Maximum number of bulk OUT transfers queued at once.
+ */
+constexpr std::size_t kAsyncWritesInFlight = 16;
+
+/**
+ * @brief Upper bound for a single libusb event-loop wait, in milliseconds.
+ * @details libusb returns as soon as a transfer completes; this only bounds
+ *          how quickly idle timeouts and g_interrupt_flag are noticed.
+ */
+constexpr int kEventWaitMs = 10;
+
+/**
+ * @brief Pump libusb events until a transfer completes.
+ * @param tc Transfer control returned by one of the *_submit calls.
+ * @param idle_timeout_ms Give up after this long without any progress.
+ * @return true if the transfer completed, false on timeout, interrupt or
+ *         event-loop error. The caller still owns @p tc in both cases.
+ */
+bool WaitTransfer(struct ftdi_transfer_control *tc, int idle_timeout_ms)
+{
+    using clock = std::chrono::steady_clock;
+    auto last_progress = clock::now();
+    int last_offset = tc->offset;
+
+    while (!tc->completed)
+    {
+        if (g_interrupt_flag)
+        {
+            return false;
+        }
+
+        struct timeval tv = {0, kEventWaitMs * 1000};
+        const int rc = libusb_handle_events_timeout_completed(tc->ftdi->usb_ctx, &tv, &tc->completed);
+        if (rc < 0 && rc != LIBUSB_ERROR_INTERRUPTED)
+        {
+            std::cerr << "[AsyncIO] libusb event error: " << libusb_error_name(rc) << std::endl;
+            return false;
+        }
+
+        const auto now = clock::now();
+        if (tc->offset != last_offset)
+        {
+            last_offset = tc->offset;
+            last_progress = now;
+        }
+        else if (now - last_progress > std::chrono::milliseconds(idle_timeout_ms))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Cancel a transfer and release its control block.
+ * @details Waits for the cancellation to complete before the control block
+ *          is freed, so bytes that arrived while cancelling are counted.
+ * @param tc Transfer control to cancel (freed by libftdi).
+ * @return Bytes transferred by @p tc, including those completing during the cancel.
+ */
+int CancelTransfer(struct ftdi_transfer_control *tc)
+{
+    struct timeval tv = {0, kEventWaitMs * 1000};
+    if (!tc->completed && tc->transfer != nullptr && libusb_cancel_transfer(tc->transfer) == 0)
+    {
+        while (!tc->completed)
+        {
+            if (libusb_handle_events_timeout_completed(tc->ftdi->usb_ctx, &tv, &tc->completed) < 0)
+            {
+                break;
+            }
+        }
+    }
+    const int transferred = tc->offset;
+    ftdi_transfer_data_cancel(tc, &tv);
+    return transferred;
+}
+
+} // namespace
+
+/**
+ * @copydoc ftdi::WriteAsync
+ */
+bool WriteAsync(const unsigned char *data, std::size_t size)
+{
+    std::deque<struct ftdi_transfer_control *> pending;
+    std::size_t submitted = 0;
+    std::size_t completed = 0;
+    bool ok = true;
+
+    while (ok && completed < size)
+    {
+        // Step 1: Top up the queue so the endpoint always has work pending
+        while (submitted < size && pending.size() < kAsyncWritesInFlight)
+        {
+            const std::size_t len = std::min(kAsyncWriteSegment, size - submitted);
+            struct ftdi_transfer_control *tc =
+                ftdi_write_data_submit(&g_Device, const_cast<unsigned char *>(data + submitted),
+                                       static_cast<int>(len));
+            if (tc == nullptr)
+            {
+                std::cerr << "[AsyncIO] Write submit error: " << ftdi_get_error_string(&g_Device) << std::endl;
+                ok = false;
+                break;
+            }
+            pending.push_back(tc);
+            submitted += len;
+        }
+
+        if (!ok || pending.empty())
+        {
+            break;
+        }
+
+        // Step 2: Retire the oldest transfer; bulk OUT completes in order
+        struct ftdi_transfer_control *tc = pending.front();
+        pending.pop_front();
+        const int expected = tc->size;
+        if (!WaitTransfer(tc, kAsyncIdleTimeoutMs))
+        {
+            if (!g_interrupt_flag)
+            {
+                std::cerr << "[AsyncIO] Timeout waiting for write completion." << std::endl;
+            }
+            CancelTransfer(tc);
+            ok = false;
+            break;
+        }
+
+        const int rc = ftdi_transfer_data_done(tc);
+        if (rc != expected)
+        {
+            std::cerr << "[AsyncIO] Write error: transferred " << rc << "/" << expected << " bytes" << std::endl;
+            ok = false;
+            break;
+        }
+        completed += static_cast<std::size_t>(rc);
+    }
+
+    // Step 3: On failure, withdraw anything still queued
+    for (struct ftdi_transfer_control *tc : pending)
+    {
+        CancelTransfer(tc);
+    }
+
+    cdbg << "[AsyncIO] write " << completed << "/" << size << " bytes" << std::endl;
+    return ok && completed == size;
+}
+
+/**
+ * @copydoc ftdi::ReadAsync
+ */
+long ReadAsync(unsigned char *data, std::size_t size, int idle_timeout_ms)
+{
+    std::size_t total = 0;
+    while (total < size)
+    {
+        const std::size_t len = std::min<std::size_t>(size - total, INT_MAX);
+        struct ftdi_transfer_control *tc =
+            ftdi_read_data_submit(&g_Device, data + total, static_cast<int>(len));
+        if (tc == nullptr)
+        {
+            std::cerr << "[AsyncIO] Read submit error: " << ftdi_get_error_string(&g_Device) << std::endl;
+            return -1;
+        }
+
+        if (!WaitTransfer(tc, idle_timeout_ms))
+        {
+            // Report whatever arrived before the line went quiet.
+            total += static_cast<std::size_t>(CancelTransfer(tc));
+            return static_cast<long>(total);
+        }
+
+        const int rc = ftdi_transfer_data_done(tc);
+        if (rc < 0)
+        {
+            std::cerr << "[AsyncIO] Read error: " << ftdi_get_error_string(&g_Device) << std::endl;
+            return -1;
+        }
+        total += static_cast<std::size_t>(rc);
+    }
+    return static_cast<long>(total);
+}
+
+} // namespace ftdi
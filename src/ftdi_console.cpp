@@ -46,6 +46,7 @@
 
 #include "log.hpp"
 #include "ftdi.hpp"
+#include "transport.hpp"
 
 namespace ftdi {
 
@@ -69,6 +70,8 @@ void DoConsole(bool enable_stdin, bool acknowledge)
                        "[DoConsole][dbg] acknowledge=" << acknowledge
                        << ", ackByte=0x" << std::hex << static_cast<int>(ackByte) << std::dec << std::endl);
 
+    transport::Transport& link = transport::Active();
+
     std::mutex stdinLineQueueMutex;
     std::deque<std::string> stdinLineQueue;
     std::thread stdinReaderThread;
@@ -200,7 +203,7 @@ void DoConsole(bool enable_stdin, bool acknowledge)
     while (status >= 0 && !g_interrupt_flag)
     {
         // Step 6: Read data into the buffer
-        status = ftdi_read_data(&g_Device, pFileBuffer.get(), RecvBufSize);
+        status = link.ReadSome(pFileBuffer.get(), RecvBufSize);
         if (status != 0)
         {
             cdbg << "[DoConsole][dbg] ftdi_read_data status=" << status << std::endl;
@@ -209,7 +212,7 @@ void DoConsole(bool enable_stdin, bool acknowledge)
         if (status < 0 && !g_interrupt_flag)
         {
             // Step 7: Handle error if reading data fails
-            std::cerr << "[DoConsole] Read data error: " << ftdi_get_error_string(&g_Device) << std::endl;
+            std::cerr << "[DoConsole] Read data error: " << link.LastError() << std::endl;
             g_interrupt_flag = true;
             break;
         }
@@ -306,25 +309,17 @@ void DoConsole(bool enable_stdin, bool acknowledge)
             CDBG_LOG_ON_CHANGE("DoConsole.stdin_forward",
                                "[DoConsole][dbg] forwarding stdin line bytes=" << outCount << std::endl);
 
-            while (sent < outCount && !g_interrupt_flag)
+            if (!g_interrupt_flag)
             {
-                const int writeStatus = ftdi_write_data(&g_Device, outBuffer.data() + sent, outCount - sent);
-                if (writeStatus < 0)
+                if (!link.Write(outBuffer.data(), outBuffer.size()))
                 {
-                    std::cerr << "[DoConsole] Stdin forward error: " << ftdi_get_error_string(&g_Device) << std::endl;
+                    std::cerr << "[DoConsole] Stdin forward error: " << link.LastError() << std::endl;
                     g_interrupt_flag = true;
-                    break;
                 }
-                if (writeStatus == 0)
+                else
                 {
-                    CDBG_LOG_ON_CHANGE("DoConsole.write_zero",
-                                       "[DoConsole][dbg] ftdi_write_data returned 0, breaking send loop" << std::endl);
-                    break;
+                    sent = outCount;
                 }
-                sent += writeStatus;
-                CDBG_LOG_ON_CHANGE("DoConsole.write_progress",
-                                   "[DoConsole][dbg] ftdi_write_data wrote=" << writeStatus
-                                   << ", totalSent=" << sent << std::endl);
             }
 
             CDBG_LOG_ON_CHANGE("DoConsole.stdin_line_sent",
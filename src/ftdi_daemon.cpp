@@ -0,0 +1,574 @@
+/**
+ * @file ftdi_daemon.cpp
+ * @brief Persistent device daemon and its command-line client.
+ * @details `ftx --daemon` keeps the cartridge link open and executes ftx
+ *          command lines received over a Unix domain socket, so scripted
+ *          workflows pay the USB open cost once. `ftx --client ...` forwards
+ *          its own command line to the daemon and relays the output.
+ *
+ *          Wire format (all integers big-endian):
+ *          - request:  u32 length, then NUL-separated fields: client working
+ *                      directory followed by the command-line arguments;
+ *          - response: a sequence of frames, each one type byte ('O' stdout,
+ *                      'E' stderr, 'X' exit status) plus u32 length and data.
+ *                      'X' carries a 4-byte exit status and ends the reply.
+ *
+ *          Commands run one at a time in ticket order, so each client gets
+ *          its turn in arrival order even when another client keeps
+ *          submitting commands.
+ */
+
+#include "ftdi.hpp"
+#include "log.hpp"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+#ifndef _WIN32
+
+/**
+ * @brief Largest request accepted from a client.
+ */
+constexpr uint32_t kMaxRequestSize = 64 * 1024;
+
+/**
+ * @brief Poll period used to notice g_interrupt_flag.
+ */
+constexpr int kPollIntervalMs = 100;
+
+bool SendAll(int fd, const void* data, size_t len)
+{
+    const char* p = static_cast<const char*>(data);
+    while (len > 0)
+    {
+        const ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief Receive exactly @p len bytes, polling so an interrupt is noticed.
+ * @return false on EOF, error or interrupt.
+ */
+bool RecvAll(int fd, void* data, size_t len)
+{
+    char* p = static_cast<char*>(data);
+    while (len > 0)
+    {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, kPollIntervalMs);
+        if (ftdi::g_interrupt_flag)
+        {
+            return false;
+        }
+        if (ready < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        const ssize_t n = recv(fd, p, len, 0);
+        if (n == 0)
+        {
+            return false;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void PutBe32(unsigned char* out, uint32_t value)
+{
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+uint32_t GetBe32(const unsigned char* in)
+{
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+}
+
+bool SendFrame(int fd, char type, const void* data, uint32_t len)
+{
+    unsigned char header[5];
+    header[0] = static_cast<unsigned char>(type);
+    PutBe32(header + 1, len);
+    return SendAll(fd, header, sizeof(header)) && (len == 0 || SendAll(fd, data, len));
+}
+
+/**
+ * @brief Stream buffer that forwards everything written to it as reply frames.
+ * @details Installed into std::cout / std::cerr while a client command runs.
+ *          Send failures (client gone) are swallowed so the command still
+ *          completes and leaves the cartridge in a consistent state.
+ */
+class FrameStreamBuf : public std::streambuf
+{
+public:
+    FrameStreamBuf(int fd, char type) : fd_(fd), type_(type)
+    {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    ~FrameStreamBuf() override
+    {
+        Flush();
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        Flush();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        Flush();
+        return 0;
+    }
+
+private:
+    void Flush()
+    {
+        const std::ptrdiff_t n = pptr() - pbase();
+        if (n > 0 && connected_)
+        {
+            connected_ = SendFrame(fd_, type_, pbase(), static_cast<uint32_t>(n));
+        }
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    int fd_;
+    char type_;
+    bool connected_ = true;
+    char buffer_[4096];
+};
+
+/**
+ * @brief FIFO (ticket) lock giving waiting clients the device in arrival order.
+ */
+class FairLock
+{
+public:
+    void lock()
+    {
+        std::unique_lock<std::mutex> guard(mutex_);
+        const uint64_t ticket = next_ticket_++;
+        cv_.wait(guard, [&] { return now_serving_ == ticket; });
+    }
+
+    void unlock()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            ++now_serving_;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t next_ticket_ = 0;
+    uint64_t now_serving_ = 0;
+};
+
+/**
+ * @brief Split a request payload into its NUL-separated fields.
+ */
+std::vector<std::string> SplitFields(const std::vector<char>& payload)
+{
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (size_t i = 0; i < payload.size(); ++i)
+    {
+        if (payload[i] == '\0')
+        {
+            fields.emplace_back(payload.data() + start, i - start);
+            start = i + 1;
+        }
+    }
+    if (start < payload.size())
+    {
+        fields.emplace_back(payload.data() + start, payload.size() - start);
+    }
+    return fields;
+}
+
+/**
+ * @brief Connection thread plus a flag it raises when it is done.
+ */
+struct ClientThread
+{
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> done;
+};
+
+/**
+ * @brief Serve one client connection until it disconnects.
+ */
+void ServeClient(int fd, FairLock& device_lock, const ftdi::DaemonCommandFn& run_command)
+{
+    for (;;)
+    {
+        unsigned char length_buf[4];
+        if (!RecvAll(fd, length_buf, sizeof(length_buf)))
+        {
+            break;
+        }
+        const uint32_t length = GetBe32(length_buf);
+        if (length == 0 || length > kMaxRequestSize)
+        {
+            break;
+        }
+        std::vector<char> payload(length);
+        if (!RecvAll(fd, payload.data(), payload.size()))
+        {
+            break;
+        }
+
+        std::vector<std::string> fields = SplitFields(payload);
+        const std::string cwd = fields.front();
+        fields.erase(fields.begin());
+
+        int status = EXIT_FAILURE;
+        {
+            std::lock_guard<FairLock> turn(device_lock);
+
+            std::vector<char> daemon_cwd(4096);
+            const bool have_cwd = getcwd(daemon_cwd.data(), daemon_cwd.size()) != nullptr;
+
+            FrameStreamBuf out_buf(fd, 'O');
+            FrameStreamBuf err_buf(fd, 'E');
+            std::streambuf* saved_out = std::cout.rdbuf(&out_buf);
+            std::streambuf* saved_err = std::cerr.rdbuf(&err_buf);
+            // Commands may leave std::hex, fill characters etc. behind.
+            std::ios saved_out_fmt(nullptr);
+            std::ios saved_err_fmt(nullptr);
+            saved_out_fmt.copyfmt(std::cout);
+            saved_err_fmt.copyfmt(std::cerr);
+
+            if (chdir(cwd.c_str()) != 0)
+            {
+                std::cerr << "[Daemon] Cannot enter client directory '" << cwd << "': " << strerror(errno) << std::endl;
+            }
+            else
+            {
+                status = run_command(fields);
+            }
+
+            std::cout.flush();
+            std::cerr.flush();
+            std::cout.copyfmt(saved_out_fmt);
+            std::cerr.copyfmt(saved_err_fmt);
+            std::cout.rdbuf(saved_out);
+            std::cerr.rdbuf(saved_err);
+            if (have_cwd && chdir(daemon_cwd.data()) != 0)
+            {
+                std::cerr << "[Daemon] Cannot restore working directory: " << strerror(errno) << std::endl;
+            }
+        }
+
+        unsigned char status_buf[4];
+        PutBe32(status_buf, static_cast<uint32_t>(status));
+        if (!SendFrame(fd, 'X', status_buf, sizeof(status_buf)))
+        {
+            break;
+        }
+    }
+    close(fd);
+}
+
+bool FillSocketAddress(const std::string& path, struct sockaddr_un& addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        std::cerr << "[Daemon] Socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+#endif // !_WIN32
+
+} // namespace
+
+namespace ftdi {
+
+/**
+ * @copydoc ftdi::DefaultDaemonSocketPath
+ */
+std::string DefaultDaemonSocketPath()
+{
+#ifndef _WIN32
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir != nullptr && runtime_dir[0] != '\0')
+    {
+        return std::string(runtime_dir) + "/ftx.sock";
+    }
+    return "/tmp/ftx-" + std::to_string(getuid()) + ".sock";
+#else
+    return std::string();
+#endif
+}
+
+/**
+ * @copydoc ftdi::DoDaemon
+ */
+int DoDaemon(const std::string& socket_path, const DaemonCommandFn& run_command)
+{
+#ifdef _WIN32
+    (void)socket_path;
+    (void)run_command;
+    std::cerr << "[Daemon] Daemon mode is not supported on Windows." << std::endl;
+    return 1;
+#else
+    struct sockaddr_un addr;
+    if (!FillSocketAddress(socket_path, addr))
+    {
+        return 1;
+    }
+
+    // Refuse to steal the socket of a live daemon; remove a stale one.
+    const int probe_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe_fd >= 0)
+    {
+        const bool live = connect(probe_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+        close(probe_fd);
+        if (live)
+        {
+            std::cerr << "[Daemon] Another daemon is already listening on " << socket_path << std::endl;
+            return 1;
+        }
+    }
+    unlink(socket_path.c_str());
+
+    const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+        std::cerr << "[Daemon] socket creation failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    // Create the socket owner-only: a chmod after bind() would leave a window
+    // in which other local users can connect and drive the device.
+    const mode_t saved_umask = umask(0077);
+    const int bind_status = bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    const int bind_errno = errno;
+    umask(saved_umask);
+    if (bind_status < 0)
+    {
+        std::cerr << "[Daemon] bind failed: " << strerror(bind_errno) << std::endl;
+        close(listen_fd);
+        return 1;
+    }
+    chmod(socket_path.c_str(), S_IRUSR | S_IWUSR);
+    if (listen(listen_fd, 16) < 0)
+    {
+        std::cerr << "[Daemon] listen failed: " << strerror(errno) << std::endl;
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    std::cout << "[Daemon] listening on " << socket_path << std::endl;
+
+    FairLock device_lock;
+    std::vector<ClientThread> clients;
+    while (!g_interrupt_flag)
+    {
+        // Reap finished connection threads.
+        for (auto it = clients.begin(); it != clients.end();)
+        {
+            if (*it->done)
+            {
+                it->thread.join();
+                it = clients.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        struct pollfd pfd = {listen_fd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, kPollIntervalMs);
+        if (ready <= 0)
+        {
+            continue;
+        }
+        const int client_fd = accept(listen_fd, nullptr, nullptr);
+        if (client_fd < 0)
+        {
+            continue;
+        }
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::thread thread([client_fd, &device_lock, &run_command, done]() {
+            ServeClient(client_fd, device_lock, run_command);
+            *done = true;
+        });
+        clients.push_back({std::move(thread), done});
+    }
+
+    // Connection threads notice g_interrupt_flag within one poll period.
+    for (ClientThread& client : clients)
+    {
+        client.thread.join();
+    }
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    std::cout << "[Daemon] stopped" << std::endl;
+    return 0;
+#endif
+}
+
+/**
+ * @copydoc ftdi::DoDaemonClient
+ */
+int DoDaemonClient(const std::string& socket_path, const std::vector<std::string>& args)
+{
+#ifdef _WIN32
+    (void)socket_path;
+    (void)args;
+    std::cerr << "[Daemon] Client mode is not supported on Windows." << std::endl;
+    return EXIT_FAILURE;
+#else
+    struct sockaddr_un addr;
+    if (!FillSocketAddress(socket_path, addr))
+    {
+        return EXIT_FAILURE;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        std::cerr << "[Daemon] Cannot connect to " << socket_path << ": " << strerror(errno)
+                  << " (is 'ftx --daemon' running?)" << std::endl;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return EXIT_FAILURE;
+    }
+
+    std::vector<char> cwd(4096);
+    if (getcwd(cwd.data(), cwd.size()) == nullptr)
+    {
+        std::cerr << "[Daemon] Cannot determine working directory: " << strerror(errno) << std::endl;
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    std::string payload(cwd.data());
+    for (const std::string& arg : args)
+    {
+        payload.push_back('\0');
+        payload += arg;
+    }
+    unsigned char length_buf[4];
+    PutBe32(length_buf, static_cast<uint32_t>(payload.size()));
+    if (payload.size() > kMaxRequestSize || !SendAll(fd, length_buf, sizeof(length_buf)) ||
+        !SendAll(fd, payload.data(), payload.size()))
+    {
+        std::cerr << "[Daemon] Failed to send request" << std::endl;
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_FAILURE;
+    for (;;)
+    {
+        unsigned char header[5];
+        if (!RecvAll(fd, header, sizeof(header)))
+        {
+            std::cerr << "[Daemon] Connection to daemon lost" << std::endl;
+            break;
+        }
+        std::vector<char> data(GetBe32(header + 1));
+        if (!data.empty() && !RecvAll(fd, data.data(), data.size()))
+        {
+            std::cerr << "[Daemon] Connection to daemon lost" << std::endl;
+            break;
+        }
+
+        if (header[0] == 'O')
+        {
+            std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+            std::cout.flush();
+        }
+        else if (header[0] == 'E')
+        {
+            std::cerr.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        else if (header[0] == 'X' && data.size() == 4)
+        {
+            status = static_cast<int>(GetBe32(reinterpret_cast<const unsigned char*>(data.data())));
+            break;
+        }
+    }
+    close(fd);
+    return status;
+#endif
+}
+
+} // namespace ftdi
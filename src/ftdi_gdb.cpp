@@ -1,12 +1,22 @@
 /**
  * @file ftdi_gdb.cpp
  * @brief Implementation of TCP↔FTDI proxy server for GDB/debugger integration.
- * @details Provides transparent byte forwarding with optional RSP packet tracing,
- *          adaptive USB write retry, and robust EINTR handling.
+ * @details Forwards whole RSP frames, batching each direction into one write and
+ *          handling acks on the host, with optional RSP packet tracing,
+ *          adaptive USB write retry, and robust EINTR handling. A USB reader
+ *          thread wakes the proxy loop as soon as target bytes arrive, so
+ *          neither direction waits on a polling interval. An optional page
+ *          cache answers repeated memory reads without a target round trip,
+ *          and bulk memory writes can be sent as native uploads. Extra
+ *          clients can attach read-only next to the debugger and have their
+ *          memory and register reads interleaved with its packets.
  */
 
 #include "ftdi.hpp"
 #include "log.hpp"
+#include "saturn.hpp"
+#include "transport.hpp"
+#include "xfer.hpp"
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -18,6 +28,7 @@ static inline int socket_close(int s) { return closesocket(static_cast<SOCKET>(s
 #else
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -28,8 +39,21 @@ static inline int socket_close(int s) { return close(s); }
 
 #include <cerrno>
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace {
 
@@ -81,33 +105,37 @@ bool write_all_socket(int fd, const unsigned char* data, size_t len)
  * @brief Write data to FTDI device with adaptive chunking and retries.
  *
  * Implements robust USB write with the following features:
- * - Sends in chunks (initial: 64 bytes, adaptive: 32, 16, 8, 1)
+ * - Sends the whole buffer in one write (up to 4 KB per chunk)
  * - Up to 3 retry attempts per chunk with 1ms delay
- * - Automatic chunk size reduction on transient failures
+ * - Automatic chunk size reduction (halving down to 1 byte) on transient failures
  * - Recovery to larger chunks after successful writes
  * - Returns actual bytes written for partial-failure detection
  *
- * The chunk size backoff strategy handles transient USB bulk write failures
- * common in FTDI devices by reducing chunk size before retrying, then
- * recovering to larger chunks for throughput.
+ * The proxy hands over every complete RSP frame of a batch at once, so a
+ * packet and its ack normally cost a single bulk transfer. The chunk size
+ * backoff strategy handles transient USB bulk write failures common in FTDI
+ * devices by reducing chunk size before retrying, then recovering to larger
+ * chunks for throughput.
  *
- * @param[in] dev FTDI device context.
+ * @param[in] link Cartridge transport.
  * @param[in] data Pointer to data buffer.
  * @param[in] len Number of bytes to send.
  * @param[out] written_out If non-null, receives actual bytes written (even on failure).
  * @return true if all bytes were sent, false if write failed.
  * @note On partial failure, `written_out` contains bytes successfully written.
  * @note Generates debug traces prefixed with `[TCPProxy][dbg]`.
- * @note Calls ftdi_tcioflush() and usleep() on retries.
+ * @note Sleeps with usleep() before retries. The link is not purged: the
+ *       TargetReader thread may be reading, and its bytes must not be lost.
  */
-bool write_all_ftdi(struct ftdi_context* dev, const unsigned char* data, size_t len, size_t* written_out)
+bool write_all_ftdi(transport::Transport& link, const unsigned char* data, size_t len, size_t* written_out)
 {
-    constexpr size_t kInitialUsbChunkSize = 64;
+    constexpr size_t kMaxUsbChunkSize = 4096;
     constexpr int kMaxWriteRetries = 3;
     constexpr useconds_t kRetryDelayUs = 1000;
 
     cdbg << "[TCPProxy][dbg] ftdi write begin bytes=" << len << std::endl;
-    size_t max_chunk_size = kInitialUsbChunkSize;
+    const size_t initial_chunk_size = std::max<size_t>(1, std::min(kMaxUsbChunkSize, len));
+    size_t max_chunk_size = initial_chunk_size;
     size_t written_total = 0;
     while (written_total < len)
     {
@@ -118,131 +146,1504 @@ bool write_all_ftdi(struct ftdi_context* dev, const unsigned char* data, size_t
         bool wrote_chunk = false;
         for (int attempt = 0; attempt < kMaxWriteRetries; ++attempt)
         {
-            const int n = ftdi_write_data(dev,
-                                          const_cast<unsigned char*>(data + written_total),
-                                          static_cast<int>(chunk));
-            if (n > 0)
+            if (link.Write(data + written_total, chunk))
             {
-                written_total += static_cast<size_t>(n);
+                written_total += chunk;
                 wrote_chunk = true;
-                cdbg << "[TCPProxy][dbg] ftdi write chunk success n=" << n
+                cdbg << "[TCPProxy][dbg] ftdi write chunk success n=" << chunk
                      << " total=" << written_total << "/" << len << std::endl;
                 break;
             }
 
-            // Some devices transiently fail bulk writes; purge TX and retry.
-            if (n < 0)
+            // Some devices transiently fail bulk writes; retry after a pause.
+            cdbg << "[TCPProxy][dbg] ftdi write failed attempt=" << (attempt + 1)
+                 << "/" << kMaxWriteRetries << " err='" << link.LastError()
+                 << "', retrying" << std::endl;
+            usleep(kRetryDelayUs);
+        }
+
+        if (!wrote_chunk)
+        {
+            if (max_chunk_size > 1)
+            {
+                max_chunk_size = std::max<size_t>(1, max_chunk_size / 2);
+                cdbg << "[TCPProxy][dbg] reducing write chunk size to "
+                     << max_chunk_size << " and retrying" << std::endl;
+                continue;
+            }
+
+            cdbg << "[TCPProxy][dbg] ftdi write failed after retries at minimum chunk size" << std::endl;
+            if (written_out != nullptr)
+            {
+                *written_out = written_total;
+            }
+            return false;
+        }
+
+        // Recover chunk size after successful writes so throughput remains high.
+        if (max_chunk_size < initial_chunk_size)
+        {
+            max_chunk_size = std::min(initial_chunk_size, max_chunk_size * 2);
+        }
+    }
+    cdbg << "[TCPProxy][dbg] ftdi write complete bytes=" << written_total << std::endl;
+    if (written_out != nullptr)
+    {
+        *written_out = written_total;
+    }
+    return true;
+}
+
+/**
+ * @brief Splits an RSP (Remote Serial Protocol) byte stream into frames.
+ *
+ * **Frame Kinds**:
+ * - RSP packet: `$...(payload)...#XX` (checksum is two hex digits)
+ * - ACK: single `+` byte (console output unless an ack is expected)
+ * - NAK: single `-` byte (likewise)
+ * - Interrupt: single 0x03 byte
+ * - Any other run of bytes (e.g. console output) is passed on as one frame
+ *
+ * Bytes of a packet split across receive calls stay buffered until the
+ * packet is complete, so frames are never forwarded in pieces.
+ */
+class RspFramer
+{
+public:
+    /**
+     * @brief Append received bytes.
+     */
+    void feed(const unsigned char* data, size_t len)
+    {
+        carry_.append(reinterpret_cast<const char*>(data), len);
+    }
+
+    /**
+     * @brief Take the next complete frame.
+     * @param[out] frame Receives the frame bytes.
+     * @return false if no complete frame is buffered.
+     */
+    bool next(std::string& frame)
+    {
+        if (carry_.empty())
+        {
+            return false;
+        }
+
+        size_t len = 0;
+        const char first = carry_[0];
+        if (first == '$')
+        {
+            const size_t hash = carry_.find('#', 1);
+            if (hash == std::string::npos || hash + 2 >= carry_.size())
+            {
+                return false;
+            }
+            len = hash + 3;
+        }
+        else if (first == '+' || first == '-' || first == '\x03')
+        {
+            len = 1;
+        }
+        else
+        {
+            len = carry_.find_first_of("$+-\x03", 1);
+            if (len == std::string::npos)
+            {
+                len = carry_.size();
+            }
+        }
+
+        frame.assign(carry_, 0, len);
+        carry_.erase(0, len);
+        return true;
+    }
+
+    /**
+     * @brief Drop buffered bytes.
+     */
+    void reset()
+    {
+        carry_.clear();
+    }
+
+private:
+    std::string carry_;
+};
+
+/**
+ * @brief Check the two-digit checksum of an RSP packet frame.
+ */
+bool rsp_checksum_ok(const std::string& packet)
+{
+    const size_t hash = packet.size() - 3;
+    unsigned int sum = 0;
+    for (size_t i = 1; i < hash; ++i)
+    {
+        sum += static_cast<unsigned char>(packet[i]);
+    }
+    return std::strtoul(packet.substr(hash + 1).c_str(), nullptr, 16) == (sum & 0xFFu);
+}
+
+/**
+ * @brief Payload of an RSP packet frame (between `$` and `#`).
+ */
+std::string rsp_payload(const std::string& packet)
+{
+    return packet.substr(1, packet.size() - 4);
+}
+
+/**
+ * @brief Build an RSP packet frame around a payload.
+ */
+std::string make_rsp_packet(const std::string& payload)
+{
+    static const char kHex[] = "0123456789abcdef";
+    unsigned int sum = 0;
+    for (const char c : payload)
+    {
+        sum += static_cast<unsigned char>(c);
+    }
+    std::string packet = "$" + payload + "#";
+    packet += kHex[(sum >> 4) & 0xFu];
+    packet += kHex[sum & 0xFu];
+    return packet;
+}
+
+/**
+ * @brief Parse the `addr,length` arguments of a memory packet.
+ * @param[in] args Packet payload after the command letter.
+ * @param[out] address Start address.
+ * @param[out] length Number of bytes.
+ * @return false if the arguments are malformed or the range wraps.
+ */
+bool parse_memory_range(const std::string& args, uint32_t& address, uint32_t& length)
+{
+    char* end = nullptr;
+    const unsigned long parsed_address = std::strtoul(args.c_str(), &end, 16);
+    if (end == args.c_str() || *end != ',')
+    {
+        return false;
+    }
+    const char* length_start = end + 1;
+    const unsigned long parsed_length = std::strtoul(length_start, &end, 16);
+    if (end == length_start || (*end != '\0' && *end != ':' && *end != ';'))
+    {
+        return false;
+    }
+    if (parsed_address > 0xFFFFFFFFul || parsed_length > 0xFFFFFFFFul - parsed_address)
+    {
+        return false;
+    }
+    address = static_cast<uint32_t>(parsed_address);
+    length = static_cast<uint32_t>(parsed_length);
+    return true;
+}
+
+/**
+ * @brief Proxy-side cache of target memory read through `m` packets.
+ *
+ * Memory is cached in kPageSize pages per SH-2 address, so the cached and
+ * cache-through mirrors of an area are kept apart. Only two kinds of
+ * regions are cached:
+ * - the BIOS ROM (saturn::bios_address), which never changes, so its pages
+ *   live as long as the proxy;
+ * - the low and high work RAM, whose pages are only valid while the target
+ *   is stopped and are dropped on every resume and stop.
+ *
+ * Everything else (VDP and sound memory, I/O registers, the cartridge
+ * area) can change while the CPU is halted and is always read from the
+ * target. Writes through `M`, `X` and breakpoint packets drop the pages
+ * they touch in every region.
+ *
+ * The cache also keeps the register snapshot (`g` reply) of the stopped
+ * target, dropped with the work RAM and by register writes.
+ */
+class MemoryCache
+{
+public:
+    /**
+     * @brief Cache granule in bytes.
+     * @details Small enough that a widened read stays well below the packet
+     *          size of stubs with small buffers.
+     */
+    static constexpr uint32_t kPageSize = 32;
+
+    /**
+     * @brief Caching policy of a memory range.
+     */
+    enum class Region
+    {
+        UNCACHED, ///< Always read from the target
+        ROM,      ///< Never changes
+        RAM       ///< Valid while the target is stopped
+    };
+
+    /**
+     * @brief Policy of a range, UNCACHED unless it lies in one cached region.
+     */
+    static Region region_of(uint32_t address, uint32_t length)
+    {
+        // Only the cached (0x0...) and cache-through (0x2...) areas map memory.
+        if (length == 0 || (address >> 29) > 1)
+        {
+            return Region::UNCACHED;
+        }
+        const uint32_t physical = address & ~saturn::cache_through_bit;
+        const auto inside = [&](uint32_t base, std::size_t size) {
+            return physical >= base && physical - base + length <= size;
+        };
+        if (inside(saturn::bios_address, saturn::bios_size))
+        {
+            return Region::ROM;
+        }
+        if (inside(saturn::work_ram_low_address, saturn::work_ram_low_size) ||
+            inside(saturn::work_ram_high_address, saturn::work_ram_high_size))
+        {
+            return Region::RAM;
+        }
+        return Region::UNCACHED;
+    }
+
+    /**
+     * @brief Read a range entirely from cached pages.
+     * @param[out] hex Receives the bytes as lowercase hex, as in an `m` reply.
+     * @return false unless every page of the range is cached.
+     */
+    bool lookup(uint32_t address, uint32_t length, std::string& hex) const
+    {
+        static const char kHex[] = "0123456789abcdef";
+        hex.clear();
+        hex.reserve(static_cast<size_t>(length) * 2);
+        for (uint32_t offset = 0; offset < length;)
+        {
+            const uint32_t current = address + offset;
+            const auto page = pages_.find(current & ~(kPageSize - 1));
+            if (page == pages_.end())
+            {
+                return false;
+            }
+            const uint32_t in_page = current & (kPageSize - 1);
+            const uint32_t count = std::min(kPageSize - in_page, length - offset);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint8_t value = page->second[in_page + i];
+                hex += kHex[value >> 4];
+                hex += kHex[value & 0xFu];
+            }
+            offset += count;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Store the whole pages covered by an `m` reply.
+     * @param address Start address of the read.
+     * @param hex Reply payload (two hex digits per byte).
+     */
+    void store(uint32_t address, const std::string& hex)
+    {
+        const uint32_t length = static_cast<uint32_t>(hex.size() / 2);
+        uint32_t page = (address + kPageSize - 1) & ~(kPageSize - 1);
+        for (; page >= address && page - address + kPageSize <= length; page += kPageSize)
+        {
+            std::vector<uint8_t> bytes(kPageSize);
+            for (uint32_t i = 0; i < kPageSize; ++i)
+            {
+                const size_t at = static_cast<size_t>(page - address + i) * 2;
+                bytes[i] = static_cast<uint8_t>(std::strtoul(hex.substr(at, 2).c_str(), nullptr, 16));
+            }
+            pages_[page] = std::move(bytes);
+        }
+    }
+
+    /**
+     * @brief Drop the pages overlapping a written range, whatever the region.
+     * @details Pages are keyed by the address they were read at, so the
+     *          range is dropped in both the cached and the cache-through
+     *          mirror.
+     */
+    void invalidate(uint32_t address, uint32_t length)
+    {
+        if (length == 0)
+        {
+            return;
+        }
+        for (const uint32_t mirror : {address, address ^ saturn::cache_through_bit})
+        {
+            const uint32_t first = mirror & ~(kPageSize - 1);
+            const uint32_t last = (mirror + (length - 1)) & ~(kPageSize - 1);
+            pages_.erase(pages_.lower_bound(first), pages_.upper_bound(last));
+        }
+    }
+
+    /**
+     * @brief Drop every page that can change while the target runs.
+     */
+    void invalidate_ram()
+    {
+        registers.clear();
+        for (auto it = pages_.begin(); it != pages_.end();)
+        {
+            if (region_of(it->first, kPageSize) == Region::ROM)
+            {
+                ++it;
+            }
+            else
+            {
+                it = pages_.erase(it);
+            }
+        }
+    }
+
+    std::string registers;    ///< `g` reply payload, empty when unknown
+    unsigned long hits = 0;   ///< Reads answered from the cache
+    unsigned long misses = 0; ///< Cacheable reads sent to the target
+
+private:
+    std::map<uint32_t, std::vector<uint8_t>> pages_; ///< Page address -> kPageSize bytes
+};
+
+/**
+ * @brief `m` request sent to the target on behalf of the cache.
+ */
+struct PendingMemoryRead
+{
+    bool active = false;        ///< A reply is expected
+    uint32_t address = 0;       ///< Range GDB asked for
+    uint32_t length = 0;
+    uint32_t fetch_address = 0; ///< Page-aligned range requested from the target
+    uint32_t fetch_length = 0;
+};
+
+/**
+ * @brief Packet size assumed until the target advertises one in qSupported.
+ * @details GDB's own default for stubs that do not report PacketSize.
+ */
+constexpr size_t kDefaultRspPacketSize = 400;
+
+/**
+ * @brief Smallest `M`/`X` write that starts a native upload block.
+ * @details Smaller writes (variables, breakpoints) keep going through the
+ *          stub so GDB sees its real answer.
+ */
+constexpr uint32_t kLoadMinBytes = 64;
+
+/**
+ * @brief Largest native upload block collected from GDB writes.
+ */
+constexpr size_t kLoadBlockMaxBytes = 1024 * 1024;
+
+/**
+ * @brief Uploads a memory block to the target outside RSP.
+ * @return false if the upload failed.
+ */
+using LoadUploadFn = std::function<bool(uint32_t address, const std::string& data)>;
+
+/**
+ * @brief Most clients served at once: one primary, the rest read-only.
+ */
+constexpr size_t kMaxClients = 8;
+
+/**
+ * @brief Longest wait for the target's reply before the next request goes out.
+ * @details GDB's default remote timeout.
+ */
+constexpr int kReplyTimeoutMs = 2000;
+
+/**
+ * @brief How long the next request is held after a reply timeout.
+ * @details A late reply within this window is dropped, so it is not taken
+ *          for the reply to the next request; after it the target is
+ *          assumed to have lost the request.
+ */
+constexpr int kLateReplyGraceMs = 1000;
+
+/**
+ * @brief One connected debugger or memory-watch client.
+ *
+ * The first client of a session is the primary: it owns the target and may
+ * resume it, write memory and registers. Clients connecting while it is
+ * attached are read-only secondaries (see classify_secondary_packet()).
+ */
+struct RspClient
+{
+    int fd = -1;                    ///< Client socket
+    bool primary = false;           ///< Full control of the target
+    bool alive = true;              ///< False once the client must be closed
+    bool connected = true;          ///< False once the peer hung up
+    std::string trace_prefix;       ///< `GDB>` for the primary, `GDB#<fd>>` otherwise
+    RspFramer from_client;          ///< Client -> target stream
+    std::string to_client;          ///< Frames batched for one socket write
+    std::string last_to_client;     ///< Last packet sent to the client (for NAKs)
+    bool no_ack = false;            ///< No-ack mode in effect with this client
+};
+
+/**
+ * @brief Forwarding state of one proxy session (the target side).
+ *
+ * The proxy acknowledges both sides itself, so an ack never needs a USB
+ * transfer of its own and GDB's acks are not forwarded at all:
+ * - A GDB packet is acked (or NAKed on a bad checksum) by the proxy as soon
+ *   as it is complete; the target's ack for it is dropped, and a target NAK
+ *   makes the proxy resend the packet.
+ * - A target packet is acked (or NAKed) by the proxy before it is passed to
+ *   GDB; GDB's ack is dropped, and a GDB NAK is answered from the copy of
+ *   the last packet sent to it. A stub that sent a reply only waits for the
+ *   next command, so its ack is held back and sent in front of the next
+ *   packet; console output (`O` packets) lets the program resume and is
+ *   acked at once, and a held ack goes out alone after kAckHoldMs.
+ *
+ * Once the target answers the primary's `QStartNoAckMode` with `OK`,
+ * neither side sends acks anymore and the proxy stops generating them too.
+ *
+ * The stub serves one request at a time, so client packets wait in
+ * RspProxyState::waiting until the target is free, the primary's first.
+ * The reply goes back to the client that sent the request; while the
+ * target runs, everything it sends goes to the primary.
+ */
+struct RspProxyState
+{
+    RspFramer from_target;          ///< target -> GDB stream
+    std::string to_target;          ///< Frames batched for one USB write
+    std::string last_to_target;     ///< Last packet sent to the target (for NAKs)
+    bool no_ack_requested = false;  ///< QStartNoAckMode awaiting the target reply
+    bool no_ack = false;            ///< No-ack mode in effect with the target
+    bool ack_expected = false;      ///< The target owes an ack for last_to_target
+    bool ack_held = false;          ///< Target ack waiting for the next packet
+    std::chrono::steady_clock::time_point ack_deadline; ///< When a held ack goes out alone
+    MemoryCache* memory_cache = nullptr; ///< Shared page cache, nullptr when disabled
+    PendingMemoryRead pending_read;      ///< Cache fill awaiting the target reply
+    size_t packet_size = kDefaultRspPacketSize; ///< Largest packet the target accepts
+    LoadUploadFn upload;            ///< Native upload of load blocks, empty when disabled
+    uint32_t load_address = 0;      ///< Target address of load_block
+    std::string load_block;         ///< GDB writes acknowledged but not uploaded yet
+    bool load_failed = false;       ///< An upload failed outside a primary write; owed to the primary as E01
+    RspClient* primary = nullptr;   ///< Client in control, nullptr once it left
+    RspClient* owner = nullptr;     ///< Client waiting for the current reply
+    bool awaiting_reply = false;    ///< A request is outstanding on the target
+    std::string request;            ///< Payload of the outstanding request
+    std::chrono::steady_clock::time_point reply_deadline; ///< When the request is given up
+    bool late_reply = false;        ///< The timed-out request may still be answered
+    std::chrono::steady_clock::time_point late_reply_deadline; ///< When a late reply is no longer expected
+    bool running = false;           ///< Resumed by the primary, until a stop reply
+    std::deque<std::pair<RspClient*, std::string>> waiting; ///< Packets held until the target is free
+    std::string stop_reply;         ///< Payload of the last stop reply
+};
+
+/**
+ * @brief Longest time a target ack waits for the next packet.
+ */
+constexpr int kAckHoldMs = 10;
+
+/**
+ * @brief Move a held target ack into the USB batch.
+ */
+void release_target_ack(RspProxyState& state)
+{
+    if (state.ack_held)
+    {
+        state.to_target += '+';
+        state.ack_held = false;
+    }
+}
+
+/**
+ * @brief Check whether a packet resumes the target.
+ */
+bool is_resume_packet(const std::string& payload)
+{
+    return (!payload.empty() && std::strchr("cCsSiI", payload[0]) != nullptr) ||
+           payload.compare(0, 6, "vCont;") == 0;
+}
+
+/**
+ * @brief Check whether a packet is a stop reply (`S`, `T`, `W` or `X` and a
+ *        two-digit signal or exit code).
+ */
+bool is_stop_reply(const std::string& payload)
+{
+    return payload.size() >= 3 && std::strchr("STWX", payload[0]) != nullptr &&
+           std::isxdigit(static_cast<unsigned char>(payload[1])) &&
+           std::isxdigit(static_cast<unsigned char>(payload[2]));
+}
+
+/**
+ * @brief Drop the cached memory and registers a primary packet may change.
+ * @details Writes and breakpoints drop the pages they touch, register
+ *          writes drop the register snapshot, and resuming, detaching,
+ *          killing or resetting the target drops work RAM.
+ */
+void invalidate_for_packet(MemoryCache& cache, const std::string& payload)
+{
+    uint32_t address = 0;
+    uint32_t length = 0;
+    switch (payload.empty() ? '\0' : payload[0])
+    {
+    case 'M':
+    case 'X':
+        if (parse_memory_range(payload.substr(1), address, length))
+        {
+            cache.invalidate(address, length);
+        }
+        break;
+    case 'Z':
+    case 'z':
+        // Z<type>,<addr>,<kind>: software breakpoints patch memory.
+        if (payload.size() > 2 && parse_memory_range(payload.substr(3), address, length))
+        {
+            cache.invalidate(address, length);
+        }
+        break;
+    case 'G':
+    case 'P':
+        cache.registers.clear();
+        break;
+    case 'D':
+    case 'k':
+    case 'r':
+    case 'R':
+        cache.invalidate_ram();
+        break;
+    default:
+        if (is_resume_packet(payload))
+        {
+            cache.invalidate_ram();
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Answer a memory or register read from the cache.
+ * @param[out] answer Receives the reply packet on a hit.
+ * @return true on a hit.
+ */
+bool lookup_cached_read(RspProxyState& state, const std::string& payload, std::string& answer)
+{
+    MemoryCache& cache = *state.memory_cache;
+    if (payload == "g")
+    {
+        if (cache.registers.empty())
+        {
+            return false;
+        }
+        ++cache.hits;
+        answer = make_rsp_packet(cache.registers);
+        return true;
+    }
+
+    uint32_t address = 0;
+    uint32_t length = 0;
+    std::string hex;
+    if (payload.empty() || payload[0] != 'm' || !parse_memory_range(payload.substr(1), address, length) ||
+        MemoryCache::region_of(address, length) == MemoryCache::Region::UNCACHED ||
+        !cache.lookup(address, length, hex))
+    {
+        return false;
+    }
+    ++cache.hits;
+    answer = make_rsp_packet(hex);
+    return true;
+}
+
+/**
+ * @brief Prepare a cacheable `m` read that missed the cache.
+ * @details The read is widened to whole pages, if the reply still fits the
+ *          target's packet size, and recorded in RspProxyState::pending_read.
+ * @param[in,out] packet Packet sent to the target; replaced by the widened read.
+ */
+void prepare_cached_read(RspProxyState& state, std::string& packet)
+{
+    state.pending_read.active = false;
+    const std::string payload = rsp_payload(packet);
+    uint32_t address = 0;
+    uint32_t length = 0;
+    if (payload.empty() || payload[0] != 'm' || !parse_memory_range(payload.substr(1), address, length) ||
+        MemoryCache::region_of(address, length) == MemoryCache::Region::UNCACHED)
+    {
+        return;
+    }
+
+    ++state.memory_cache->misses;
+    PendingMemoryRead& pending = state.pending_read;
+    pending.active = true;
+    pending.address = address;
+    pending.length = length;
+    pending.fetch_address = address & ~(MemoryCache::kPageSize - 1);
+    pending.fetch_length = ((address + length + MemoryCache::kPageSize - 1) & ~(MemoryCache::kPageSize - 1)) - pending.fetch_address;
+    // '$', '#' and the checksum frame the hex reply.
+    if (static_cast<size_t>(pending.fetch_length) * 2 + 4 > state.packet_size)
+    {
+        pending.fetch_address = address;
+        pending.fetch_length = length;
+        return;
+    }
+
+    char widened[32];
+    std::snprintf(widened, sizeof(widened), "m%x,%x", pending.fetch_address, pending.fetch_length);
+    packet = make_rsp_packet(widened);
+}
+
+/**
+ * @brief Apply a target packet to the memory cache.
+ * @details Stop replies drop work RAM, qSupported replies update the
+ *          packet size, the reply to a pending read fills the cache and the
+ *          reply to `g` becomes the register snapshot.
+ * @param[in,out] packet Target packet; a widened read reply is cut back to
+ *                the range GDB asked for.
+ */
+void apply_target_packet_to_cache(RspProxyState& state, std::string& packet)
+{
+    MemoryCache& cache = *state.memory_cache;
+    const std::string payload = rsp_payload(packet);
+
+    const size_t packet_size_at = payload.find("PacketSize=");
+    if (packet_size_at != std::string::npos)
+    {
+        const unsigned long advertised = std::strtoul(payload.c_str() + packet_size_at + 11, nullptr, 16);
+        if (advertised > 0)
+        {
+            state.packet_size = advertised;
+        }
+    }
+
+    const bool hex_reply = !payload.empty() &&
+                           payload.find_first_not_of("0123456789abcdefABCDEFx") == std::string::npos;
+    if (state.pending_read.active)
+    {
+        PendingMemoryRead& pending = state.pending_read;
+        pending.active = false;
+        if (payload.size() != static_cast<size_t>(pending.fetch_length) * 2 || !hex_reply ||
+            payload.find('x') != std::string::npos)
+        {
+            // Error or short read: GDB gets the target's answer as is.
+            return;
+        }
+        cache.store(pending.fetch_address, payload);
+        if (pending.fetch_address != pending.address || pending.fetch_length != pending.length)
+        {
+            const size_t skip = static_cast<size_t>(pending.address - pending.fetch_address) * 2;
+            packet = make_rsp_packet(payload.substr(skip, static_cast<size_t>(pending.length) * 2));
+        }
+        return;
+    }
+
+    // Unavailable registers read as "xx".
+    if (state.request == "g" && hex_reply)
+    {
+        cache.registers = payload;
+        return;
+    }
+
+    if (is_stop_reply(payload))
+    {
+        cache.invalidate_ram();
+    }
+}
+
+/**
+ * @brief Decode the address and data of an `M` or `X` packet payload.
+ * @return false for other packets and malformed writes.
+ */
+bool decode_memory_write(const std::string& payload, uint32_t& address, std::string& data)
+{
+    uint32_t length = 0;
+    const size_t colon = payload.find(':');
+    if (payload.empty() || (payload[0] != 'M' && payload[0] != 'X') || colon == std::string::npos ||
+        !parse_memory_range(payload.substr(1), address, length))
+    {
+        return false;
+    }
+
+    data.clear();
+    if (payload[0] == 'M')
+    {
+        if (payload.size() - colon - 1 != static_cast<size_t>(length) * 2 ||
+            payload.find_first_not_of("0123456789abcdefABCDEF", colon + 1) != std::string::npos)
+        {
+            return false;
+        }
+        for (size_t i = colon + 1; i < payload.size(); i += 2)
+        {
+            data += static_cast<char>(std::strtoul(payload.substr(i, 2).c_str(), nullptr, 16));
+        }
+    }
+    else
+    {
+        for (size_t i = colon + 1; i < payload.size(); ++i)
+        {
+            // '}' escapes '#', '$', '}' and '*': the next byte is XORed with 0x20.
+            if (payload[i] == '}' && i + 1 < payload.size())
+            {
+                data += static_cast<char>(payload[++i] ^ 0x20);
+            }
+            else
+            {
+                data += payload[i];
+            }
+        }
+    }
+    return data.size() == length;
+}
+
+/**
+ * @brief Upload the collected load block, if any.
+ * @details Must only be called while the target is free. A failure is
+ *          logged and recorded in RspProxyState::load_failed, and the
+ *          block's pages leave the cache.
+ * @return false if the upload failed; the block is dropped either way.
+ */
+bool flush_load_block(RspProxyState& state)
+{
+    if (state.load_block.empty())
+    {
+        return true;
+    }
+    const bool ok = state.upload(state.load_address, state.load_block);
+    if (!ok)
+    {
+        std::cerr << "[TCPProxy] native upload of " << state.load_block.size()
+                  << " bytes to 0x" << std::hex << state.load_address << std::dec
+                  << " failed" << std::endl;
+        state.load_failed = true;
+    }
+    if (state.memory_cache != nullptr)
+    {
+        // Secondaries may have read the old contents meanwhile.
+        state.memory_cache->invalidate(state.load_address, static_cast<uint32_t>(state.load_block.size()));
+    }
+    state.load_block.clear();
+    return ok;
+}
+
+/**
+ * @brief Collect bulk memory writes from GDB into native uploads.
+ * @details `gdb load` sends a section as consecutive writes of one packet
+ *          each. Writes of at least kLoadMinBytes, and any write continuing
+ *          the current block, are acknowledged with `OK` at once and
+ *          appended to RspProxyState::load_block. The block is uploaded
+ *          with USBDC_FUNC_UPLOAD when a write does not continue it, when it
+ *          reaches kLoadBlockMaxBytes, and before any other packet reaches
+ *          the target, so the target never sees later commands first. A
+ *          failed upload is reported as `E01` to the packet that triggered it;
+ *          one triggered by a secondary read, an interrupt or a disconnect
+ *          is reported to the primary's next packet instead.
+ * @param[out] answer Receives the reply packet when the proxy answers.
+ * @return true if @p answer holds a reply and nothing goes to the target.
+ */
+bool apply_client_packet_to_load(RspProxyState& state, const std::string& packet, std::string& answer)
+{
+    uint32_t address = 0;
+    std::string data;
+    const bool is_write = decode_memory_write(rsp_payload(packet), address, data) && !data.empty();
+    const bool continues = is_write && !state.load_block.empty() &&
+                           address == state.load_address + state.load_block.size() &&
+                           state.load_block.size() + data.size() <= kLoadBlockMaxBytes;
+
+    if (state.load_failed || (!continues && !flush_load_block(state)))
+    {
+        state.load_failed = false;
+        answer = make_rsp_packet("E01");
+        return true;
+    }
+    if (!is_write || (!continues && data.size() < kLoadMinBytes))
+    {
+        return false;
+    }
+
+    if (state.load_block.empty())
+    {
+        state.load_address = address;
+    }
+    state.load_block += data;
+    if (state.memory_cache != nullptr)
+    {
+        state.memory_cache->invalidate(address, static_cast<uint32_t>(data.size()));
+    }
+    answer = make_rsp_packet("OK");
+    return true;
+}
+
+/**
+ * @brief What the proxy does with a packet from a read-only client.
+ */
+enum class SecondaryAction
+{
+    FORWARD, ///< Read request: serve from the cache or the target
+    REPLY,   ///< Answered by the proxy
+    DETACH   ///< Answered if a reply is set, then the client is closed
+};
+
+/**
+ * @brief Decide how a packet from a secondary client is served.
+ * @details Secondaries may read memory (`m`) and registers (`g`, `p`) and
+ *          ask for the stop reason (`?`, answered from the last stop reply
+ *          seen). The session queries GDB sends on attach are answered by
+ *          the proxy so they cannot change the stub's state; anything that
+ *          would write or resume the target is refused with `E01`.
+ * @param[out] reply Payload of the proxy's answer.
+ */
+SecondaryAction classify_secondary_packet(const RspProxyState& state, const std::string& payload, std::string& reply)
+{
+    const char command = payload.empty() ? '\0' : payload[0];
+    reply.clear();
+    if (command == 'm' || command == 'g' || command == 'p')
+    {
+        return SecondaryAction::FORWARD;
+    }
+    if (command == '?')
+    {
+        if (state.stop_reply.empty())
+        {
+            return SecondaryAction::FORWARD;
+        }
+        reply = state.stop_reply;
+        return SecondaryAction::REPLY;
+    }
+    if (payload.compare(0, 10, "qSupported") == 0)
+    {
+        char features[32];
+        std::snprintf(features, sizeof(features), "PacketSize=%zx", state.packet_size);
+        reply = features;
+        return SecondaryAction::REPLY;
+    }
+    if (payload == "QStartNoAckMode" || command == 'H' || command == 'T')
+    {
+        reply = "OK";
+        return SecondaryAction::REPLY;
+    }
+    if (payload == "qAttached")
+    {
+        reply = "1";
+        return SecondaryAction::REPLY;
+    }
+    if (command == 'D')
+    {
+        reply = "OK";
+        return SecondaryAction::DETACH;
+    }
+    if (command == 'k')
+    {
+        return SecondaryAction::DETACH;
+    }
+    if (command == 'q' || command == 'Q' || command == 'v')
+    {
+        // Empty reply: not supported.
+        return SecondaryAction::REPLY;
+    }
+    reply = "E01";
+    return SecondaryAction::REPLY;
+}
+
+/**
+ * @brief Print a traced RSP frame when verbose.
+ * @details Outputs `GDB>$qSupported:...#14` for client->device packets and
+ *          `Target>$OK#9d` for device->client packets, plus `+`/`-` acks.
+ */
+void trace_rsp_frame(const std::string& prefix, const std::string& frame, bool verbose)
+{
+    if (verbose && (frame[0] == '$' || frame[0] == '+' || frame[0] == '-'))
+    {
+        std::cout << prefix << frame << std::endl;
+    }
+}
+
+/**
+ * @brief Queue a packet answered by the proxy for a client.
+ */
+void reply_to_client(RspClient& client, const std::string& packet, const char* prefix, bool verbose)
+{
+    trace_rsp_frame(prefix, packet, verbose);
+    client.last_to_client = packet;
+    client.to_client += packet;
+}
+
+/**
+ * @brief Send waiting client packets to the target while it is free.
+ * @details Packets answered by the proxy (cache hits, collected load
+ *          writes) complete at once and the next one is taken; the first
+ *          packet that needs the target makes it busy until its reply.
+ */
+void dispatch_client_packets(RspProxyState& state, bool verbose)
+{
+    while (!state.awaiting_reply && !state.late_reply && !state.running && !state.waiting.empty())
+    {
+        auto next = std::find_if(state.waiting.begin(), state.waiting.end(),
+                                 [&](const std::pair<RspClient*, std::string>& entry) { return entry.first == state.primary; });
+        if (next == state.waiting.end())
+        {
+            next = state.waiting.begin();
+        }
+        RspClient& client = *next->first;
+        std::string frame = next->second;
+        state.waiting.erase(next);
+
+        const std::string payload = rsp_payload(frame);
+        std::string answer;
+        if (client.primary && state.upload && apply_client_packet_to_load(state, frame, answer))
+        {
+            reply_to_client(client, answer, "Load>", verbose);
+            continue;
+        }
+        if (state.memory_cache != nullptr)
+        {
+            if (client.primary)
+            {
+                invalidate_for_packet(*state.memory_cache, payload);
+            }
+            if (lookup_cached_read(state, payload, answer))
+            {
+                reply_to_client(client, answer, "Cache>", verbose);
+                continue;
+            }
+            prepare_cached_read(state, frame);
+        }
+
+        if (client.primary)
+        {
+            state.no_ack_requested = (payload == "QStartNoAckMode");
+        }
+        else if (state.upload)
+        {
+            // A secondary read must see the writes the primary got OK for.
+            (void)flush_load_block(state);
+        }
+        state.request = payload;
+        state.owner = &client;
+        if (is_resume_packet(payload))
+        {
+            state.running = true;
+        }
+        else if (payload == "k" || payload == "r" || payload.compare(0, 1, "R") == 0)
+        {
+            // Kill and reset may not be answered.
+            state.owner = nullptr;
+        }
+        else
+        {
+            state.awaiting_reply = true;
+            state.reply_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReplyTimeoutMs);
+        }
+        release_target_ack(state);
+        state.last_to_target = frame;
+        state.ack_expected = !state.no_ack;
+        state.to_target += frame;
+    }
+}
+
+/**
+ * @brief Queue the complete frames received from a client.
+ * @details Packets wait in RspProxyState::waiting until the target is
+ *          free; the primary's interrupts go to RspProxyState::to_target at
+ *          once. The proxy's acks, retransmissions and answers go to
+ *          RspClient::to_client.
+ */
+void handle_client_frames(RspProxyState& state, RspClient& client, const unsigned char* data, size_t len, bool verbose)
+{
+    client.from_client.feed(data, len);
+    std::string frame;
+    while (client.alive && client.from_client.next(frame))
+    {
+        trace_rsp_frame(client.trace_prefix, frame, verbose);
+        if (frame[0] == '+')
+        {
+            continue;
+        }
+        if (frame[0] == '-')
+        {
+            client.to_client += client.last_to_client;
+            continue;
+        }
+        if (frame[0] != '$')
+        {
+            if (!client.primary)
             {
-                cdbg << "[TCPProxy][dbg] ftdi write failed attempt=" << (attempt + 1)
-                     << "/" << kMaxWriteRetries << " err='" << ftdi_get_error_string(dev)
-                     << "', flushing and retrying" << std::endl;
-                (void)ftdi_tcioflush(dev);
-                usleep(kRetryDelayUs);
+                continue;
+            }
+            if (state.upload && !state.awaiting_reply && !state.running)
+            {
+                // An interrupt must not overtake writes GDB believes are done.
+                (void)flush_load_block(state);
             }
+            release_target_ack(state);
+            state.to_target += frame;
+            continue;
         }
 
-        if (!wrote_chunk)
+        if (!client.no_ack)
         {
-            if (max_chunk_size > 1)
+            if (!rsp_checksum_ok(frame))
             {
-                max_chunk_size = std::max<size_t>(1, max_chunk_size / 2);
-                cdbg << "[TCPProxy][dbg] reducing write chunk size to "
-                     << max_chunk_size << " and retrying" << std::endl;
+                client.to_client += '-';
                 continue;
             }
+            client.to_client += '+';
+        }
+        if (client.primary)
+        {
+            state.waiting.emplace_back(&client, frame);
+            continue;
+        }
 
-            cdbg << "[TCPProxy][dbg] ftdi write failed after retries at minimum chunk size" << std::endl;
-            if (written_out != nullptr)
+        const std::string payload = rsp_payload(frame);
+        std::string reply;
+        const SecondaryAction action = classify_secondary_packet(state, payload, reply);
+        if (action == SecondaryAction::FORWARD)
+        {
+            std::string answer;
+            if (state.memory_cache != nullptr && lookup_cached_read(state, payload, answer))
             {
-                *written_out = written_total;
+                reply_to_client(client, answer, "Cache>", verbose);
             }
-            return false;
+            else if (state.running && payload != "?")
+            {
+                // The stub does not answer while the program runs.
+                reply_to_client(client, make_rsp_packet("E01"), "Proxy>", verbose);
+            }
+            else
+            {
+                state.waiting.emplace_back(&client, frame);
+            }
+            continue;
+        }
+        if (action == SecondaryAction::REPLY || !reply.empty())
+        {
+            reply_to_client(client, make_rsp_packet(reply), "Proxy>", verbose);
+        }
+        if (payload == "QStartNoAckMode")
+        {
+            client.no_ack = true;
+        }
+        if (action == SecondaryAction::DETACH)
+        {
+            client.alive = false;
         }
+    }
+    dispatch_client_packets(state, verbose);
+}
 
-        // Recover chunk size after successful writes so throughput remains high.
-        if (max_chunk_size < kInitialUsbChunkSize)
+/**
+ * @brief Queue the complete frames received from the target.
+ * @details Packets and other output go to the RspClient::to_client of the
+ *          client they answer, the proxy's acks and retransmissions to
+ *          RspProxyState::to_target.
+ */
+void handle_target_frames(RspProxyState& state, const unsigned char* data, size_t len, bool verbose)
+{
+    state.from_target.feed(data, len);
+    std::string frame;
+    while (state.from_target.next(frame))
+    {
+        trace_rsp_frame("Target>", frame, verbose);
+        // Outside an expected ack, `+` and `-` are console output
+        if (frame[0] == '+' && state.ack_expected)
+        {
+            state.ack_expected = false;
+            continue;
+        }
+        if (frame[0] == '-' && state.ack_expected)
+        {
+            state.to_target += state.last_to_target;
+            continue;
+        }
+
+        RspClient* destination = state.primary;
+        if (frame[0] == '$')
+        {
+            // A reply implies the request got through, even if its ack was lost
+            state.ack_expected = false;
+            if (!state.no_ack)
+            {
+                if (!rsp_checksum_ok(frame))
+                {
+                    state.to_target += '-';
+                    continue;
+                }
+                // Decided before the no-ack switch: the OK itself is still acked
+                release_target_ack(state);
+                if (frame.size() > 1 && frame[1] == 'O' && frame != "$OK#9a")
+                {
+                    state.to_target += '+';
+                }
+                else
+                {
+                    state.ack_held = true;
+                    state.ack_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kAckHoldMs);
+                }
+            }
+            const std::string payload = rsp_payload(frame);
+            // Console output (O packets) never completes a request.
+            const bool output = payload.size() > 1 && payload[0] == 'O' && payload != "OK";
+            const bool stale = state.late_reply && !output;
+            if (state.no_ack_requested && !stale)
+            {
+                state.no_ack = (payload == "OK");
+                state.no_ack_requested = false;
+                if (state.primary != nullptr)
+                {
+                    state.primary->no_ack = state.no_ack;
+                }
+            }
+            if (state.memory_cache != nullptr && !stale)
+            {
+                apply_target_packet_to_cache(state, frame);
+            }
+
+            if (stale)
+            {
+                // The late reply to a timed-out request.
+                state.late_reply = false;
+                destination = nullptr;
+            }
+            else if (state.running)
+            {
+                state.running = !is_stop_reply(payload);
+            }
+            else if (state.awaiting_reply)
+            {
+                destination = state.owner;
+                state.awaiting_reply = output;
+            }
+            if (is_stop_reply(payload))
+            {
+                state.stop_reply = payload;
+            }
+            if (destination != nullptr)
+            {
+                destination->last_to_client = frame;
+            }
+        }
+        if (destination != nullptr)
+        {
+            destination->to_client += frame;
+        }
+        else
         {
-            max_chunk_size = std::min(kInitialUsbChunkSize, max_chunk_size * 2);
+            cdbg << "[TCPProxy][dbg] dropped target frame bytes=" << frame.size() << std::endl;
         }
     }
-    cdbg << "[TCPProxy][dbg] ftdi write complete bytes=" << written_total << std::endl;
-    if (written_out != nullptr)
+    dispatch_client_packets(state, verbose);
+}
+
+/**
+ * @brief Send the batched frames: one USB write and one write per client at most.
+ * @details A client whose socket write fails is marked for closing; clients
+ *          that hung up are skipped.
+ * @return false if the USB write failed.
+ */
+bool flush_rsp_batches(RspProxyState& state, transport::Transport& link,
+                       std::vector<std::unique_ptr<RspClient>>& clients)
+{
+    if (!state.to_target.empty())
     {
-        *written_out = written_total;
+        size_t bytes_forwarded = 0;
+        const auto* batch = reinterpret_cast<const unsigned char*>(state.to_target.data());
+        const bool ok = write_all_ftdi(link, batch, state.to_target.size(), &bytes_forwarded);
+        if (!ok)
+        {
+            std::cerr << "[TCPProxy] FTDI write failed after forwarding "
+                      << bytes_forwarded << "/" << state.to_target.size()
+                      << " bytes: " << link.LastError() << std::endl;
+        }
+        else
+        {
+            cdbg << "[TCPProxy][dbg] forwarded client->ftdi bytes=" << bytes_forwarded << std::endl;
+        }
+        state.to_target.clear();
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    for (const auto& client : clients)
+    {
+        if (client->to_client.empty() || !client->connected)
+        {
+            continue;
+        }
+        const auto* batch = reinterpret_cast<const unsigned char*>(client->to_client.data());
+        if (!write_all_socket(client->fd, batch, client->to_client.size()))
+        {
+            std::cerr << "[TCPProxy] socket write failed: " << strerror(errno) << std::endl;
+            client->alive = false;
+            client->connected = false;
+        }
+        client->to_client.clear();
     }
     return true;
 }
 
 /**
- * @brief Trace RSP (Remote Serial Protocol) packets with a prefix.
- *
- * Buffers incoming bytes and emits complete RSP packets or ACK/NAK bytes.
- * Uses a "carry" buffer to handle packets split across receive calls.
- *
- * **Packet Format**:
- * - RSP packet: `$...(payload)...#XX` (checksum is two hex digits)
- * - ACK: single `+` byte
- * - NAK: single `-` byte
- *
- * **Trace Output**:
- * When `verbose=true`, outputs to stdout:
- * - `GDB>$qSupported:...#14` for client→device packets
- * - `Target>$OK#9d` for device→client packets
+ * @brief Detach a client from the session before it is closed.
+ * @details Its waiting packets are dropped and a reply to its outstanding
+ *          request will be discarded. When the primary leaves, collected
+ *          load writes are uploaded and a held ack goes to the target: the
+ *          stub would take the next client's first byte as a NAK of its
+ *          last reply.
+ */
+void remove_client(RspProxyState& state, RspClient& client)
+{
+    state.waiting.erase(std::remove_if(state.waiting.begin(), state.waiting.end(),
+                                       [&](const std::pair<RspClient*, std::string>& entry) { return entry.first == &client; }),
+                        state.waiting.end());
+    if (state.owner == &client)
+    {
+        state.owner = nullptr;
+    }
+    if (state.primary == &client)
+    {
+        if (state.upload && !state.awaiting_reply && !state.running)
+        {
+            (void)flush_load_block(state);
+        }
+        release_target_ack(state);
+        state.primary = nullptr;
+    }
+}
+
+/**
+ * @brief Create a connected pair of local sockets.
+ * @details Used as a wakeup channel that poll() can watch next to the
+ *          client socket; WSAPoll only accepts sockets, so Windows builds
+ *          connect two loopback TCP sockets instead of using socketpair().
+ * @param[out] fds Receives the two socket descriptors.
+ * @return true on success.
+ */
+bool make_socket_pair(int fds[2])
+{
+#ifdef _WIN32
+    const int listener = static_cast<int>(socket(AF_INET, SOCK_STREAM, 0));
+    if (listener < 0)
+    {
+        return false;
+    }
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    int addr_len = sizeof(addr);
+    bool ok = bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 &&
+              getsockname(listener, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) == 0 &&
+              listen(listener, 1) == 0;
+    fds[0] = fds[1] = -1;
+    if (ok)
+    {
+        fds[1] = static_cast<int>(socket(AF_INET, SOCK_STREAM, 0));
+        ok = fds[1] >= 0 && connect(fds[1], reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+    if (ok)
+    {
+        fds[0] = static_cast<int>(accept(listener, nullptr, nullptr));
+        ok = fds[0] >= 0;
+    }
+    socket_close(listener);
+    if (!ok && fds[1] >= 0)
+    {
+        socket_close(fds[1]);
+    }
+    return ok;
+#else
+    return socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0;
+#endif
+}
+
+/**
+ * @brief Background reader draining the target side of the link.
  *
- * **Deduplication**: Partial packets remain in `carry` buffer until a complete
- * packet is formed, avoiding spam when network boundaries split packets.
+ * Transport::ReadSome() blocks for up to one USB latency period, which used
+ * to be paid in series with the client socket poll. The reader thread keeps
+ * a read outstanding at all times and hands the bytes to the proxy loop
+ * through a mutex-protected buffer; the first bytes of each batch also
+ * write one byte to a wakeup socket the loop polls next to the client, so
+ * target data is forwarded as soon as it arrives.
  *
- * @param[in] prefix String prefix (e.g., "GDB>" or "Target>") for output.
- * @param[in,out] carry Stateful buffer for incomplete packets (modified in-place).
- * @param[in] data Pointer to incoming data chunk.
- * @param[in] len Number of bytes in chunk.
- * @param[in] verbose If false, function does nothing (no-op).
- * @note Output goes to stdout. Carry buffer is erased as complete packets are emitted.
- * @note This function is suitable for interrupt-driven I/O loops.
+ * The reader never writes to the link; writes stay on the proxy thread and
+ * may run while a read is outstanding (see transport::Transport).
  */
-void trace_rsp_stream(const char* prefix, std::string& carry, const unsigned char* data, size_t len, bool verbose)
+class TargetReader
 {
-    if (!verbose)
+public:
+    explicit TargetReader(transport::Transport& link)
+        : link_(link)
     {
-        return;
     }
 
-    carry.append(reinterpret_cast<const char*>(data), len);
+    ~TargetReader()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Create the wakeup channel and start the reader thread.
+     * @return false if the wakeup channel could not be created.
+     */
+    bool start()
+    {
+        if (!make_socket_pair(wakeup_fds_))
+        {
+            std::cerr << "[TCPProxy] wakeup channel creation failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        running_ = true;
+        thread_ = std::thread([this]() { run(); });
+        return true;
+    }
 
-    size_t pos = 0;
-    while (pos < carry.size())
+    /**
+     * @brief Stop and join the reader thread, then close the wakeup channel.
+     * @details Returns within one USB latency period.
+     */
+    void stop()
     {
-        if (carry[pos] == '$')
+        running_ = false;
+        if (thread_.joinable())
+        {
+            thread_.join();
+            cdbg << "[TCPProxy][dbg] usb reader thread joined" << std::endl;
+        }
+        for (int& fd : wakeup_fds_)
         {
-            const size_t hash = carry.find('#', pos + 1);
-            if (hash == std::string::npos)
+            if (fd >= 0)
             {
-                break;
+                socket_close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    /**
+     * @brief Take the link from the reader thread.
+     * @details Waits for the outstanding read to return; until resume() the
+     *          caller may run a request/reply exchange of its own.
+     */
+    void pause()
+    {
+        paused_ = true;
+        link_mutex_.lock();
+    }
+
+    /**
+     * @brief Give the link back to the reader thread.
+     */
+    void resume()
+    {
+        link_mutex_.unlock();
+        paused_ = false;
+    }
+
+    /**
+     * @brief Descriptor that becomes readable when bytes are pending.
+     */
+    int wakeup_fd() const
+    {
+        return wakeup_fds_[0];
+    }
+
+    /**
+     * @brief Take the bytes received so far.
+     * @param[out] out Receives the pending bytes (empty if none).
+     * @return false once the reader stopped on a link error.
+     */
+    bool take(std::string& out)
+    {
+        // Drain the wakeup bytes first so a batch arriving meanwhile wakes the loop again.
+        char drain[64];
+        (void)recv(wakeup_fds_[0], drain, sizeof(drain), 0);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.clear();
+        out.swap(pending_);
+        return !failed_;
+    }
+
+private:
+    void run()
+    {
+        cdbg << "[TCPProxy][dbg] usb reader thread started" << std::endl;
+        unsigned char ftdi_rx[2048];
+        while (running_ && !ftdi::g_interrupt_flag)
+        {
+            if (paused_)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
             }
-            if (hash + 2 >= carry.size())
+            int ftdi_len = 0;
             {
-                break;
+                std::lock_guard<std::mutex> link_lock(link_mutex_);
+                ftdi_len = link_.ReadSome(ftdi_rx, sizeof(ftdi_rx));
+            }
+            if (ftdi_len == 0)
+            {
+                continue;
             }
 
-            std::cout << prefix << carry.substr(pos, hash - pos + 3) << std::endl;
-            pos = hash + 3;
-            continue;
+            bool wake = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (ftdi_len < 0)
+                {
+                    failed_ = true;
+                    wake = true;
+                }
+                else
+                {
+                    cdbg << "[TCPProxy][dbg] recv from ftdi bytes=" << ftdi_len << std::endl;
+                    wake = pending_.empty();
+                    pending_.append(reinterpret_cast<const char*>(ftdi_rx), static_cast<size_t>(ftdi_len));
+                }
+            }
+            if (wake)
+            {
+                const char signal = 1;
+                (void)send(wakeup_fds_[1], &signal, 1, 0);
+            }
+            if (ftdi_len < 0)
+            {
+                break;
+            }
         }
+        cdbg << "[TCPProxy][dbg] usb reader thread exiting" << std::endl;
+    }
 
-        if (carry[pos] == '+' || carry[pos] == '-')
-        {
-            std::cout << prefix << carry[pos] << std::endl;
-            ++pos;
-            continue;
-        }
+    transport::Transport& link_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> paused_{false};
+    std::mutex link_mutex_; ///< Held around every read of the reader thread
+    std::mutex mutex_;
+    std::string pending_; ///< Target bytes not yet taken by the proxy loop
+    bool failed_ = false; ///< ReadSome() reported a link error
+    int wakeup_fds_[2] = {-1, -1};
+};
 
-        ++pos;
-    }
+/**
+ * @brief Longest poll() wait of the proxy loop, so g_interrupt_flag is noticed.
+ */
+constexpr int kIdlePollMs = 250;
 
-    if (pos > 0)
+/**
+ * @brief Set up an accepted client socket.
+ * @param primary Whether the client controls the target.
+ */
+std::unique_ptr<RspClient> make_rsp_client(int fd, bool primary)
+{
+    // Acks and replies are small writes; don't let Nagle hold them back.
+    const int nodelay = 1;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nodelay), sizeof(nodelay)) < 0)
     {
-        carry.erase(0, pos);
+        cdbg << "[TCPProxy][dbg] TCP_NODELAY failed errno=" << errno << std::endl;
     }
+
+    std::unique_ptr<RspClient> client(new RspClient);
+    client->fd = fd;
+    client->primary = primary;
+    client->trace_prefix = primary ? "GDB>" : "GDB#" + std::to_string(fd) + ">";
+    std::cout << (primary ? "[TCPProxy] client connected" : "[TCPProxy] read-only client connected") << std::endl;
+    cdbg << "[TCPProxy][dbg] client_fd=" << fd << " primary=" << primary << std::endl;
+    return client;
 }
 
 } // namespace
@@ -252,9 +1653,10 @@ namespace ftdi {
 /**
  * @copydoc ftdi::DoTcpProxy
  */
-int DoTcpProxy(uint16_t port, bool verbose)
+int DoTcpProxy(uint16_t port, bool verbose, bool memory_cache, bool native_load)
 {
-    cdbg << "[TCPProxy][dbg] start port=" << port << " verbose=" << verbose << std::endl;
+    cdbg << "[TCPProxy][dbg] start port=" << port << " verbose=" << verbose
+         << " memory_cache=" << memory_cache << " native_load=" << native_load << std::endl;
     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd < 0)
     {
@@ -283,7 +1685,7 @@ int DoTcpProxy(uint16_t port, bool verbose)
         return 1;
     }
 
-    if (listen(listen_fd, 1) < 0)
+    if (listen(listen_fd, static_cast<int>(kMaxClients)) < 0)
     {
         std::cerr << "[TCPProxy] listen failed: " << strerror(errno) << std::endl;
         socket_close(listen_fd);
@@ -293,10 +1695,10 @@ int DoTcpProxy(uint16_t port, bool verbose)
     std::cout << "[TCPProxy] listening on port " << port << std::endl;
     cdbg << "[TCPProxy][dbg] listen_fd=" << listen_fd << std::endl;
 
+    transport::Transport& link = transport::Active();
     unsigned char socket_rx[2048];
-    unsigned char ftdi_rx[2048];
-    std::string gdb_trace_buffer;
-    std::string target_trace_buffer;
+    std::string target_rx;
+    MemoryCache cache;
 
     while (!g_interrupt_flag)
     {
@@ -333,18 +1735,73 @@ int DoTcpProxy(uint16_t port, bool verbose)
             continue;
         }
 
-        std::cout << "[TCPProxy] client connected" << std::endl;
-        cdbg << "[TCPProxy][dbg] client_fd=" << client_fd << std::endl;
+        RspProxyState state;
+        std::vector<std::unique_ptr<RspClient>> clients;
+        clients.push_back(make_rsp_client(client_fd, true));
+        state.primary = clients.front().get();
+        if (memory_cache)
+        {
+            // The target may have run since the last client detached.
+            cache.invalidate_ram();
+            state.memory_cache = &cache;
+        }
+        TargetReader reader(link);
+        bool session_alive = reader.start();
+        if (native_load)
+        {
+            state.upload = [&](uint32_t address, const std::string& data) {
+                // Settle RSP first: the stub must not wait for an ack during the upload.
+                release_target_ack(state);
+                if (!flush_rsp_batches(state, link, clients))
+                {
+                    return false;
+                }
+                cdbg << "[TCPProxy][dbg] native upload bytes=" << data.size() << std::endl;
+                reader.pause();
+                const int status = xfer::DoUploadBuffer(address, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+                reader.resume();
+                return status == 1;
+            };
+        }
 
-        bool client_alive = true;
-        while (client_alive && !g_interrupt_flag)
+        // The session lasts as long as any client stays connected.
+        std::vector<struct pollfd> proxy_poll;
+        while (session_alive && !clients.empty() && !g_interrupt_flag)
         {
-            struct pollfd client_poll;
-            client_poll.fd = client_fd;
-            client_poll.events = POLLIN;
-            client_poll.revents = 0;
+            proxy_poll.assign(2 + clients.size(), pollfd());
+            proxy_poll[0].fd = listen_fd;
+            proxy_poll[1].fd = reader.wakeup_fd();
+            for (size_t i = 0; i < clients.size(); ++i)
+            {
+                proxy_poll[2 + i].fd = clients[i]->fd;
+            }
+            for (struct pollfd& entry : proxy_poll)
+            {
+                entry.events = POLLIN;
+                entry.revents = 0;
+            }
 
-            const int poll_status = poll(&client_poll, 1, 10);
+            // Sleep until any socket or the target has data, or until a held
+            // ack or a request times out.
+            const auto now = std::chrono::steady_clock::now();
+            long long timeout_ms = kIdlePollMs;
+            if (state.ack_held)
+            {
+                timeout_ms = std::min<long long>(timeout_ms, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                                 state.ack_deadline - now).count());
+            }
+            if (state.awaiting_reply)
+            {
+                timeout_ms = std::min<long long>(timeout_ms, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                                 state.reply_deadline - now).count());
+            }
+            if (state.late_reply)
+            {
+                timeout_ms = std::min<long long>(timeout_ms, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                                 state.late_reply_deadline - now).count());
+            }
+
+            const int poll_status = poll(proxy_poll.data(), proxy_poll.size(), static_cast<int>(std::max<long long>(0, timeout_ms)));
             if (poll_status < 0)
             {
                 if (errno == EINTR)
@@ -353,70 +1810,148 @@ int DoTcpProxy(uint16_t port, bool verbose)
                     continue;
                 }
                 std::cerr << "[TCPProxy] client poll failed: " << strerror(errno) << std::endl;
-                client_alive = false;
                 break;
             }
 
-            if (poll_status > 0)
+            for (size_t i = 0; i < clients.size(); ++i)
             {
-                if ((client_poll.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+                RspClient& client = *clients[i];
+                const short revents = proxy_poll[2 + i].revents;
+                if ((revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
                 {
-                    cdbg << "[TCPProxy][dbg] client poll events revents=0x" << std::hex
-                         << client_poll.revents << std::dec << std::endl;
-                    client_alive = false;
+                    cdbg << "[TCPProxy][dbg] client poll events fd=" << client.fd << " revents=0x" << std::hex
+                         << revents << std::dec << std::endl;
+                    client.alive = false;
+                    client.connected = false;
                 }
-                else if ((client_poll.revents & POLLIN) != 0)
+                else if ((revents & POLLIN) != 0)
                 {
-                    const ssize_t recv_len = recv(client_fd, reinterpret_cast<char*>(socket_rx), sizeof(socket_rx), 0);
+                    const ssize_t recv_len = recv(client.fd, reinterpret_cast<char*>(socket_rx), sizeof(socket_rx), 0);
                     if (recv_len <= 0)
                     {
-                        cdbg << "[TCPProxy][dbg] client recv returned " << recv_len << std::endl;
-                        client_alive = false;
+                        cdbg << "[TCPProxy][dbg] client recv fd=" << client.fd << " returned " << recv_len << std::endl;
+                        client.alive = false;
+                        client.connected = false;
                     }
                     else
                     {
-                        cdbg << "[TCPProxy][dbg] recv from client bytes=" << recv_len << std::endl;
-                        trace_rsp_stream("GDB>", gdb_trace_buffer, socket_rx, static_cast<size_t>(recv_len), verbose);
-                        size_t bytes_forwarded = 0;
-                        if (!write_all_ftdi(&g_Device, socket_rx, static_cast<size_t>(recv_len), &bytes_forwarded))
-                        {
-                            std::cerr << "[TCPProxy] FTDI write failed after forwarding "
-                                      << bytes_forwarded << "/" << recv_len
-                                      << " bytes: " << ftdi_get_error_string(&g_Device) << std::endl;
-                            client_alive = false;
-                        }
-                        else
-                        {
-                            cdbg << "[TCPProxy][dbg] forwarded client->ftdi bytes="
-                                 << bytes_forwarded << "/" << recv_len << std::endl;
-                        }
+                        cdbg << "[TCPProxy][dbg] recv from client fd=" << client.fd << " bytes=" << recv_len << std::endl;
+                        handle_client_frames(state, client, socket_rx, static_cast<size_t>(recv_len), verbose);
                     }
                 }
             }
 
-            const int ftdi_len = ftdi_read_data(&g_Device, ftdi_rx, sizeof(ftdi_rx));
-            if (ftdi_len < 0)
+            if ((proxy_poll[1].revents & POLLIN) != 0)
             {
-                std::cerr << "[TCPProxy] FTDI read failed: " << ftdi_get_error_string(&g_Device) << std::endl;
-                client_alive = false;
-                break;
+                if (!reader.take(target_rx))
+                {
+                    std::cerr << "[TCPProxy] FTDI read failed: " << link.LastError() << std::endl;
+                    break;
+                }
+                if (!target_rx.empty())
+                {
+                    handle_target_frames(state, reinterpret_cast<const unsigned char*>(target_rx.data()),
+                                         target_rx.size(), verbose);
+                }
+            }
+
+            if (state.ack_held && std::chrono::steady_clock::now() >= state.ack_deadline)
+            {
+                release_target_ack(state);
+            }
+            if (state.awaiting_reply && std::chrono::steady_clock::now() >= state.reply_deadline)
+            {
+                // Don't let one unanswered request stall every client.
+                std::cerr << "[TCPProxy] no target reply to $" << state.request.substr(0, 16)
+                          << " within " << kReplyTimeoutMs << " ms" << std::endl;
+                state.awaiting_reply = false;
+                state.owner = nullptr;
+                state.pending_read.active = false;
+                state.late_reply = true;
+                state.late_reply_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kLateReplyGraceMs);
+            }
+            if (state.late_reply && std::chrono::steady_clock::now() >= state.late_reply_deadline)
+            {
+                state.late_reply = false;
+                dispatch_client_packets(state, verbose);
+            }
+            session_alive = flush_rsp_batches(state, link, clients);
+
+            for (auto it = clients.begin(); it != clients.end();)
+            {
+                if ((*it)->alive)
+                {
+                    ++it;
+                    continue;
+                }
+                remove_client(state, **it);
+                socket_close((*it)->fd);
+                std::cout << ((*it)->primary ? "[TCPProxy] client disconnected" : "[TCPProxy] read-only client disconnected")
+                          << std::endl;
+                cdbg << "[TCPProxy][dbg] client_fd=" << (*it)->fd << " closed" << std::endl;
+                it = clients.erase(it);
+            }
+            if (session_alive)
+            {
+                // A held ack or load block of a departed primary.
+                session_alive = flush_rsp_batches(state, link, clients);
             }
 
-            if (ftdi_len > 0)
+            if ((proxy_poll[0].revents & POLLIN) != 0)
             {
-                cdbg << "[TCPProxy][dbg] recv from ftdi bytes=" << ftdi_len << std::endl;
-                trace_rsp_stream("Target>", target_trace_buffer, ftdi_rx, static_cast<size_t>(ftdi_len), verbose);
-                if (!write_all_socket(client_fd, ftdi_rx, static_cast<size_t>(ftdi_len)))
+                const int extra_fd = accept(listen_fd, nullptr, nullptr);
+                if (extra_fd < 0)
                 {
-                    std::cerr << "[TCPProxy] socket write failed: " << strerror(errno) << std::endl;
-                    client_alive = false;
+                    cdbg << "[TCPProxy][dbg] accept failed errno=" << errno << std::endl;
+                }
+                else if (clients.size() >= kMaxClients)
+                {
+                    std::cerr << "[TCPProxy] client refused: " << kMaxClients << " clients connected" << std::endl;
+                    socket_close(extra_fd);
+                }
+                else
+                {
+                    // A debugger connecting after the primary left takes its place.
+                    clients.push_back(make_rsp_client(extra_fd, state.primary == nullptr));
+                    if (state.primary == nullptr)
+                    {
+                        state.primary = clients.back().get();
+                        // A failed upload is only reported to the client that loaded it
+                        state.load_failed = false;
+                        if (memory_cache)
+                        {
+                            cache.invalidate_ram();
+                        }
+                    }
                 }
             }
         }
 
-        socket_close(client_fd);
-        std::cout << "[TCPProxy] client disconnected" << std::endl;
-        cdbg << "[TCPProxy][dbg] client_fd closed" << std::endl;
+        if (state.upload && !state.awaiting_reply && !state.running)
+        {
+            (void)flush_load_block(state);
+        }
+        // The stub would take the next client's first byte as a NAK of its
+        // last reply; send it the ack it is still waiting for.
+        release_target_ack(state);
+        for (const auto& client : clients)
+        {
+            client->to_client.clear();
+        }
+        (void)flush_rsp_batches(state, link, clients);
+        reader.stop();
+        for (const auto& client : clients)
+        {
+            socket_close(client->fd);
+            std::cout << (client->primary ? "[TCPProxy] client disconnected" : "[TCPProxy] read-only client disconnected")
+                      << std::endl;
+        }
+        if (memory_cache)
+        {
+            cdbg << "[TCPProxy][dbg] memory cache hits=" << cache.hits
+                 << " misses=" << cache.misses << std::endl;
+        }
+        cdbg << "[TCPProxy][dbg] session closed" << std::endl;
     }
 
     socket_close(listen_fd);
@@ -5,6 +5,8 @@
 
 #ifdef _WIN32
 #include <winsock2.h>
+#else
+#include <sys/socket.h>
 #endif
 
 #include "ftdi.hpp"
@@ -16,10 +18,16 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <cctype>
 #include <algorithm>
+#include <atomic>
 #include <ctime>
 #include <thread>
 #include <chrono>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -29,6 +37,8 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -160,32 +170,257 @@ std::string format_http_date(const std::string& iso_date) {
     return buf;
 }
 
+/**
+ * @brief Weak entity tag of a file, derived from its size and modification time.
+ * @details Listings give modification times to the minute, so a file
+ *          rewritten with the same size within a minute keeps its tag. The
+ *          tag is therefore weak: good for If-None-Match, never for If-Range.
+ */
+std::string make_etag(const FileEntry& entry) {
+    std::string stamp;
+    for (char c : entry.mtime) {
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            stamp += c;
+        }
+    }
+    return "W/\"" + std::to_string(entry.size) + "-" + stamp + "\"";
+}
+
+/**
+ * @brief Check whether an If-None-Match header names an entity tag.
+ * @details Uses the weak comparison, which ignores "W/" on both sides.
+ * @param header Header value: "*" or a comma separated list of entity tags.
+ * @param etag Entity tag of the file, as built by make_etag().
+ * @return True if @p etag matches.
+ */
+bool etag_matches(const std::string& header, const std::string& etag) {
+    const std::string opaque = boost::starts_with(etag, "W/") ? etag.substr(2) : etag;
+    std::vector<std::string> tags;
+    boost::split(tags, header, boost::is_any_of(","));
+    for (std::string tag : tags) {
+        boost::trim(tag);
+        if (tag == "*") {
+            return true;
+        }
+        if (boost::starts_with(tag, "W/")) {
+            tag = tag.substr(2);
+        }
+        if (tag == opaque) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parse a Range header asking for one byte range.
+ * @param header Header value, e.g. "bytes=0-499", "bytes=500-" or "bytes=-500".
+ * @param size File size.
+ * @param first Output, first byte of the range.
+ * @param last Output, last byte of the range (inclusive).
+ * @return 1 for a satisfiable range, -1 for an unsatisfiable one, 0 to serve
+ *         the whole file (no header, a malformed one or several ranges).
+ */
+int parse_byte_range(const std::string& header, size_t size, size_t& first, size_t& last) {
+    if (!boost::starts_with(header, "bytes=") || header.find(',') != std::string::npos) {
+        return 0;
+    }
+    const std::string spec = boost::trim_copy(header.substr(6));
+    const size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return 0;
+    }
+    const std::string from = spec.substr(0, dash);
+    const std::string to = spec.substr(dash + 1);
+    auto is_number = [](const std::string& text) {
+        return !text.empty() && text.size() <= 18 &&
+               std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); });
+    };
+
+    if (from.empty()) {
+        // Suffix range: the last bytes of the file
+        if (!is_number(to)) {
+            return 0;
+        }
+        const size_t count = std::stoull(to);
+        if (count == 0 || size == 0) {
+            return -1;
+        }
+        first = size - std::min(count, size);
+        last = size - 1;
+        return 1;
+    }
+    if (!is_number(from) || (!to.empty() && !is_number(to))) {
+        return 0;
+    }
+    first = std::stoull(from);
+    last = to.empty() ? size - 1 : std::stoull(to);
+    if (last < first) {
+        return 0;
+    }
+    if (first >= size) {
+        return -1;
+    }
+    last = std::min(last, size - 1);
+    return 1;
+}
+
+/**
+ * @brief 8.3 name a PUT body is uploaded to before it replaces the target.
+ */
+constexpr char PUT_TEMP_NAME[] = "~FTXPUT.TMP";
+
+/**
+ * @brief Largest number of directory listings kept by DirectoryCache.
+ */
+constexpr std::size_t DIRECTORY_CACHE_MAX_ENTRIES = 256;
+
+/**
+ * @brief Long listings of directories already fetched from the cartridge.
+ * @details File managers look up every item of a folder separately, and each
+ *          lookup needs the listing of its parent. Listings are keyed by
+ *          lower-case path, as FAT names are case-insensitive. The whole cache
+ *          is dropped once xfer::SdModificationCount() moves, so any request
+ *          changing the card, from WebDAV or elsewhere, invalidates it. A
+ *          non-zero TTL also expires listings, for cards changed by the Saturn
+ *          itself. Only used on the device strand.
+ */
+class DirectoryCache {
+public:
+    /**
+     * @brief Set the lifetime of a listing (0: until the card changes).
+     */
+    void set_ttl(std::chrono::seconds ttl) { ttl_ = ttl; }
+
+    /**
+     * @brief Look up the listing of @p dir.
+     * @return True and @p listing filled on a hit.
+     */
+    bool lookup(const std::string& dir, std::string& listing) {
+        drop_if_stale();
+        const auto it = entries_.find(boost::to_lower_copy(dir));
+        if (it == entries_.end()) {
+            return false;
+        }
+        if (ttl_.count() > 0 && std::chrono::steady_clock::now() - it->second.fetched > ttl_) {
+            entries_.erase(it);
+            return false;
+        }
+        listing = it->second.listing;
+        return true;
+    }
+
+    /**
+     * @brief Remember the listing of @p dir.
+     */
+    void store(const std::string& dir, const std::string& listing) {
+        drop_if_stale();
+        if (entries_.size() >= DIRECTORY_CACHE_MAX_ENTRIES) {
+            entries_.clear();
+        }
+        entries_[boost::to_lower_copy(dir)] = {listing, std::chrono::steady_clock::now()};
+    }
+
+private:
+    struct Entry {
+        std::string listing;
+        std::chrono::steady_clock::time_point fetched;
+    };
+
+    void drop_if_stale() {
+        const uint32_t count = xfer::SdModificationCount();
+        if (count != modification_count_) {
+            entries_.clear();
+            modification_count_ = count;
+        }
+    }
+
+    std::map<std::string, Entry> entries_;
+    uint32_t modification_count_ = xfer::SdModificationCount();
+    std::chrono::seconds ttl_{0};
+};
+
+DirectoryCache g_directory_cache;
+
+/**
+ * @brief Fetch the long listings of several directories.
+ * @details Cached listings are used as is; the others are fetched in one
+ *          request batch and cached if the directory exists.
+ * @param dirs Directory paths.
+ * @param replies Output, one LIST result per directory.
+ * @return True if every directory got a reply, false on link error.
+ */
+bool list_directories(const std::vector<std::string>& dirs, std::vector<xfer::RemoteIoBatchItem>& replies) {
+    replies.assign(dirs.size(), xfer::RemoteIoBatchItem{});
+    std::vector<xfer::RemoteIoBatchItem> batch;
+    std::vector<std::size_t> fetched;
+    for (std::size_t i = 0; i < dirs.size(); ++i) {
+        replies[i].argument = "-l " + dirs[i];
+        if (g_directory_cache.lookup(dirs[i], replies[i].reply)) {
+            replies[i].status = xfer::RemoteIoStatus::OK;
+        } else {
+            batch.push_back(replies[i]);
+            fetched.push_back(i);
+        }
+    }
+    if (batch.empty()) {
+        return true;
+    }
+    if (xfer::DoRemoteIoBatch(batch) != 1) {
+        return false;
+    }
+    for (std::size_t k = 0; k < batch.size(); ++k) {
+        if (batch[k].status == xfer::RemoteIoStatus::OK) {
+            g_directory_cache.store(dirs[fetched[k]], batch[k].reply);
+        }
+        replies[fetched[k]] = std::move(batch[k]);
+    }
+    return true;
+}
+
 /**
  * @brief Retrieve metadata for a single file or directory on the target cartridge.
  * @param path Filesystem path of the item (updated to matched case on success).
  * @param entry Output reference populated with item details on success.
+ * @param listing If not null, also receives the long listing of @p path,
+ *        fetched in the same request batch as the parent listing when not
+ *        cached (empty if @p path is not a directory).
  * @return True if item is found and metadata is retrieved, false otherwise.
  */
-bool get_item_metadata(std::string& path, FileEntry& entry) {
-    if (path == "/" || path.empty()) {
+bool get_item_metadata(std::string& path, FileEntry& entry, std::string* listing = nullptr) {
+    const bool is_root = (path == "/" || path.empty());
+    size_t last_slash = is_root ? 0 : path.find_last_of('/');
+    std::string parent = (last_slash == 0) ? "/" : path.substr(0, last_slash);
+    std::string name = is_root ? "" : path.substr(last_slash + 1);
+
+    std::vector<std::string> dirs;
+    if (!is_root) {
+        dirs.push_back(parent);
+    }
+    if (listing != nullptr) {
+        dirs.push_back(is_root ? std::string("/") : path);
+    }
+    std::vector<xfer::RemoteIoBatchItem> batch;
+    if (!list_directories(dirs, batch)) {
+        return false;
+    }
+    if (listing != nullptr) {
+        const xfer::RemoteIoBatchItem& own = batch.back();
+        *listing = (own.status == xfer::RemoteIoStatus::OK) ? own.reply : std::string();
+    }
+
+    if (is_root) {
         entry.is_dir = true;
         entry.size = 0;
         entry.mtime = "2026-07-17T09:00:00Z";
         entry.name = "";
         return true;
     }
-
-    size_t last_slash = path.find_last_of('/');
-    std::string parent = (last_slash == 0) ? "/" : path.substr(0, last_slash);
-    std::string name = path.substr(last_slash + 1);
-
-    std::string parent_listing;
-    std::string saturn_path = "-l " + parent;
-    if (xfer::DoListStr(saturn_path.c_str(), parent_listing) != 1) {
+    if (batch.front().status != xfer::RemoteIoStatus::OK) {
         return false;
     }
 
-    std::vector<FileEntry> entries = parse_directory_listing(parent_listing);
+    std::vector<FileEntry> entries = parse_directory_listing(batch.front().reply);
     for (const auto& e : entries) {
         if (boost::iequals(e.name, name)) {
             entry = e;
@@ -201,9 +436,11 @@ bool get_item_metadata(std::string& path, FileEntry& entry) {
  * @param path Requested request URI path.
  * @param target_entry Metadata of the requested item.
  * @param depth Depth header value indicating traversal depth ("0" or "1").
+ * @param listing Long listing of @p path already fetched, or null to fetch it here.
  * @return Conforming XML response string.
  */
-std::string build_multistatus_xml(const std::string& path, const FileEntry& target_entry, const std::string& depth) {
+std::string build_multistatus_xml(const std::string& path, const FileEntry& target_entry, const std::string& depth,
+                                  const std::string* listing = nullptr) {
     using boost::property_tree::ptree;
 
     ptree pt;
@@ -227,6 +464,7 @@ std::string build_multistatus_xml(const std::string& path, const FileEntry& targ
             prop.add("D:resourcetype", "");
             prop.put("D:getcontentlength", entry.size);
             prop.put("D:getcontenttype", "application/octet-stream");
+            prop.put("D:getetag", make_etag(entry));
         }
         prop.put("D:displayname", entry.name);
         prop.put("D:getlastmodified", format_http_date(entry.mtime));
@@ -241,10 +479,14 @@ std::string build_multistatus_xml(const std::string& path, const FileEntry& targ
     add_response(path, target_entry);
 
     if (depth == "1" && target_entry.is_dir) {
-        std::string listing;
-        std::string saturn_path = "-l " + path;
-        if (xfer::DoListStr(saturn_path.c_str(), listing) == 1) {
-            std::vector<FileEntry> sub_entries = parse_directory_listing(listing);
+        std::vector<xfer::RemoteIoBatchItem> fetched;
+        bool have_listing = (listing != nullptr);
+        if (!have_listing) {
+            have_listing = list_directories({path}, fetched) && fetched.front().status == xfer::RemoteIoStatus::OK;
+            listing = &fetched.front().reply;
+        }
+        if (have_listing) {
+            std::vector<FileEntry> sub_entries = parse_directory_listing(*listing);
             for (const auto& e : sub_entries) {
                 std::string sub_path = (path == "/") ? ("/" + e.name) : (path + "/" + e.name);
                 add_response(sub_path, e);
@@ -285,396 +527,739 @@ bool is_valid_83_path(const std::string& path_str) {
     return true;
 }
 
-} // namespace
 
-namespace ftdi {
+/**
+ * @brief Idle time after which a keep-alive connection is closed.
+ */
+constexpr std::chrono::seconds KEEP_ALIVE_TIMEOUT{60};
 
 /**
- * @copydoc ftdi::DoWebDavServer
- * @brief Runs a local WebDAV server that translates standard WebDAV methods to cartridge file commands.
- * @details Listens on the specified port, accepts connection requests, and processes WebDAV methods:
- * - OPTIONS: Returns supported methods (OPTIONS, GET, PROPFIND, PUT, DELETE, MKCOL, MOVE, COPY).
- * - PROPFIND: Retrieves item metadata and directory listings from the Saturn cartridge.
- * - PUT: Uploads host file contents to the cartridge.
- * - DELETE: Deletes files or directories from the cartridge.
- * - MKCOL: Creates directories on the cartridge.
- * - MOVE: Renames or moves files/directories on the cartridge.
- * - GET: Downloads files from the cartridge.
- * - COPY: Copies files on the cartridge by downloading and re-uploading locally.
- *
- * It uses case-insensitive lookup (via `get_item_metadata`) to safely resolve user-provided paths 
- * against the FatFS on the console.
- *
- * @param port The TCP port to listen on.
- * @return 0 on successful termination, 1 on critical server failure.
+ * @brief Largest body read into memory for requests other than PUT.
  */
-int DoWebDavServer(uint16_t port) {
-    try {
-        net::io_context ioc{1};
-        tcp::acceptor acceptor{ioc};
-        acceptor.open(tcp::v4());
-        acceptor.set_option(net::socket_base::reuse_address(true));
-        acceptor.bind({tcp::v4(), port});
-        acceptor.listen(net::socket_base::max_listen_connections);
-        acceptor.non_blocking(true);
+constexpr std::uint64_t MAX_REQUEST_BODY = 1024 * 1024;
 
-        std::cout << "[WebDAV] Server listening on port " << port << " (via Boost.Beast)" << std::endl;
+/**
+ * @brief Longest a blocking socket read or write may stall while a request is served.
+ */
+constexpr std::chrono::seconds IO_TIMEOUT{30};
 
-        while (!g_interrupt_flag) {
-            boost::system::error_code ec;
-            tcp::socket socket{ioc};
-            
-            acceptor.accept(socket, ec);
-            if (ec == net::error::would_block) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
-            }
-            if (ec) {
-                std::cerr << "[WebDAV] Accept error: " << ec.message() << std::endl;
-                continue;
-            }
+/**
+ * @brief Interval of the watchdog enforcing IO_TIMEOUT and Ctrl-C.
+ */
+constexpr std::chrono::milliseconds WATCHDOG_PERIOD{100};
 
-            beast::flat_buffer buffer;
-            http::request<http::string_body> req;
-            http::read(socket, buffer, req, ec);
-            if (ec) {
-                continue;
+/**
+ * @brief Number of threads running the server's I/O context.
+ * @details One of them at a time serves a request on the device strand; the
+ *          others keep accepting connections and reading requests meanwhile.
+ */
+constexpr unsigned SERVER_THREADS = 4;
+
+/**
+ * @brief Strand owning the cartridge link.
+ */
+using DeviceStrand = net::strand<net::io_context::executor_type>;
+
+/**
+ * @brief One client connection of the WebDAV server.
+ * @details Request headers and small bodies are read asynchronously on the
+ *          connection's own strand. The complete request is then served on the
+ *          device strand shared by all connections, so requests reach the
+ *          cartridge one at a time in arrival order. Serving uses blocking
+ *          socket I/O, which is safe as no asynchronous operation is pending
+ *          on the connection meanwhile, and lets PUT and GET bodies stream at
+ *          the pace of the cartridge. A watchdog on the connection's strand
+ *          shuts the socket down when one blocking operation stalls for
+ *          IO_TIMEOUT or Ctrl-C is pressed, so a stalled client can't hold
+ *          the device strand. The connection then reads the next
+ *          request, possibly already buffered by a pipelining client.
+ */
+class WebDavSession : public std::enable_shared_from_this<WebDavSession> {
+public:
+    WebDavSession(tcp::socket&& socket, const DeviceStrand& device)
+        : stream_(std::move(socket)), device_(device), watchdog_(stream_.get_executor()),
+          native_socket_(stream_.socket().native_handle()) {}
+
+    /**
+     * @brief Start reading requests.
+     */
+    void run() {
+        net::dispatch(stream_.get_executor(),
+                      beast::bind_front_handler(&WebDavSession::read_header, shared_from_this()));
+    }
+
+private:
+    void read_header();
+    void on_header(beast::error_code ec, std::size_t bytes);
+    void on_body(beast::error_code ec, std::size_t bytes);
+    void on_device();
+    bool serve(http::request<http::string_body>& req, http::request_parser<http::buffer_body>* put_parser);
+    void watch_io();
+    void close();
+
+    /**
+     * @brief Arms the watchdog for one blocking socket operation of serve().
+     */
+    class IoDeadline {
+    public:
+        explicit IoDeadline(WebDavSession& session) : session_(session) {
+            session_.io_deadline_ = (std::chrono::steady_clock::now() + IO_TIMEOUT).time_since_epoch().count();
+        }
+        ~IoDeadline() { session_.io_deadline_ = 0; }
+
+    private:
+        WebDavSession& session_;
+    };
+
+    template <class Message>
+    void write(Message& message, beast::error_code& ec) {
+        IoDeadline deadline(*this);
+        http::write(stream_, message, ec);
+    }
+
+    beast::tcp_stream stream_;
+    DeviceStrand device_;
+    beast::flat_buffer buffer_;
+    std::optional<http::request_parser<http::empty_body>> header_parser_;
+    std::optional<http::request_parser<http::string_body>> body_parser_;
+    std::unique_ptr<http::request_parser<http::buffer_body>> put_parser_;
+    net::steady_timer watchdog_;
+    std::atomic<bool> serving_{false};
+    std::atomic<std::chrono::steady_clock::rep> io_deadline_{0}; ///< 0 outside blocking operations
+    tcp::socket::native_handle_type native_socket_; ///< For the watchdog, which must not touch stream_
+};
+
+void WebDavSession::read_header() {
+    body_parser_.reset();
+    put_parser_.reset();
+    header_parser_.emplace();
+    // Beast checks Content-Length against the limit with the header; PUT
+    // bodies are streamed and unbounded, other requests are bounded in on_header.
+    header_parser_->body_limit(std::numeric_limits<std::uint64_t>::max());
+    stream_.expires_after(KEEP_ALIVE_TIMEOUT);
+    http::async_read_header(stream_, buffer_, *header_parser_,
+                            beast::bind_front_handler(&WebDavSession::on_header, shared_from_this()));
+}
+
+void WebDavSession::on_header(beast::error_code ec, std::size_t) {
+    if (ec) {
+        close();
+        return;
+    }
+
+    // PUT bodies are streamed to the card; other bodies are small and read whole.
+    if (header_parser_->get().method() == http::verb::put) {
+        put_parser_ = std::make_unique<http::request_parser<http::buffer_body>>(std::move(*header_parser_));
+        stream_.expires_never();
+        serving_ = true;
+        watch_io();
+        net::post(device_, beast::bind_front_handler(&WebDavSession::on_device, shared_from_this()));
+        return;
+    }
+    body_parser_.emplace(std::move(*header_parser_));
+    body_parser_->body_limit(MAX_REQUEST_BODY);
+    const auto content_length = body_parser_->content_length();
+    if (content_length && *content_length > MAX_REQUEST_BODY) {
+        std::cerr << "[WebDAV] Request body of " << *content_length << " bytes is too large." << std::endl;
+        auto res = std::make_shared<http::response<http::empty_body>>(http::status::payload_too_large,
+                                                                        body_parser_->get().version());
+        res->keep_alive(false);
+        res->prepare_payload();
+        http::async_write(stream_, *res, [self = shared_from_this(), res](beast::error_code, std::size_t) {
+            self->close();
+        });
+        return;
+    }
+    http::async_read(stream_, buffer_, *body_parser_,
+                     beast::bind_front_handler(&WebDavSession::on_body, shared_from_this()));
+}
+
+void WebDavSession::on_body(beast::error_code ec, std::size_t) {
+    if (ec) {
+        close();
+        return;
+    }
+    stream_.expires_never();
+    serving_ = true;
+    watch_io();
+    net::post(device_, beast::bind_front_handler(&WebDavSession::on_device, shared_from_this()));
+}
+
+/**
+ * @brief Shut the socket down if a blocking operation of serve() overran
+ *        its IoDeadline or Ctrl-C was pressed; runs until serving ends.
+ */
+void WebDavSession::watch_io() {
+    watchdog_.expires_after(WATCHDOG_PERIOD);
+    watchdog_.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if (ec || !self->serving_) {
+            return;
+        }
+        const auto deadline = self->io_deadline_.load();
+        const bool stalled = deadline != 0 && std::chrono::steady_clock::now().time_since_epoch().count() > deadline;
+        if (stalled || ftdi::g_interrupt_flag) {
+            if (stalled) {
+                std::cerr << "[WebDAV] Client stalled for " << IO_TIMEOUT.count() << " s, closing the connection." << std::endl;
             }
+            // serve() is using stream_ on the device strand, and an asio socket
+            // object must not be used from two threads. A shutdown(2) of the
+            // native handle only touches the kernel socket: the blocked recv
+            // or send returns and asio reports it as an error. The handle
+            // stays valid, as the socket is closed only with the session.
+#ifdef _WIN32
+            (void)::shutdown(self->native_socket_, SD_BOTH);
+#else
+            (void)::shutdown(self->native_socket_, SHUT_RDWR);
+#endif
+            return;
+        }
+        self->watch_io();
+    });
+}
+
+void WebDavSession::on_device() {
+    http::request<http::string_body> req;
+    if (put_parser_) {
+        req.base() = put_parser_->get().base();
+    } else {
+        req = body_parser_->release();
+    }
+
+    bool keep_alive = false;
+    try {
+        keep_alive = serve(req, put_parser_.get());
+    } catch (const std::exception& e) {
+        std::cerr << "[WebDAV] Exception: " << e.what() << std::endl;
+    }
+    serving_ = false;
+
+    net::post(stream_.get_executor(), [self = shared_from_this(), keep_alive] {
+        if (keep_alive) {
+            self->read_header();
+        } else {
+            self->close();
+        }
+    });
+}
 
-            std::string method{req.method_string()};
-            std::string raw_path{req.target()};
+/**
+ * @brief Serve one request on the device strand.
+ * @param req Request; only the header for a PUT.
+ * @param put_parser Parser positioned at the body of a PUT, null otherwise.
+ * @return True if the connection can carry another request.
+ */
+bool WebDavSession::serve(http::request<http::string_body>& req, http::request_parser<http::buffer_body>* put_parser) {
+    beast::error_code ec;
+    bool keep_alive = req.keep_alive();
+
+    std::string method{req.method_string()};
+    std::string raw_path{req.target()};
 
-            std::string depth{req["Depth"]};
-            if (depth.empty()) {
-                depth = "1";
+    std::string depth{req["Depth"]};
+    if (depth.empty()) {
+        depth = "1";
+    }
+
+    std::string path = url_decode(raw_path);
+    size_t q = path.find('?');
+    if (q != std::string::npos) {
+        path = path.substr(0, q);
+    }
+    if (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+
+    std::cout << "[WebDAV] Request: " << method << " " << path << std::endl;
+
+    if (method == "OPTIONS") {
+        http::response<http::empty_body> res{http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::allow, "OPTIONS, GET, PROPFIND, PUT, DELETE, MKCOL, MOVE, COPY");
+        res.set("DAV", "1");
+        res.keep_alive(keep_alive);
+        res.prepare_payload();
+        write(res, ec);
+    }
+    else if (method == "PROPFIND") {
+        // Depth 1 fetches the parent and the collection listings in one batch.
+        FileEntry target_entry;
+        std::string listing;
+        if (!get_item_metadata(path, target_entry, depth == "1" ? &listing : nullptr)) {
+            http::response<http::empty_body> res{http::status::not_found, req.version()};
+            res.keep_alive(keep_alive);
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            std::string xml = build_multistatus_xml(path, target_entry, depth,
+                                                    depth == "1" ? &listing : nullptr);
+            http::response<http::string_body> res{http::status::multi_status, req.version()};
+            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            res.set(http::field::content_type, "application/xml; charset=utf-8");
+            res.keep_alive(keep_alive);
+            res.body() = xml;
+            res.prepare_payload();
+            write(res, ec);
+        }
+    }
+    else if (method == "PUT") {
+        if (!is_valid_83_path(path)) {
+            std::cerr << "[WebDAV] Rejected PUT: Path component violates strict 8.3 filename conventions: " << path << std::endl;
+            keep_alive = false; // the unread body is still on the connection
+            http::response<http::string_body> res{http::status::bad_request, req.version()};
+            res.keep_alive(keep_alive);
+            res.body() = "Error: Path violates strict 8.3 filename conventions (max 8 characters for name, 3 characters for extension).";
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            if (boost::iequals(req[http::field::expect], "100-continue")) {
+                http::response<http::empty_body> cont{http::status::continue_, req.version()};
+                write(cont, ec);
             }
 
-            std::string path = url_decode(raw_path);
-            size_t q = path.find('?');
-            if (q != std::string::npos) {
-                path = path.substr(0, q);
+            // HTTP body chunks go straight into the card upload.
+            http::request_parser<http::buffer_body>& parser = *put_parser;
+            const xfer::SdUploadSource source = [&](uint8_t* data, std::size_t size) -> long {
+                while (!parser.is_done()) {
+                    parser.get().body().data = data;
+                    parser.get().body().size = size;
+                    {
+                        IoDeadline deadline(*this);
+                        http::read(stream_, buffer_, parser, ec);
+                    }
+                    if (ec == http::error::need_buffer) {
+                        ec = {};
+                    }
+                    if (ec) {
+                        std::cerr << "[WebDAV] PUT body read error: " << ec.message() << std::endl;
+                        return -1;
+                    }
+                    const std::size_t got = size - parser.get().body().size;
+                    if (got > 0) {
+                        return static_cast<long>(got);
+                    }
+                }
+                return 0;
+            };
+            // The body goes to a temporary file next to the target, which
+            // replaces the target only once complete: an aborted PUT leaves
+            // the existing file untouched.
+            const std::string temp_path = path.substr(0, path.rfind('/') + 1) + PUT_TEMP_NAME;
+            const auto length = parser.content_length();
+            int status = xfer::DoSdUploadStream(temp_path.c_str(), source,
+                                                length ? static_cast<int64_t>(*length) : -1);
+            keep_alive = keep_alive && parser.is_done();
+            if (status == 1) {
+                FileEntry existing;
+                std::string target = path;
+                if (get_item_metadata(target, existing) && !existing.is_dir) {
+                    xfer::DoRemove(path.c_str());
+                }
+                status = xfer::DoRename(temp_path.c_str(), path.c_str());
             }
-            if (path.size() > 1 && path.back() == '/') {
-                path.pop_back();
+            if (status != 1) {
+                xfer::DoRemove(temp_path.c_str());
             }
 
-            std::cout << "[WebDAV] Request: " << method << " " << path << std::endl;
+            if (status == 1) {
+                http::response<http::empty_body> res{http::status::created, req.version()};
+                res.keep_alive(keep_alive);
+                res.prepare_payload();
+                write(res, ec);
+            } else {
+                http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
+                res.keep_alive(keep_alive);
+                res.prepare_payload();
+                write(res, ec);
+            }
+        }
+    }
+    else if (method == "DELETE") {
+        int status = xfer::DoRemove(path.c_str());
+        if (status != 1) {
+            status = xfer::DoRmdir(path.c_str());
+        }
 
-            if (method == "OPTIONS") {
-                http::response<http::empty_body> res{http::status::ok, req.version()};
-                res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                res.set(http::field::allow, "OPTIONS, GET, PROPFIND, PUT, DELETE, MKCOL, MOVE, COPY");
-                res.set("DAV", "1");
-                res.set(http::field::connection, "close");
+        if (status == 1) {
+            http::response<http::empty_body> res{http::status::no_content, req.version()};
+            res.keep_alive(keep_alive);
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
+            res.keep_alive(keep_alive);
+            res.prepare_payload();
+            write(res, ec);
+        }
+    }
+    else if (method == "MKCOL") {
+        if (!is_valid_83_path(path)) {
+            std::cerr << "[WebDAV] Rejected MKCOL: Path component violates strict 8.3 filename conventions: " << path << std::endl;
+            http::response<http::string_body> res{http::status::bad_request, req.version()};
+            res.keep_alive(keep_alive);
+            res.body() = "Error: Directory name violates strict 8.3 conventions (max 8 characters).";
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            int status = xfer::DoMkdir(path.c_str());
+            if (status == 1) {
+                http::response<http::empty_body> res{http::status::created, req.version()};
+                res.keep_alive(keep_alive);
                 res.prepare_payload();
-                http::write(socket, res, ec);
+                write(res, ec);
+            } else {
+                http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
+                res.keep_alive(keep_alive);
+                res.prepare_payload();
+                write(res, ec);
             }
-            else if (method == "PROPFIND") {
-                FileEntry target_entry;
-                if (!get_item_metadata(path, target_entry)) {
-                    http::response<http::empty_body> res{http::status::not_found, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
+        }
+    }
+    else if (method == "MOVE") {
+        std::string dest_header{req["Destination"]};
+        if (dest_header.empty()) {
+            http::response<http::empty_body> res{http::status::bad_request, req.version()};
+            res.keep_alive(keep_alive);
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            std::string dest_path;
+            size_t proto_pos = dest_header.find("://");
+            if (proto_pos != std::string::npos) {
+                size_t path_pos = dest_header.find('/', proto_pos + 3);
+                if (path_pos != std::string::npos) {
+                    dest_path = dest_header.substr(path_pos);
                 } else {
-                    std::string xml = build_multistatus_xml(path, target_entry, depth);
-                    http::response<http::string_body> res{http::status::multi_status, req.version()};
-                    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                    res.set(http::field::content_type, "application/xml; charset=utf-8");
-                    res.set(http::field::connection, "close");
-                    res.body() = xml;
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
+                    dest_path = "/";
                 }
+            } else {
+                dest_path = dest_header;
+            }
+            dest_path = url_decode(dest_path);
+            size_t q = dest_path.find('?');
+            if (q != std::string::npos) {
+                dest_path = dest_path.substr(0, q);
+            }
+            if (dest_path.size() > 1 && dest_path.back() == '/') {
+                dest_path.pop_back();
             }
-            else if (method == "PUT") {
-                if (!is_valid_83_path(path)) {
-                    std::cerr << "[WebDAV] Rejected PUT: Path component violates strict 8.3 filename conventions: " << path << std::endl;
-                    http::response<http::string_body> res{http::status::bad_request, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.body() = "Error: Path violates strict 8.3 filename conventions (max 8 characters for name, 3 characters for extension).";
+
+            if (!is_valid_83_path(dest_path)) {
+                std::cerr << "[WebDAV] Rejected MOVE: Destination path component violates strict 8.3 filename conventions: " << dest_path << std::endl;
+                http::response<http::string_body> res{http::status::bad_request, req.version()};
+                res.keep_alive(keep_alive);
+                res.body() = "Error: Destination path violates strict 8.3 filename conventions (max 8 characters for name, 3 characters for extension).";
+                res.prepare_payload();
+                write(res, ec);
+            } else {
+                FileEntry source_entry;
+                if (!get_item_metadata(path, source_entry)) {
+                    http::response<http::empty_body> res{http::status::not_found, req.version()};
+                    res.keep_alive(keep_alive);
                     res.prepare_payload();
-                    http::write(socket, res, ec);
+                    write(res, ec);
                 } else {
-                    std::string temp_filename = "ftx_webdav_temp.bin";
-                    std::ofstream temp_file(temp_filename, std::ios::binary);
-                    if (!temp_file) {
-                        http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                        res.set(http::field::connection, "close");
+                    FileEntry dest_entry;
+                    bool dest_exists = get_item_metadata(dest_path, dest_entry);
+                    std::string overwrite{req["Overwrite"]};
+                    if (dest_exists && overwrite == "F") {
+                        http::response<http::empty_body> res{http::status::precondition_failed, req.version()};
+                        res.keep_alive(keep_alive);
                         res.prepare_payload();
-                        http::write(socket, res, ec);
+                        write(res, ec);
                     } else {
-                        temp_file.write(req.body().data(), req.body().size());
-                        temp_file.close();
-
-                        int status = xfer::DoSdUpload(temp_filename.c_str(), path.c_str());
-                        std::remove(temp_filename.c_str());
+                        if (dest_exists) {
+                            // Remove the destination first to allow f_rename to succeed
+                            int remove_status = xfer::DoRemove(dest_path.c_str());
+                            if (remove_status != 1) {
+                                xfer::DoRmdir(dest_path.c_str());
+                            }
+                        }
 
+                        int status = xfer::DoRename(path.c_str(), dest_path.c_str());
                         if (status == 1) {
-                            http::response<http::empty_body> res{http::status::created, req.version()};
-                            res.set(http::field::connection, "close");
+                            http::status response_status = dest_exists ? http::status::no_content : http::status::created;
+                            http::response<http::empty_body> res{response_status, req.version()};
+                            res.keep_alive(keep_alive);
                             res.prepare_payload();
-                            http::write(socket, res, ec);
+                            write(res, ec);
                         } else {
                             http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                            res.set(http::field::connection, "close");
+                            res.keep_alive(keep_alive);
                             res.prepare_payload();
-                            http::write(socket, res, ec);
+                            write(res, ec);
                         }
                     }
                 }
             }
-            else if (method == "DELETE") {
-                int status = xfer::DoRemove(path.c_str());
-                if (status != 1) {
-                    status = xfer::DoRmdir(path.c_str());
-                }
+        }
+    }
+    else if (method == "GET") {
+        FileEntry entry;
+        if (!get_item_metadata(path, entry) || entry.is_dir) {
+            http::response<http::empty_body> res{http::status::not_found, req.version()};
+            res.keep_alive(keep_alive);
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            const std::string etag = make_etag(entry);
+            const std::string last_modified = format_http_date(entry.mtime);
 
-                if (status == 1) {
-                    http::response<http::empty_body> res{http::status::no_content, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
-                } else {
-                    http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
-                }
+            // If-Range needs a strong validator and neither the weak tag nor
+            // the minute-resolution date is one: such requests get the whole file
+            size_t first = 0;
+            size_t last = 0;
+            int range = 0;
+            if (req[http::field::if_range].empty()) {
+                range = parse_byte_range(std::string(req[http::field::range]), entry.size, first, last);
             }
-            else if (method == "MKCOL") {
-                if (!is_valid_83_path(path)) {
-                    std::cerr << "[WebDAV] Rejected MKCOL: Path component violates strict 8.3 filename conventions: " << path << std::endl;
-                    http::response<http::string_body> res{http::status::bad_request, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.body() = "Error: Directory name violates strict 8.3 conventions (max 8 characters).";
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
-                } else {
-                    int status = xfer::DoMkdir(path.c_str());
-                    if (status == 1) {
-                        http::response<http::empty_body> res{http::status::created, req.version()};
-                        res.set(http::field::connection, "close");
-                        res.prepare_payload();
-                        http::write(socket, res, ec);
-                    } else {
-                        http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                        res.set(http::field::connection, "close");
-                        res.prepare_payload();
-                        http::write(socket, res, ec);
-                    }
+
+            if (etag_matches(std::string(req[http::field::if_none_match]), etag)) {
+                http::response<http::empty_body> res{http::status::not_modified, req.version()};
+                res.set(http::field::etag, etag);
+                res.set(http::field::last_modified, last_modified);
+                res.keep_alive(keep_alive);
+                write(res, ec);
+                return keep_alive && !ec;
+            }
+            if (range < 0) {
+                http::response<http::empty_body> res{http::status::range_not_satisfiable, req.version()};
+                res.set(http::field::content_range, "bytes */" + std::to_string(entry.size));
+                res.keep_alive(keep_alive);
+                res.prepare_payload();
+                write(res, ec);
+                return keep_alive && !ec;
+            }
+
+            // Verified chunks are written to the socket as they arrive from the card.
+            http::response<http::buffer_body> res{range > 0 ? http::status::partial_content : http::status::ok,
+                                                  req.version()};
+            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            res.set(http::field::content_type, "application/octet-stream");
+            res.set(http::field::accept_ranges, "bytes");
+            res.set(http::field::etag, etag);
+            res.set(http::field::last_modified, last_modified);
+            if (range > 0) {
+                res.set(http::field::content_range, "bytes " + std::to_string(first) + "-" + std::to_string(last) +
+                                                        "/" + std::to_string(entry.size));
+            }
+            res.keep_alive(keep_alive);
+            http::response_serializer<http::buffer_body> serializer{res};
+            bool header_sent = false;
+
+            const xfer::SdSizeCallback on_size = [&](uint32_t size) {
+                if (range > 0 && size != entry.size) {
+                    // Changed since it was listed: the range no longer applies
+                    return false;
+                }
+                res.content_length(range > 0 ? last - first + 1 : size);
+                IoDeadline deadline(*this);
+                http::write_header(stream_, serializer, ec);
+                header_sent = !ec;
+                return header_sent;
+            };
+            const xfer::SdDownloadSink sink = [&](const uint8_t* data, std::size_t size) {
+                res.body().data = const_cast<uint8_t*>(data);
+                res.body().size = size;
+                res.body().more = true;
+                write(serializer, ec);
+                if (ec == http::error::need_buffer) {
+                    ec = {};
                 }
+                return !ec;
+            };
+            int status = (range > 0)
+                ? xfer::DoSdDownloadRange(path.c_str(), static_cast<uint32_t>(first),
+                                          static_cast<uint32_t>(last - first + 1), on_size, sink)
+                : xfer::DoSdDownloadStream(path.c_str(), on_size, sink);
+            if (status == 1) {
+                res.body().data = nullptr;
+                res.body().size = 0;
+                res.body().more = false;
+                write(serializer, ec);
+            } else if (!header_sent) {
+                http::response<http::empty_body> error_res{http::status::internal_server_error, req.version()};
+                error_res.keep_alive(keep_alive);
+                error_res.prepare_payload();
+                write(error_res, ec);
+            } else {
+                // The body is cut short and closing the connection tells the client.
+                keep_alive = false;
             }
-            else if (method == "MOVE") {
-                std::string dest_header{req["Destination"]};
-                if (dest_header.empty()) {
-                    http::response<http::empty_body> res{http::status::bad_request, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
+        }
+    }
+    else if (method == "COPY") {
+        std::string dest_header{req["Destination"]};
+        if (dest_header.empty()) {
+            http::response<http::empty_body> res{http::status::bad_request, req.version()};
+            res.keep_alive(keep_alive);
+            res.prepare_payload();
+            write(res, ec);
+        } else {
+            std::string dest_path;
+            size_t proto_pos = dest_header.find("://");
+            if (proto_pos != std::string::npos) {
+                size_t path_pos = dest_header.find('/', proto_pos + 3);
+                if (path_pos != std::string::npos) {
+                    dest_path = dest_header.substr(path_pos);
                 } else {
-                    std::string dest_path;
-                    size_t proto_pos = dest_header.find("://");
-                    if (proto_pos != std::string::npos) {
-                        size_t path_pos = dest_header.find('/', proto_pos + 3);
-                        if (path_pos != std::string::npos) {
-                            dest_path = dest_header.substr(path_pos);
-                        } else {
-                            dest_path = "/";
-                        }
-                    } else {
-                        dest_path = dest_header;
-                    }
-                    dest_path = url_decode(dest_path);
-                    size_t q = dest_path.find('?');
-                    if (q != std::string::npos) {
-                        dest_path = dest_path.substr(0, q);
-                    }
-                    if (dest_path.size() > 1 && dest_path.back() == '/') {
-                        dest_path.pop_back();
-                    }
-
-                    if (!is_valid_83_path(dest_path)) {
-                        std::cerr << "[WebDAV] Rejected MOVE: Destination path component violates strict 8.3 filename conventions: " << dest_path << std::endl;
-                        http::response<http::string_body> res{http::status::bad_request, req.version()};
-                        res.set(http::field::connection, "close");
-                        res.body() = "Error: Destination path violates strict 8.3 filename conventions (max 8 characters for name, 3 characters for extension).";
-                        res.prepare_payload();
-                        http::write(socket, res, ec);
-                    } else {
-                        FileEntry source_entry;
-                        if (!get_item_metadata(path, source_entry)) {
-                            http::response<http::empty_body> res{http::status::not_found, req.version()};
-                            res.set(http::field::connection, "close");
-                            res.prepare_payload();
-                            http::write(socket, res, ec);
-                        } else {
-                            FileEntry dest_entry;
-                            bool dest_exists = get_item_metadata(dest_path, dest_entry);
-                            std::string overwrite{req["Overwrite"]};
-                            if (dest_exists && overwrite == "F") {
-                                http::response<http::empty_body> res{http::status::precondition_failed, req.version()};
-                                res.set(http::field::connection, "close");
-                                res.prepare_payload();
-                                http::write(socket, res, ec);
-                            } else {
-                                if (dest_exists) {
-                                    // Remove the destination first to allow f_rename to succeed
-                                    int remove_status = xfer::DoRemove(dest_path.c_str());
-                                    if (remove_status != 1) {
-                                        xfer::DoRmdir(dest_path.c_str());
-                                    }
-                                }
-
-                                int status = xfer::DoRename(path.c_str(), dest_path.c_str());
-                                if (status == 1) {
-                                    http::status response_status = dest_exists ? http::status::no_content : http::status::created;
-                                    http::response<http::empty_body> res{response_status, req.version()};
-                                    res.set(http::field::connection, "close");
-                                    res.prepare_payload();
-                                    http::write(socket, res, ec);
-                                } else {
-                                    http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                                    res.set(http::field::connection, "close");
-                                    res.prepare_payload();
-                                    http::write(socket, res, ec);
-                                }
-                            }
-                        }
-                    }
+                    dest_path = "/";
                 }
+            } else {
+                dest_path = dest_header;
             }
-            else if (method == "GET") {
-                FileEntry entry;
-                if (!get_item_metadata(path, entry) || entry.is_dir) {
+            dest_path = url_decode(dest_path);
+            size_t q = dest_path.find('?');
+            if (q != std::string::npos) {
+                dest_path = dest_path.substr(0, q);
+            }
+            if (dest_path.size() > 1 && dest_path.back() == '/') {
+                dest_path.pop_back();
+            }
+
+            if (!is_valid_83_path(dest_path)) {
+                std::cerr << "[WebDAV] Rejected COPY: Destination path component violates strict 8.3 filename conventions: " << dest_path << std::endl;
+                http::response<http::string_body> res{http::status::bad_request, req.version()};
+                res.keep_alive(keep_alive);
+                res.body() = "Error: Destination path violates strict 8.3 filename conventions (max 8 characters for name, 3 characters for extension).";
+                res.prepare_payload();
+                write(res, ec);
+            } else {
+                FileEntry source_entry;
+                if (!get_item_metadata(path, source_entry)) {
                     http::response<http::empty_body> res{http::status::not_found, req.version()};
-                    res.set(http::field::connection, "close");
+                    res.keep_alive(keep_alive);
                     res.prepare_payload();
-                    http::write(socket, res, ec);
+                    write(res, ec);
                 } else {
-                    std::string temp_filename = "ftx_webdav_get_temp.bin";
-                    int status = xfer::DoSdDownload(path.c_str(), temp_filename.c_str());
-                    if (status != 1) {
-                        std::remove(temp_filename.c_str());
-                        http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                        res.set(http::field::connection, "close");
+                    FileEntry dest_entry;
+                    bool dest_exists = get_item_metadata(dest_path, dest_entry);
+                    std::string overwrite{req["Overwrite"]};
+                    if (dest_exists && overwrite == "F") {
+                        http::response<http::empty_body> res{http::status::precondition_failed, req.version()};
+                        res.keep_alive(keep_alive);
                         res.prepare_payload();
-                        http::write(socket, res, ec);
+                        write(res, ec);
                     } else {
-                        std::ifstream file(temp_filename, std::ios::binary);
-                        if (!file) {
-                            std::remove(temp_filename.c_str());
-                            http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                            res.set(http::field::connection, "close");
-                            res.prepare_payload();
-                            http::write(socket, res, ec);
-                        } else {
-                            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                            file.close();
-                            std::remove(temp_filename.c_str());
-
-                            http::response<http::string_body> res{http::status::ok, req.version()};
-                            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                            res.set(http::field::content_type, "application/octet-stream");
-                            res.set(http::field::connection, "close");
-                            res.body() = std::move(content);
-                            res.prepare_payload();
-                            http::write(socket, res, ec);
-                        }
-                    }
-                }
-            }
-            else if (method == "COPY") {
-                std::string dest_header{req["Destination"]};
-                if (dest_header.empty()) {
-                    http::response<http::empty_body> res{http::status::bad_request, req.version()};
-                    res.set(http::field::connection, "close");
-                    res.prepare_payload();
-                    http::write(socket, res, ec);
-                } else {
-                    std::string dest_path;
-                    size_t proto_pos = dest_header.find("://");
-                    if (proto_pos != std::string::npos) {
-                        size_t path_pos = dest_header.find('/', proto_pos + 3);
-                        if (path_pos != std::string::npos) {
-                            dest_path = dest_header.substr(path_pos);
-                        } else {
-                            dest_path = "/";
+                        if (dest_exists) {
+                            int remove_status = xfer::DoRemove(dest_path.c_str());
+                            if (remove_status != 1) {
+                                xfer::DoRmdir(dest_path.c_str());
+                            }
                         }
-                    } else {
-                        dest_path = dest_header;
-                    }
-                    dest_path = url_decode(dest_path);
-                    size_t q = dest_path.find('?');
-                    if (q != std::string::npos) {
-                        dest_path = dest_path.substr(0, q);
-                    }
-                    if (dest_path.size() > 1 && dest_path.back() == '/') {
-                        dest_path.pop_back();
-                    }
 
-                    if (!is_valid_83_path(dest_path)) {
-                        std::cerr << "[WebDAV] Rejected COPY: Destination path component violates strict 8.3 filename conventions: " << dest_path << std::endl;
-                        http::response<http::string_body> res{http::status::bad_request, req.version()};
-                        res.set(http::field::connection, "close");
-                        res.body() = "Error: Destination path violates strict 8.3 filename conventions (max 8 characters for name, 3 characters for extension).";
-                        res.prepare_payload();
-                        http::write(socket, res, ec);
-                    } else {
-                        FileEntry source_entry;
-                        if (!get_item_metadata(path, source_entry)) {
-                            http::response<http::empty_body> res{http::status::not_found, req.version()};
-                            res.set(http::field::connection, "close");
+                        int status = xfer::DoSdCopy(path.c_str(), dest_path.c_str());
+                        if (status == 1) {
+                            http::status response_status = dest_exists ? http::status::no_content : http::status::created;
+                            http::response<http::empty_body> res{response_status, req.version()};
+                            res.keep_alive(keep_alive);
                             res.prepare_payload();
-                            http::write(socket, res, ec);
+                            write(res, ec);
                         } else {
-                            FileEntry dest_entry;
-                            bool dest_exists = get_item_metadata(dest_path, dest_entry);
-                            std::string overwrite{req["Overwrite"]};
-                            if (dest_exists && overwrite == "F") {
-                                http::response<http::empty_body> res{http::status::precondition_failed, req.version()};
-                                res.set(http::field::connection, "close");
-                                res.prepare_payload();
-                                http::write(socket, res, ec);
-                            } else {
-                                if (dest_exists) {
-                                    int remove_status = xfer::DoRemove(dest_path.c_str());
-                                    if (remove_status != 1) {
-                                        xfer::DoRmdir(dest_path.c_str());
-                                    }
-                                }
-
-                                std::string temp_filename = "ftx_webdav_copy_temp.bin";
-                                int download_status = xfer::DoSdDownload(path.c_str(), temp_filename.c_str());
-                                int upload_status = 0;
-                                if (download_status == 1) {
-                                    upload_status = xfer::DoSdUpload(temp_filename.c_str(), dest_path.c_str());
-                                }
-                                std::remove(temp_filename.c_str());
-
-                                if (download_status == 1 && upload_status == 1) {
-                                    http::status response_status = dest_exists ? http::status::no_content : http::status::created;
-                                    http::response<http::empty_body> res{response_status, req.version()};
-                                    res.set(http::field::connection, "close");
-                                    res.prepare_payload();
-                                    http::write(socket, res, ec);
-                                } else {
-                                    http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
-                                    res.set(http::field::connection, "close");
-                                    res.prepare_payload();
-                                    http::write(socket, res, ec);
-                                }
-                            }
+                            http::response<http::empty_body> res{http::status::internal_server_error, req.version()};
+                            res.keep_alive(keep_alive);
+                            res.prepare_payload();
+                            write(res, ec);
                         }
                     }
                 }
             }
-            else {
-                http::response<http::empty_body> res{http::status::method_not_allowed, req.version()};
-                res.set(http::field::connection, "close");
-                res.prepare_payload();
-                http::write(socket, res, ec);
-            }
+        }
+    }
+    else {
+        http::response<http::empty_body> res{http::status::method_not_allowed, req.version()};
+        res.keep_alive(keep_alive);
+        res.prepare_payload();
+        write(res, ec);
+    }
+    return keep_alive && !ec;
+}
+
+void WebDavSession::close() {
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+/**
+ * @brief Accept connections until the I/O context stops.
+ */
+void do_accept(net::io_context& ioc, tcp::acceptor& acceptor, const DeviceStrand& device) {
+    acceptor.async_accept(net::make_strand(ioc), [&ioc, &acceptor, &device](beast::error_code ec, tcp::socket socket) {
+        if (ec) {
+            std::cerr << "[WebDAV] Accept error: " << ec.message() << std::endl;
+        } else {
+            std::make_shared<WebDavSession>(std::move(socket), device)->run();
+        }
+        do_accept(ioc, acceptor, device);
+    });
+}
+
+/**
+ * @brief Stop the I/O context once g_interrupt_flag is set.
+ */
+void watch_interrupt(net::io_context& ioc, net::steady_timer& timer) {
+    timer.expires_after(std::chrono::milliseconds(100));
+    timer.async_wait([&ioc, &timer](beast::error_code) {
+        if (ftdi::g_interrupt_flag) {
+            // Session watchdogs get a few periods to unblock requests being served
+            timer.expires_after(4 * WATCHDOG_PERIOD);
+            timer.async_wait([&ioc](beast::error_code) { ioc.stop(); });
+        } else {
+            watch_interrupt(ioc, timer);
+        }
+    });
+}
+
+} // namespace
+
+namespace ftdi {
+
+/**
+ * @copydoc ftdi::DoWebDavServer
+ * @brief Runs a local WebDAV server that translates standard WebDAV methods to cartridge file commands.
+ * @details Listens on the specified port and serves concurrent HTTP/1.1 connections with keep-alive
+ * and pipelining (see WebDavSession); cartridge access is serialized on a single device strand.
+ * Processes WebDAV methods:
+ * - OPTIONS: Returns supported methods (OPTIONS, GET, PROPFIND, PUT, DELETE, MKCOL, MOVE, COPY).
+ * - PROPFIND: Retrieves item metadata and directory listings from the Saturn cartridge.
+ * - PUT: Streams the request body to the cartridge.
+ * - DELETE: Deletes files or directories from the cartridge.
+ * - MKCOL: Creates directories on the cartridge.
+ * - MOVE: Renames or moves files/directories on the cartridge.
+ * - GET: Streams files from the cartridge into the response, honouring Range and If-None-Match.
+ * - COPY: Copies files on the cartridge without sending the data over USB.
+ *
+ * It uses case-insensitive lookup (via `get_item_metadata`) to safely resolve user-provided paths 
+ * against the FatFS on the console. Directory listings are cached (see DirectoryCache).
+ *
+ * @param port The TCP port to listen on.
+ * @param cache_ttl Lifetime of cached directory listings in seconds, 0 to keep them until the card changes.
+ * @return 0 on successful termination, 1 on critical server failure.
+ */
+int DoWebDavServer(uint16_t port, unsigned cache_ttl) {
+    try {
+        g_directory_cache.set_ttl(std::chrono::seconds(cache_ttl));
+
+        net::io_context ioc{static_cast<int>(SERVER_THREADS)};
+        tcp::acceptor acceptor{ioc};
+        acceptor.open(tcp::v4());
+        acceptor.set_option(net::socket_base::reuse_address(true));
+        acceptor.bind({tcp::v4(), port});
+        acceptor.listen(net::socket_base::max_listen_connections);
+
+        std::cout << "[WebDAV] Server listening on port " << port << " (via Boost.Beast)" << std::endl;
+
+        const DeviceStrand device = net::make_strand(ioc);
+        do_accept(ioc, acceptor, device);
+        net::steady_timer interrupt_timer{ioc};
+        watch_interrupt(ioc, interrupt_timer);
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < SERVER_THREADS; ++i) {
+            threads.emplace_back([&ioc] { ioc.run(); });
+        }
+        ioc.run();
+        for (std::thread& thread : threads) {
+            thread.join();
         }
     } catch (const std::exception& e) {
         std::cerr << "[WebDAV] Exception: " << e.what() << std::endl;
@@ -42,11 +42,14 @@
 */
 
 
+#include <cctype>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <csignal>
 #include <cstring>
+#include <vector>
 
 #ifdef _WIN32
 // Dummy strsignal for Windows
@@ -68,6 +71,7 @@ const char* strsignal(int sig) {
 #include "ftdi.hpp"
 #include "xfer.hpp"
 #include "crc.hpp"
+#include "transport.hpp"
 #include <fstream>
 
 
@@ -124,22 +128,36 @@ void PrintUsage(const char* progName) {
     std::cout << "  -t, --terminal                Run terminal mode (bidirectional)\n";
     std::cout << "  -c, --console                 Run debug console (read-only)\n";
     std::cout << "  -g  [port]                    Run raw TCP<->FTDI proxy (Default port 1234)\n";
+    std::cout << "  --gdb-cache                   With -g: answer repeated GDB memory reads from a proxy-side cache\n";
+    std::cout << "  --gdb-upload                  With -g: send bulk GDB memory writes (load) as native uploads\n";
     std::cout << "  -wd, --webdav [port]          Run WebDAV server (Default port 8080)\n";
+    std::cout << "  --cache-ttl <seconds>         Expire WebDAV directory listings after <seconds> (Default: when the card changes)\n";
     std::cout << "  -v                            Output GDB commands\n";
     std::cout << "  -vv                           Output GDB commands and all dbg execution traces\n";
     std::cout << "  -l                            List available FTDI devices\n";
+    std::cout << "  --daemon                      Keep the device open and serve commands on a Unix socket\n";
+    std::cout << "  --client                      Run the command through a running daemon\n";
+    std::cout << "  --socket <path>               Daemon socket (Default $XDG_RUNTIME_DIR/ftx.sock)\n";
+    std::cout << "  --emulator [folder]           Talk to an in-process cartridge emulator instead of USB (optional SD card seed folder)\n";
     std::cout << "  -h, --help                    Help\n\n";
     std::cout << "Commands:\n";
     std::cout << "  -d  <file>  <address>  <size> Download data to file\n";
     std::cout << "  -u  <file>  <address>         Upload data from file\n";
     std::cout << "  -x  <file>  <address>         Upload program and execute\n";
     std::cout << "  -r  <address>                 Execute program (Does not work !)\n";
-    std::cout << "  -D, --dump <file>             Dump BIOS to file\n\n";
+    std::cout << "  --compress                    With -u/-x: send an LZF-compressed image expanded on the cartridge\n";
+    std::cout << "  --decompressor <file>         Decompressor stub used by --compress\n";
+    std::cout << "  -D, --dump <file>             Dump BIOS to file\n";
+    std::cout << "  --batch <file|->              Run one command per line (e.g. \"-u a.bin 0x200000\") on one open device\n";
+    std::cout << "  --stop-on-error               With --batch: stop at the first failing step\n\n";
     std::cout << "  --ls <path>                   List files and directories\n";
     std::cout << "  --rm <path>                   Remove a file or empty directory\n";
     std::cout << "  --mkdir <path>                Create a directory\n";
     std::cout << "  --rmdir <path>                Delete a directory\n";
     std::cout << "  --cp <file> <target>          Copy a file to a raw SD range (sdraw:start:count) or FAT filesystem path (/path)\n";
+    std::cout << "  --delta                       With --cp: send only the blocks that differ from the file on the card\n";
+    std::cout << "  --resume                      With --cp/--get: continue an interrupted transfer of the same file\n";
+    std::cout << "  --sdcp <source> <target>      Copy a file to another path on the SD card, on the cartridge\n";
     std::cout << "  --crc <file>                  Print CRC-8 for a file\n";
     std::cout << "  --lcrc <file>                 Print CRC-8 for a local host file\n";
     std::cout << "  --sync <local> <saturn> [mode] Synchronize local folder and Saturn SDCard folder (mode: 1=local->saturn [default], 2=saturn->local, 3=both)\n\n";
@@ -155,6 +173,13 @@ void PrintUsage(const char* progName) {
     std::cout << "  " << prog << " --crc boot.bin\n";
 }
 
+/**
+ * @brief Thrown by parse_args() instead of exiting, so the daemon survives bad requests.
+ */
+struct ParseExit {
+    int code; ///< Process exit status
+};
+
 /**
  * @brief Struct to hold parsed command line arguments.
  */
@@ -166,10 +191,24 @@ struct CommandLineArgs {
     bool console = false; ///< Run debug console (read-only)
     bool tcp_proxy = false; ///< Run raw TCP proxy
     uint16_t tcp_port = 1234; ///< TCP proxy port
+    bool gdb_cache = false; ///< Cache GDB memory reads in the TCP proxy
+    bool gdb_upload = false; ///< Send bulk GDB memory writes as native uploads
     bool webdav = false; ///< Run WebDAV server
     uint16_t webdav_port = 8080; ///< WebDAV port
+    unsigned webdav_cache_ttl = 0; ///< WebDAV directory listing lifetime in seconds (0 = until the card changes)
     int verbose_level = 0; ///< Verbose tracing level (0=none, 1=GDB, 2=all)
-    enum CommandType { NONE, DOWNLOAD, UPLOAD, EXEC, RUN, DUMP, LIST_DEVICES, LS, RM, CRC, CP, LCRC, MKDIR, RMDIR, GET, SYNC } command = NONE; ///< Command type
+    bool emulator = false; ///< Use the cartridge emulator instead of the FTDI device
+    std::string emulator_sd_dir; ///< Host folder copied into the emulated SD card
+    bool compress = false; ///< LZF-compress -u/-x uploads
+    std::string decompressor; ///< Decompressor stub for compressed uploads
+    bool delta = false; ///< Block delta --cp uploads
+    bool resume = false; ///< Resumable --cp/--get transfers
+    bool daemon = false; ///< Keep the device open and serve commands on a Unix socket
+    bool client = false; ///< Forward the command to a running daemon
+    std::string socket_path; ///< Daemon socket path
+    std::string batch_file; ///< Batch script ("-" for stdin)
+    bool stop_on_error = false; ///< Stop a batch at the first failing step
+    enum CommandType { NONE, DOWNLOAD, UPLOAD, EXEC, RUN, DUMP, LIST_DEVICES, LS, RM, CRC, CP, LCRC, MKDIR, RMDIR, GET, SDCP, SYNC } command = NONE; ///< Command type
     int sync_mode = 1; ///< Sync mode (1 = local->saturn, 2 = saturn->local, 3 = both)
     std::string filename; ///< File name for transfer
     std::string target; ///< Target path for copy operations
@@ -182,6 +221,7 @@ struct CommandLineArgs {
  * @param argc Argument count.
  * @param argv Argument vector.
  * @return Parsed CommandLineArgs struct.
+ * @throws ParseExit on --help or invalid arguments.
  */
 CommandLineArgs parse_args(int argc, char* argv[]) {
     namespace po = boost::program_options;
@@ -195,23 +235,37 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
         ("terminal,t", "Run terminal mode (bidirectional)")
         ("console,c", "Run debug console (read-only)")
         ("g,g", po::value<std::string>()->implicit_value("1234"), "Run raw TCP proxy [optional port]")
+        ("gdb-cache", "Cache GDB memory reads in the TCP proxy")
+        ("gdb-upload", "Send bulk GDB memory writes as native uploads")
         ("webdav,wd", po::value<std::string>()->implicit_value("8080"), "Run WebDAV server [optional port]")
+        ("cache-ttl", po::value<unsigned>(), "Expire WebDAV directory listings after: <seconds>")
         ("verbose_level", po::value<int>(), "Verbose level")
         ("v", "Output GDB commands")
         ("vv", "Output GDB commands and dbg execution traces")
         ("verbose", "Output GDB commands and dbg execution traces (alias for vv)")
+        ("emulator", po::value<std::string>()->implicit_value(""), "Use the cartridge emulator [optional SD card seed folder]")
         ("d,d", po::value<std::vector<std::string>>()->multitoken(), "Download: <file> <address> <size>")
         ("u,u", po::value<std::vector<std::string>>()->multitoken(), "Upload: <file> <address>")
         ("x,x", po::value<std::vector<std::string>>()->multitoken(), "Exec: <file> <address>")
         ("r,r", po::value<std::string>(), "Run: <address>")
+        ("compress", "LZF-compress -u/-x uploads (requires --decompressor)")
+        ("daemon", "Keep the device open and serve commands on a Unix socket")
+        ("client", "Send the command to a running daemon")
+        ("socket", po::value<std::string>(), "Daemon socket path: <path>")
+        ("batch", po::value<std::string>(), "Run one command per line from a script: <file|->")
+        ("stop-on-error", "Stop a batch at the first failing step")
+        ("decompressor", po::value<std::string>(), "Decompressor stub for --compress: <file>")
         ("ls", po::value<std::string>()->implicit_value("/"), "List files and directories: <path>")
         ("rm", po::value<std::string>(), "Remove a file or empty directory: <path>")
         ("mkdir", po::value<std::string>(), "Create a directory: <path>")
         ("rmdir", po::value<std::string>(), "Delete a directory: <path>")
         ("cp", po::value<std::vector<std::string>>()->multitoken(), "Copy: <file> <sdraw:start:count>")
+        ("delta", "Send only changed blocks of --cp uploads")
+        ("resume", "Continue interrupted --cp/--get transfers")
         ("crc", po::value<std::string>(), "Print CRC-8 for a file: <file>")
         ("lcrc", po::value<std::string>(), "Print CRC-8 for a local file: <file>")
         ("get", po::value<std::vector<std::string>>()->multitoken(), "Download file from Saturn SD card: <saturn_path> <host_file>")
+        ("sdcp", po::value<std::vector<std::string>>()->multitoken(), "Copy a file on the Saturn SD card: <saturn_source> <saturn_target>")
         ("sync", po::value<std::vector<std::string>>()->multitoken(), "Synchronize folder: <local_folder> <saturn_folder> [mode: 1=local->saturn, 2=saturn->local, 3=both]")
         ("help,h", "Help: Show this help message")
         ("dump,D", po::value<std::string>(), "Dump BIOS: <file>");
@@ -231,13 +285,13 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
     } catch (const std::exception& e) {
         std::cerr << "Error parsing command line: " << e.what() << std::endl;
         std::cout << desc << std::endl;
-        exit(EXIT_FAILURE);
+        throw ParseExit{EXIT_FAILURE};
     }
 
     try {
         if (vm.count("help") || vm.count("h")) {
             PrintUsage(argv[0]);
-            exit(EXIT_SUCCESS);
+            throw ParseExit{EXIT_SUCCESS};
         }
         if (vm.count("vid")) {
             args.vid = std::stoi(vm["vid"].as<std::string>(), nullptr, 16);
@@ -284,6 +338,13 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
                 args.filename = vals[0];
                 args.target = vals[1];
             }
+        } else if (vm.count("sdcp")) {
+            auto vals = vm["sdcp"].as<std::vector<std::string>>();
+            if (vals.size() == 2) {
+                args.command = CommandLineArgs::SDCP;
+                args.filename = vals[0];
+                args.target = vals[1];
+            }
         } else if (vm.count("sync")) {
             auto vals = vm["sync"].as<std::vector<std::string>>();
             if (vals.size() >= 2) {
@@ -328,6 +389,12 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
                 args.tcp_port = 1234;
             }
         }
+        if (vm.count("gdb-cache")) {
+            args.gdb_cache = true;
+        }
+        if (vm.count("gdb-upload")) {
+            args.gdb_upload = true;
+        }
         if (vm.count("webdav")) {
             args.webdav = true;
             std::string port_str = vm["webdav"].as<std::string>();
@@ -338,6 +405,9 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
                 args.webdav_port = 8080;
             }
         }
+        if (vm.count("cache-ttl")) {
+            args.webdav_cache_ttl = vm["cache-ttl"].as<unsigned>();
+        }
         if (vm.count("vv") || vm.count("verbose")) {
             args.verbose_level = 2;
         } else if (vm.count("v")) {
@@ -345,6 +415,27 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
         } else if (vm.count("verbose_level")) {
             args.verbose_level = vm["verbose_level"].as<int>();
         }
+        if (vm.count("emulator")) {
+            args.emulator = true;
+            args.emulator_sd_dir = vm["emulator"].as<std::string>();
+        }
+        args.daemon = vm.count("daemon") > 0;
+        args.client = vm.count("client") > 0;
+        if (vm.count("batch")) {
+            args.batch_file = vm["batch"].as<std::string>();
+        }
+        args.stop_on_error = vm.count("stop-on-error") > 0;
+        args.delta = vm.count("delta") > 0;
+        args.resume = vm.count("resume") > 0;
+        args.socket_path = vm.count("socket") ? vm["socket"].as<std::string>() : ftdi::DefaultDaemonSocketPath();
+        if (vm.count("compress")) {
+            if (!vm.count("decompressor")) {
+                std::cerr << "Error: --compress requires --decompressor <file>" << std::endl;
+                throw ParseExit{EXIT_FAILURE};
+            }
+            args.compress = true;
+            args.decompressor = vm["decompressor"].as<std::string>();
+        }
         if (vm.count("d")) {
             auto vals = vm["d"].as<std::vector<std::string>>();
             if (vals.size() == 3) {
@@ -377,18 +468,286 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
         }
     } catch (const std::invalid_argument& e) {
         std::cerr << "Error: Invalid numeric argument provided." << std::endl;
-        exit(EXIT_FAILURE);
+        throw ParseExit{EXIT_FAILURE};
     } catch (const std::out_of_range& e) {
         std::cerr << "Error: Numeric argument out of range." << std::endl;
-        exit(EXIT_FAILURE);
+        throw ParseExit{EXIT_FAILURE};
     } catch (const std::exception& e) {
         std::cerr << "Error parsing arguments: " << e.what() << std::endl;
-        exit(EXIT_FAILURE);
+        throw ParseExit{EXIT_FAILURE};
     }
 
     return args;
 }
 
+/**
+ * @brief Open the cartridge link selected on the command line.
+ * @param args Parsed command line arguments.
+ * @return true if the link is ready for use.
+ */
+static bool OpenTransport(const CommandLineArgs& args)
+{
+    if (args.emulator) {
+        std::unique_ptr<transport::Transport> link = transport::MakeEmulatorTransport(args.emulator_sd_dir);
+        if (!link) {
+            return false;
+        }
+        transport::SetActive(std::move(link));
+        return true;
+    }
+
+    if (!ftdi::InitComms(args.vid, args.pid, args.serial)) {
+        return false;
+    }
+    atexit(ftdi::CloseComms);
+    transport::SetActive(transport::MakeFtdiTransport());
+    return true;
+}
+
+/**
+ * @brief Execute the one-shot device command selected on the command line.
+ * @param args Parsed command line arguments.
+ * @return 1 on success (or when no command was given), 0 on error.
+ */
+static int RunCommand(const CommandLineArgs& args)
+{
+    int status = 1;
+    switch (args.command) {
+        case CommandLineArgs::DOWNLOAD:
+            status = xfer::DoDownload(args.filename.c_str(), args.address, args.length);
+            break;
+        case CommandLineArgs::UPLOAD:
+            status = args.compress
+                ? xfer::DoCompressedUpload(args.filename.c_str(), args.address, args.decompressor.c_str())
+                : xfer::DoUpload(args.filename.c_str(), args.address);
+            break;
+        case CommandLineArgs::EXEC:
+            status = args.compress
+                ? xfer::DoCompressedUpload(args.filename.c_str(), args.address, args.decompressor.c_str(), true)
+                : xfer::DoExecute(args.filename.c_str(), args.address);
+            break;
+        case CommandLineArgs::RUN:
+            status = xfer::DoRun(args.address);
+            break;
+        case CommandLineArgs::DUMP:
+            status = xfer::DoBiosDump(args.filename.c_str());
+            break;
+        case CommandLineArgs::LS:
+            status = xfer::DoList(args.filename.c_str());
+            break;
+        case CommandLineArgs::RM:
+            status = xfer::DoRemove(args.filename.c_str());
+            break;
+        case CommandLineArgs::MKDIR:
+            status = xfer::DoMkdir(args.filename.c_str());
+            break;
+        case CommandLineArgs::RMDIR:
+            status = xfer::DoRmdir(args.filename.c_str());
+            break;
+        case CommandLineArgs::CP:
+            status = args.delta
+                ? xfer::DoSdDeltaUpload(args.filename.c_str(), args.target.c_str())
+                : xfer::DoSdUpload(args.filename.c_str(), args.target.c_str(), args.resume);
+            break;
+        case CommandLineArgs::CRC:
+            status = xfer::DoCrc(args.filename.c_str());
+            break;
+        case CommandLineArgs::GET:
+            status = xfer::DoSdDownload(args.filename.c_str(), args.target.c_str(), args.resume);
+            break;
+        case CommandLineArgs::SDCP:
+            status = xfer::DoSdCopy(args.filename.c_str(), args.target.c_str());
+            break;
+        case CommandLineArgs::SYNC:
+            status = xfer::DoSdSync(args.filename.c_str(), args.target.c_str(), args.sync_mode);
+            break;
+        default:
+            break;
+    }
+    return status;
+}
+
+/**
+ * @brief Parse and run one ftx command line against the already open device.
+ * @details Used for daemon requests and batch steps. Only one-shot commands
+ *          are accepted. A -v/-vv on the line raises verbosity for that
+ *          command only.
+ * @param tokens Arguments without the program name.
+ * @param context Log prefix naming the caller ("Daemon" or "Batch").
+ * @return Process-style exit status.
+ */
+static int RunCommandLine(const std::vector<std::string>& tokens, const char* context)
+{
+    std::vector<std::string> storage;
+    storage.reserve(tokens.size() + 1);
+    storage.push_back("ftx");
+    storage.insert(storage.end(), tokens.begin(), tokens.end());
+    std::vector<char*> argv;
+    for (std::string& arg : storage) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    CommandLineArgs args;
+    try {
+        args = parse_args(static_cast<int>(storage.size()), argv.data());
+    } catch (const ParseExit& e) {
+        return e.code;
+    }
+
+    if (args.terminal || args.console || args.tcp_proxy || args.webdav || args.daemon || args.client ||
+        !args.batch_file.empty() || args.command == CommandLineArgs::LIST_DEVICES) {
+        std::cerr << "[" << context << "] Only one-shot transfer commands are accepted here." << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (args.command == CommandLineArgs::NONE) {
+        std::cerr << "[" << context << "] No command given." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int saved_level = g_verbose_level;
+    if (args.verbose_level > g_verbose_level) {
+        g_verbose_level = args.verbose_level;
+        g_verbose = (g_verbose_level >= 2);
+    }
+    const int status = RunCommand(args);
+    g_verbose_level = saved_level;
+    g_verbose = (g_verbose_level >= 2);
+    return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Run one command line forwarded by a daemon client.
+ */
+static int RunDaemonRequest(const std::vector<std::string>& forwarded)
+{
+    return RunCommandLine(forwarded, "Daemon");
+}
+
+/**
+ * @brief Split a batch script line into arguments.
+ * @details Whitespace separates arguments; single or double quotes group
+ *          them. Everything after an unquoted '#' is a comment.
+ */
+static std::vector<std::string> SplitBatchLine(const std::string& line)
+{
+    std::vector<std::string> tokens;
+    std::string current;
+    bool in_token = false;
+    char quote = 0;
+    for (char c : line) {
+        if (quote != 0) {
+            if (c == quote) {
+                quote = 0;
+            } else {
+                current.push_back(c);
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            in_token = true;
+        } else if (c == '#') {
+            break;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (in_token) {
+                tokens.push_back(current);
+                current.clear();
+                in_token = false;
+            }
+        } else {
+            current.push_back(c);
+            in_token = true;
+        }
+    }
+    if (in_token) {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Run every command of a batch script against one open device.
+ * @param path Script file, or "-" for stdin. One ftx command line per line.
+ * @param stop_on_error Stop at the first failing step.
+ * @return 1 if every step succeeded, 0 otherwise.
+ */
+static int RunBatch(const std::string& path, bool stop_on_error)
+{
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "[Batch] Can't open the script '" << path << "'" << std::endl;
+            return 0;
+        }
+    }
+    std::istream& in = (path == "-") ? std::cin : file;
+
+    struct Step {
+        unsigned int line_no;
+        std::string text;
+        std::vector<std::string> tokens;
+    };
+    std::vector<Step> steps;
+    std::string line;
+    unsigned int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        std::vector<std::string> tokens = SplitBatchLine(line);
+        if (!tokens.empty()) {
+            steps.push_back({line_no, line, std::move(tokens)});
+        }
+    }
+
+    const auto batch_start = std::chrono::steady_clock::now();
+    std::size_t succeeded = 0;
+    std::size_t failed = 0;
+    for (std::size_t i = 0; i < steps.size() && !ftdi::g_interrupt_flag; ++i) {
+        const Step& step = steps[i];
+        const auto step_start = std::chrono::steady_clock::now();
+        const int status = RunCommandLine(step.tokens, "Batch");
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - step_start;
+
+        const bool ok = (status == EXIT_SUCCESS);
+        ok ? ++succeeded : ++failed;
+        std::cout << "[Batch] step " << (i + 1) << "/" << steps.size() << " (line " << step.line_no << ") "
+                  << (ok ? "OK" : "FAILED") << " in " << std::fixed << std::setprecision(3) << elapsed.count()
+                  << " s: " << step.text << std::defaultfloat << std::endl;
+        if (!ok && stop_on_error) {
+            std::cerr << "[Batch] Stopping after failed step " << (i + 1) << std::endl;
+            break;
+        }
+    }
+
+    const std::chrono::duration<double> total = std::chrono::steady_clock::now() - batch_start;
+    std::cout << "[Batch] " << succeeded << " succeeded, " << failed << " failed, "
+              << (steps.size() - succeeded - failed) << " skipped in " << std::fixed << std::setprecision(3)
+              << total.count() << " s" << std::defaultfloat << std::endl;
+    return failed == 0 && succeeded == steps.size();
+}
+
+/**
+ * @brief Strip the client-only options from argv before forwarding it.
+ */
+static std::vector<std::string> ClientForwardedArgs(int argc, char* argv[])
+{
+    std::vector<std::string> forwarded;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--client" || arg == "-client") {
+            continue;
+        }
+        if (arg == "--socket" || arg == "-socket") {
+            ++i;
+            continue;
+        }
+        if (arg.rfind("--socket=", 0) == 0 || arg.rfind("-socket=", 0) == 0) {
+            continue;
+        }
+        forwarded.push_back(arg);
+    }
+    return forwarded;
+}
+
 /**
  * @brief Main entry point for the Sega Saturn USB flash cart transfer utility.
  * @param argc Argument count.
@@ -397,11 +756,16 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
  */
 int main(int argc, char *argv[])
 {
-    CommandLineArgs args = parse_args(argc, argv);
+    CommandLineArgs args;
+    try {
+        args = parse_args(argc, argv);
+    } catch (const ParseExit& e) {
+        return e.code;
+    }
     g_verbose_level = args.verbose_level;
     g_verbose = (g_verbose_level >= 2);
 
-    if (args.command == CommandLineArgs::NONE && !args.terminal && !args.console && !args.tcp_proxy && !args.webdav) {
+    if (args.command == CommandLineArgs::NONE && !args.terminal && !args.console && !args.tcp_proxy && !args.webdav && !args.daemon && args.batch_file.empty()) {
         PrintUsage(argv[0]);
         exit(EXIT_FAILURE);
     }
@@ -426,8 +790,11 @@ int main(int argc, char *argv[])
         exit(EXIT_SUCCESS);
     }
 
-    if (ftdi::InitComms(args.vid, args.pid, args.serial)) {
-        atexit(ftdi::CloseComms);
+    if (args.client) {
+        return ftdi::DoDaemonClient(args.socket_path, ClientForwardedArgs(argc, argv));
+    }
+
+    if (OpenTransport(args)) {
         signal(SIGINT, ftdi::Signal);
         signal(SIGTERM, ftdi::Signal);
     #ifndef _WIN32
@@ -439,60 +806,23 @@ int main(int argc, char *argv[])
         signal(SIGFPE, CoreDumpSignalHandler);
         signal(SIGILL, CoreDumpSignalHandler);
 
-        int status = 1;
-        switch (args.command) {
-            case CommandLineArgs::DOWNLOAD:
-                status = xfer::DoDownload(args.filename.c_str(), args.address, args.length);
-                break;
-            case CommandLineArgs::UPLOAD:
-                status = xfer::DoUpload(args.filename.c_str(), args.address);
-                break;
-            case CommandLineArgs::EXEC:
-                status = xfer::DoExecute(args.filename.c_str(), args.address);
-                break;
-            case CommandLineArgs::RUN:
-                status = xfer::DoRun(args.address);
-                break;
-            case CommandLineArgs::DUMP:
-                status = xfer::DoBiosDump(args.filename.c_str());
-                break;
-            case CommandLineArgs::LS:
-                status = xfer::DoList(args.filename.c_str());
-                break;
-            case CommandLineArgs::RM:
-                status = xfer::DoRemove(args.filename.c_str());
-                break;
-            case CommandLineArgs::MKDIR:
-                status = xfer::DoMkdir(args.filename.c_str());
-                break;
-            case CommandLineArgs::RMDIR:
-                status = xfer::DoRmdir(args.filename.c_str());
-                break;
-            case CommandLineArgs::CP:
-                status = xfer::DoSdUpload(args.filename.c_str(), args.target.c_str());
-                break;
-            case CommandLineArgs::CRC:
-                status = xfer::DoCrc(args.filename.c_str());
-                break;
-            case CommandLineArgs::GET:
-                status = xfer::DoSdDownload(args.filename.c_str(), args.target.c_str());
-                break;
-            case CommandLineArgs::SYNC:
-                status = xfer::DoSdSync(args.filename.c_str(), args.target.c_str(), args.sync_mode);
-                break;
-            default:
-                break;
-        }
-
-        if (status == 0) {
+        if (!RunCommand(args)) {
+            return EXIT_FAILURE;
+        }
+
+        if (!args.batch_file.empty() && !RunBatch(args.batch_file, args.stop_on_error)) {
             return EXIT_FAILURE;
         }
+
+        if (args.daemon) {
+            return ftdi::DoDaemon(args.socket_path, RunDaemonRequest);
+        }
         
         if (args.tcp_proxy) {
-            return ftdi::DoTcpProxy(args.tcp_port, (g_verbose_level >= 1));
+            return ftdi::DoTcpProxy(args.tcp_port, (g_verbose_level >= 1), args.gdb_cache, args.gdb_upload);
         }
         if (args.webdav) {
-            return ftdi::DoWebDavServer(args.webdav_port);
+            return ftdi::DoWebDavServer(args.webdav_port, args.webdav_cache_ttl);
         }
         if (args.terminal) {
             ftdi::DoConsole(true);
@@ -0,0 +1,188 @@
+/**
+ * @file sha1.cpp
+ * @brief Portable SHA-1 implementation (FIPS 180-4).
+ */
+
+#include "sha1.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sha1 {
+
+namespace {
+
+inline uint32_t rotl(uint32_t value, unsigned bits) noexcept
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+} // namespace
+
+/**
+ * @copydoc sha1::Hasher::Hasher
+ */
+Hasher::Hasher() noexcept
+    : state_{0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U, 0xC3D2E1F0U}
+{
+}
+
+/**
+ * @brief Process one 64-byte block.
+ */
+void Hasher::compress(const unsigned char* block) noexcept
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 80; ++i) {
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state_[0];
+    uint32_t b = state_[1];
+    uint32_t c = state_[2];
+    uint32_t d = state_[3];
+    uint32_t e = state_[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999U;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1U;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDCU;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6U;
+        }
+        const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+}
+
+/**
+ * @copydoc sha1::Hasher::update
+ */
+void Hasher::update(const unsigned char* data, std::size_t data_len) noexcept
+{
+    if (data_len == 0) {
+        return;
+    }
+    length_ += data_len;
+    if (block_used_ > 0) {
+        const std::size_t take = std::min(sizeof(block_) - block_used_, data_len);
+        std::memcpy(block_ + block_used_, data, take);
+        block_used_ += take;
+        data += take;
+        data_len -= take;
+        if (block_used_ < sizeof(block_)) {
+            return;
+        }
+        compress(block_);
+        block_used_ = 0;
+    }
+    while (data_len >= sizeof(block_)) {
+        compress(data);
+        data += sizeof(block_);
+        data_len -= sizeof(block_);
+    }
+    std::memcpy(block_, data, data_len);
+    block_used_ = data_len;
+}
+
+/**
+ * @copydoc sha1::Hasher::finish
+ */
+digest_t Hasher::finish() noexcept
+{
+    const uint64_t bit_length = length_ * 8;
+    block_[block_used_++] = 0x80;
+    if (block_used_ > 56) {
+        std::memset(block_ + block_used_, 0, sizeof(block_) - block_used_);
+        compress(block_);
+        block_used_ = 0;
+    }
+    std::memset(block_ + block_used_, 0, 56 - block_used_);
+    for (int i = 0; i < 8; ++i) {
+        block_[56 + i] = static_cast<unsigned char>(bit_length >> (56 - 8 * i));
+    }
+    compress(block_);
+
+    digest_t digest;
+    for (std::size_t i = 0; i < 5; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(state_[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state_[i]);
+    }
+    return digest;
+}
+
+/**
+ * @copydoc sha1::hash
+ */
+digest_t hash(const unsigned char* data, std::size_t data_len) noexcept
+{
+    Hasher hasher;
+    hasher.update(data, data_len);
+    return hasher.finish();
+}
+
+/**
+ * @copydoc sha1::to_hex
+ */
+std::string to_hex(const digest_t& digest)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(kDigestSize * 2);
+    for (uint8_t byte : digest) {
+        hex.push_back(digits[byte >> 4]);
+        hex.push_back(digits[byte & 0x0F]);
+    }
+    return hex;
+}
+
+/**
+ * @copydoc sha1::from_hex
+ */
+bool from_hex(const std::string& hex, digest_t& digest) noexcept
+{
+    if (hex.size() != kDigestSize * 2) {
+        return false;
+    }
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (std::size_t i = 0; i < kDigestSize; ++i) {
+        const int hi = nibble(hex[i * 2]);
+        const int lo = nibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        digest[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return true;
+}
+
+} // namespace sha1
@@ -0,0 +1,108 @@
+/**
+ * @file transport.cpp
+ * @brief Active transport registry and the libftdi transport backend.
+ */
+
+#include <ftdi.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ftdi.hpp"
+#include "transport.hpp"
+
+namespace transport {
+
+namespace {
+
+/**
+ * @brief Transport backed by the USB dev cart through libftdi.
+ * @details Bulk reads and writes go through the asynchronous engine in
+ *          ftdi_async.cpp; ReadSome keeps the synchronous ftdi_read_data
+ *          call so streaming loops return after one latency period.
+ *          Reads and writes use separate parts of the libftdi context and
+ *          separate endpoints, so each direction has its own lock; Purge()
+ *          resets the read buffer too and takes both.
+ */
+class FtdiTransport : public Transport {
+public:
+    const char* Name() const override { return "ftdi"; }
+
+    bool Write(const unsigned char* data, std::size_t size) override
+    {
+        if (size == 0)
+        {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        return ftdi::WriteAsync(data, size);
+    }
+
+    long Read(unsigned char* data, std::size_t size, int idle_timeout_ms) override
+    {
+        std::lock_guard<std::mutex> lock(read_mutex_);
+        return ftdi::ReadAsync(data, size, idle_timeout_ms);
+    }
+
+    int ReadSome(unsigned char* data, std::size_t size) override
+    {
+        std::lock_guard<std::mutex> lock(read_mutex_);
+        return ftdi_read_data(&ftdi::g_Device, data, static_cast<int>(size));
+    }
+
+    bool Purge() override
+    {
+        std::scoped_lock lock(read_mutex_, write_mutex_);
+        return ftdi_tcioflush(&ftdi::g_Device) >= 0;
+    }
+
+    std::string LastError() const override
+    {
+        const char* msg = ftdi_get_error_string(&ftdi::g_Device);
+        return msg != nullptr ? msg : "";
+    }
+
+private:
+    std::mutex read_mutex_;
+    std::mutex write_mutex_;
+};
+
+std::unique_ptr<Transport>& ActiveSlot()
+{
+    static std::unique_ptr<Transport> s_active;
+    return s_active;
+}
+
+} // namespace
+
+/**
+ * @copydoc transport::Active
+ */
+Transport& Active()
+{
+    std::unique_ptr<Transport>& slot = ActiveSlot();
+    if (!slot)
+    {
+        slot = MakeFtdiTransport();
+    }
+    return *slot;
+}
+
+/**
+ * @copydoc transport::SetActive
+ */
+void SetActive(std::unique_ptr<Transport> link)
+{
+    ActiveSlot() = std::move(link);
+}
+
+/**
+ * @copydoc transport::MakeFtdiTransport
+ */
+std::unique_ptr<Transport> MakeFtdiTransport()
+{
+    return std::make_unique<FtdiTransport>();
+}
+
+} // namespace transport
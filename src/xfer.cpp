@@ -29,28 +29,54 @@
 
 #include <ftdi.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "crc.hpp"
 #include "ftdi.hpp"
 #include "log.hpp"
+#include "lzf_upload.hpp"
+#include "remote_io.hpp"
 #include "saturn.hpp"
+#include "sha1.hpp"
+#include "transport.hpp"
 #include "xfer.hpp"
 
+// satcom_lib headers are C (sc_common.h pulls in sc_compress.h).
+extern "C" {
 #include "sc_common.h"
+#include "sc_compress.h"
+}
 
 namespace xfer
 {
@@ -75,32 +101,12 @@ namespace xfer
         }
     };
 
-    constexpr uint8_t REMOTE_IO_MAGIC[4] = {'S', 'R', 'L', '1'};
     constexpr uint32_t SDC_BLOCK_SIZE = 512;
 
-    enum class RemoteIoCommand : uint8_t
-    {
-      LIST = 1,
-      REMOVE = 2,
-      CRC = 3,
-      UPLOAD = 4,
-      MKDIR = 5,
-      RMDIR = 6,
-      RENAME = 7,
-      DOWNLOAD = 8
-    };
-
-    enum class RemoteIoStatus : uint8_t
-    {
-      OK = 0,
-      ERR = 1,
-      UNSUPPORTED = 2,
-      BAD_REQUEST = 3
-    };
-
     struct RemoteIoReply
     {
       RemoteIoStatus status = RemoteIoStatus::ERR;
+      uint8_t flags = 0; ///< REMOTE_IO_FLAG_* bits of a framed reply
       std::string payload;
     };
 
@@ -184,59 +190,79 @@ namespace xfer
 
     bool WriteAllToDevice(const uint8_t *data, std::size_t size)
     {
-      std::size_t written = 0;
-      while (written < size && !ftdi::g_interrupt_flag)
+      return transport::Active().Write(data, size);
+    }
+
+    bool ReadExactFromDevice(uint8_t *data, std::size_t size,
+                             int idle_timeout_ms = ftdi::kAsyncIdleTimeoutMs)
+    {
+      const long rc = transport::Active().Read(data, size, idle_timeout_ms);
+      if (rc < 0)
       {
-        int rc = ftdi_write_data(&ftdi::g_Device,
-                                 const_cast<unsigned char *>(data + written),
-                                 static_cast<int>(size - written));
-        if (rc < 0)
-        {
-          std::cerr << "[RemoteIO] Write error: "
-                    << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-          return false;
-        }
-        if (rc == 0)
+        return false;
+      }
+      if (static_cast<std::size_t>(rc) != size)
+      {
+        if (!ftdi::g_interrupt_flag)
         {
-          std::this_thread::sleep_for(std::chrono::milliseconds(1));
-          continue;
+          cdbg << "[RemoteIO] Timeout waiting for device reply (" << rc << "/"
+               << size << " bytes)." << std::endl;
         }
-        written += static_cast<std::size_t>(rc);
+        return false;
       }
-      return written == size;
+      return true;
     }
 
-    bool ReadExactFromDevice(uint8_t *data, std::size_t size,
-                             int max_idle_cycles = 5000)
+    /**
+     * @brief Wait for the one-byte result the device sends after a transfer.
+     * @details The device answers only once it finished writing, and an SD
+     *          card may take a long time to finalize a file, so this waits
+     *          until the byte arrives, the link fails or the user interrupts
+     *          instead of applying the idle timeout of ReadExactFromDevice.
+     */
+    bool ReadResultFromDevice(uint8_t *result)
     {
-      std::size_t read = 0;
-      int idleCycles = 0;
-
-      while (read < size && !ftdi::g_interrupt_flag)
+      while (!ftdi::g_interrupt_flag)
       {
-        int rc = ftdi_read_data(&ftdi::g_Device,
-                                reinterpret_cast<unsigned char *>(data + read),
-                                static_cast<int>(size - read));
+        const long rc = transport::Active().Read(result, 1, ftdi::kAsyncIdleTimeoutMs);
         if (rc < 0)
         {
-          std::cerr << "[RemoteIO] Read error: "
-                    << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
           return false;
         }
-        if (rc == 0)
+        if (rc == 1)
         {
-          if (++idleCycles >= max_idle_cycles)
-          {
-            std::cerr << "[RemoteIO] Timeout waiting for device reply." << std::endl;
-            return false;
-          }
-          std::this_thread::sleep_for(std::chrono::milliseconds(1));
-          continue;
+          return true;
         }
-        idleCycles = 0;
-        read += static_cast<std::size_t>(rc);
+        cdbg << "[RemoteIO] Still waiting for the device result..." << std::endl;
+      }
+      return false;
+    }
+
+    /**
+     * @brief Requests sent so far that can change the SD card contents.
+     */
+    std::atomic<uint32_t> g_sd_modification_count{0};
+
+    /**
+     * @brief Count @p command in g_sd_modification_count if it changes the card.
+     */
+    void NoteRemoteIoCommand(RemoteIoCommand command)
+    {
+      switch (command)
+      {
+      case RemoteIoCommand::REMOVE:
+      case RemoteIoCommand::UPLOAD:
+      case RemoteIoCommand::MKDIR:
+      case RemoteIoCommand::RMDIR:
+      case RemoteIoCommand::RENAME:
+      case RemoteIoCommand::PATCH:
+      case RemoteIoCommand::WRITE:
+      case RemoteIoCommand::COPY:
+        ++g_sd_modification_count;
+        break;
+      default:
+        break;
       }
-      return read == size;
     }
 
     bool SendRemoteIoCommand(RemoteIoCommand command, const char *argument)
@@ -254,6 +280,7 @@ namespace xfer
         return false;
       }
 
+      NoteRemoteIoCommand(command);
       uint8_t header[7] = {
           REMOTE_IO_MAGIC[0],
           REMOTE_IO_MAGIC[1],
@@ -278,11 +305,11 @@ namespace xfer
     }
 
     // Returns: 1 = reply received, 0 = timed out (no more data), -1 = protocol error
-    int TryReadRemoteIoReply(RemoteIoReply &reply, int header_idle_cycles)
+    int TryReadRemoteIoReply(RemoteIoReply &reply, int header_timeout_ms)
     {
       uint8_t header[7] = {};
       // Use the short timeout only for the header; if nothing arrives, it's end-of-list.
-      if (!ReadExactFromDevice(header, sizeof(header), header_idle_cycles))
+      if (!ReadExactFromDevice(header, sizeof(header), header_timeout_ms))
       {
         // Distinguish timeout (idle cycles exhausted) from read error by checking
         // whether we received any bytes at all.  ReadExactFromDevice already printed
@@ -296,7 +323,8 @@ namespace xfer
         return -1;
       }
 
-      reply.status = static_cast<RemoteIoStatus>(header[4]);
+      reply.status = static_cast<RemoteIoStatus>(header[4] & REMOTE_IO_STATUS_MASK);
+      reply.flags = static_cast<uint8_t>(header[4] & ~REMOTE_IO_STATUS_MASK);
       const std::size_t payloadLen =
           (static_cast<std::size_t>(header[5]) << 8) |
           static_cast<std::size_t>(header[6]);
@@ -314,7 +342,12 @@ namespace xfer
 
     bool ReadRemoteIoReply(RemoteIoReply &reply)
     {
-      return TryReadRemoteIoReply(reply, 5000) == 1;
+      const int rc = TryReadRemoteIoReply(reply, ftdi::kAsyncIdleTimeoutMs);
+      if (rc == 0 && !ftdi::g_interrupt_flag)
+      {
+        std::cerr << "[RemoteIO] Timeout waiting for device reply." << std::endl;
+      }
+      return rc == 1;
     }
 
     int ExecuteRemoteIoCommand(RemoteIoCommand command, const char *argument,
@@ -374,6 +407,7 @@ namespace xfer
         return false;
       }
 
+      NoteRemoteIoCommand(RemoteIoCommand::RENAME);
       uint8_t header[7] = {
           REMOTE_IO_MAGIC[0],
           REMOTE_IO_MAGIC[1],
@@ -443,854 +477,2754 @@ namespace xfer
       return 0;
     }
 
-    template <typename WriteFunc>
-    bool StreamAndCrc(FILE* f, crc8::crc_t& checksum_out, WriteFunc write_func)
+    /**
+     * @brief Most tagged requests the host keeps in flight, whatever the device advertises.
+     */
+    constexpr std::size_t REMOTE_IO_MAX_PIPELINE = 16;
+
+    /**
+     * @brief Wait for the VERSION reply before treating the device as SRL1 only.
+     */
+    constexpr int REMOTE_IO_PROBE_TIMEOUT_MS = 1000;
+
+    /**
+     * @brief Commands whose reply is several packets ended by an empty OK packet.
+     */
+    bool IsMultiPacketRemoteIoCommand(RemoteIoCommand command)
     {
-      // Use a larger buffer (e.g., 64KB) to optimize file I/O and match USB chunk capabilities
-      std::vector<unsigned char> buffer(xfer::USB_READPACKET_SIZE);
-      crc8::crc_t checksum = 0;
-      size_t bytes_read;
-      while ((bytes_read = fread(buffer.data(), 1, buffer.size(), f)) > 0)
+      return command == RemoteIoCommand::LIST || command == RemoteIoCommand::TREE ||
+             command == RemoteIoCommand::BLOCK_SUMS;
+    }
+
+    /**
+     * @brief Whether @p reply is a HASH progress packet rather than the result.
+     */
+    bool IsRemoteIoProgressPacket(RemoteIoCommand command, const RemoteIoReply &reply)
+    {
+      return command == RemoteIoCommand::HASH && reply.status == RemoteIoStatus::OK &&
+             reply.payload.size() == REMOTE_IO_HASH_PROGRESS_SIZE;
+    }
+
+    /**
+     * @brief Send one SRL1 packet, or a tagged SRL2 packet when @p tag is not negative.
+     * @details Header and payload go out in a single write.
+     */
+    bool SendRemoteIoPacket(RemoteIoCommand command, const std::string &payload, int tag)
+    {
+      if (payload.size() > REMOTE_IO_MAX_PAYLOAD)
       {
-        if (!write_func(buffer.data(), bytes_read))
-        {
-          return false;
-        }
-        checksum = crc8::crc_update(checksum, buffer.data(), bytes_read);
+        std::cerr << "[RemoteIO] Path/file argument too long." << std::endl;
+        return false;
       }
-      if (ferror(f))
+
+      NoteRemoteIoCommand(command);
+      const uint8_t *magic = (tag < 0) ? REMOTE_IO_MAGIC : REMOTE_IO_TAGGED_MAGIC;
+      std::vector<uint8_t> packet(magic, magic + sizeof(REMOTE_IO_MAGIC));
+      packet.reserve(REMOTE_IO_TAGGED_HEADER_SIZE + payload.size());
+      packet.push_back(static_cast<uint8_t>(command));
+      if (tag >= 0)
       {
-        std::cerr << "[DoSdUpload] File read error." << std::endl;
-        return false;
+        packet.push_back(static_cast<uint8_t>((tag >> 8) & 0xFFU));
+        packet.push_back(static_cast<uint8_t>(tag & 0xFFU));
       }
-      checksum_out = checksum;
-      return true;
+      packet.push_back(static_cast<uint8_t>((payload.size() >> 8) & 0xFFU));
+      packet.push_back(static_cast<uint8_t>(payload.size() & 0xFFU));
+      packet.insert(packet.end(), payload.begin(), payload.end());
+      return WriteAllToDevice(packet.data(), packet.size());
     }
-  }
-
-  unsigned char SendBuf[2 * WRITE_PAYLOAD_SIZE];
-  unsigned char RecvBuf[2 * READ_PAYLOAD_SIZE];
-
-  /**
-   * @brief Send a command with address and length to the device.
-   * @param cmd Command code.
-   * @param address Target address.
-   * @param size Data size.
-   * @return Number of bytes written, or negative on error.
-   */
-  int SendCommandWithAddressAndLength(unsigned int cmd, uint32_t address,
-                                      unsigned int size)
-  {
-    uint8_t i = 0;
-
-    // Step 1: Set the command code in the send buffer
-    SendBuf[i++] = cmd;
-    // Step 2: Extract and store the address bytes in big-endian order
-    SendBuf[i++] = static_cast<unsigned char>(address >> 24);
-    SendBuf[i++] = static_cast<unsigned char>(address >> 16);
-    SendBuf[i++] = static_cast<unsigned char>(address >> 8);
-    SendBuf[i++] = static_cast<unsigned char>(address);
-    // Step 3: Extract and store the size bytes in big-endian order
-    SendBuf[i++] = static_cast<unsigned char>(size >> 24);
-    SendBuf[i++] = static_cast<unsigned char>(size >> 16);
-    SendBuf[i++] = static_cast<unsigned char>(size >> 8);
-    SendBuf[i++] = static_cast<unsigned char>(size);
 
-    // Step 4: If the command is for execution, append four zero bytes for reset
-    // flag
-    if (USBDC_FUNC_EXEC_EXT == cmd)
+    // Returns: 1 = reply received, 0 = timed out, -1 = protocol error
+    int TryReadTaggedRemoteIoReply(uint16_t &tag, RemoteIoReply &reply, int header_timeout_ms)
     {
-      SendBuf[i++] = 0x00;
-      SendBuf[i++] = 0x00;
-      SendBuf[i++] = 0x00;
-      SendBuf[i++] = 0x00;
-    }
-
-    // Step 5: Write the command buffer to the FTDI device
-    return ftdi_write_data(&ftdi::g_Device, SendBuf, i);
-  }
+      uint8_t header[REMOTE_IO_TAGGED_HEADER_SIZE] = {};
+      if (!ReadExactFromDevice(header, sizeof(header), header_timeout_ms))
+      {
+        return 0;
+      }
 
-  /**
-   * @brief Print transfer performance statistics.
-   * @param start Start time of transfer.
-   * @param end End time of transfer.
-   * @param size Number of bytes transferred.
-   */
-  void ReportPerformance(const std::chrono::steady_clock::time_point &start,
-                         const std::chrono::steady_clock::time_point &end,
-                         unsigned int size)
-  {
-    using namespace std::chrono;
-    // Step 1: Calculate the duration of the transfer in microseconds
-    auto delta_us = duration_cast<microseconds>(end - start).count();
-    // Step 2: Convert duration to seconds
-    double seconds = delta_us / 1'000'000.0;
-    // Step 3: Calculate transfer speed in KB/s
-    double speed_kb_s = (size / 1024.0) / seconds;
-    // Step 4: Output transfer time
-    cdbg << "Transfer time: " << std::fixed << std::setprecision(3)
-              << seconds << " s" << std::endl;
-    // Step 5: Output transfer speed
-    cdbg << "Transfer speed: " << std::fixed << std::setprecision(2)
-              << speed_kb_s << " KB/s" << std::endl;
-  }
+      if (std::memcmp(header, REMOTE_IO_TAGGED_MAGIC, sizeof(REMOTE_IO_TAGGED_MAGIC)) != 0)
+      {
+        std::cerr << "[RemoteIO] Invalid tagged response magic from device." << std::endl;
+        return -1;
+      }
 
-  /**
-   * @copydoc xfer::DoBiosDump
-   */
-  int DoBiosDump(const char *filename)
-  {
-    // Step 1: Log the start of the BIOS dump process
-    cdbg << "[DoBiosDump] Starting BIOS dump to file: " << filename
-              << std::endl;
-    // Step 2: Call DoDownload to perform the dump from the BIOS address and size
-    return DoDownload(filename, saturn::bios_address, saturn::bios_size);
-  }
+      reply.status = static_cast<RemoteIoStatus>(header[4] & REMOTE_IO_STATUS_MASK);
+      reply.flags = static_cast<uint8_t>(header[4] & ~REMOTE_IO_STATUS_MASK);
+      tag = static_cast<uint16_t>((header[5] << 8) | header[6]);
+      const std::size_t payloadLen =
+          (static_cast<std::size_t>(header[7]) << 8) |
+          static_cast<std::size_t>(header[8]);
 
-  /**
-   * @copydoc xfer::DoList
-   */
-  int DoList(const char *path)
-  {
-    if (!SendRemoteIoCommand(RemoteIoCommand::LIST, path))
-    {
-      return 0;
+      reply.payload.clear();
+      reply.payload.resize(payloadLen);
+      if (payloadLen > 0 &&
+          !ReadExactFromDevice(reinterpret_cast<uint8_t *>(&reply.payload[0]),
+                               payloadLen))
+      {
+        return -1;
+      }
+      return 1;
     }
 
-    // First packet uses the full timeout so the device has time to respond.
-    RemoteIoReply reply;
-    if (!ReadRemoteIoReply(reply))
+    /**
+     * @brief Remote-IO features negotiated with the device.
+     */
+    struct RemoteIoCaps
     {
-      return 0;
-    }
+      std::size_t pipeline_depth = 0; ///< Tagged requests in flight, 0 if SRL1 only
+      bool framed_replies = false;    ///< Replies carry REMOTE_IO_FLAG_MORE/FINAL
+      bool chunked_transfers = false; ///< READ and WRITE are available
+    };
 
-    for (;;)
+    /**
+     * @brief Features of the device on the active transport.
+     * @details Negotiated with RemoteIoCommand::VERSION once per transport;
+     *          the request advertises the host version so the device enables
+     *          framed replies.
+     */
+    const RemoteIoCaps &GetRemoteIoCaps()
     {
-      if (!reply.payload.empty())
-      {
-        std::cout << reply.payload;
-        if (reply.payload.back() != '\n')
-        {
-          std::cout << '\n';
-        }
-      }
+      static const transport::Transport *probed = nullptr;
+      static RemoteIoCaps caps;
 
-      if (reply.status != RemoteIoStatus::OK)
+      transport::Transport &link = transport::Active();
+      if (probed == &link)
       {
-        std::cerr << "[DoList] Device returned status "
-                  << static_cast<int>(reply.status) << std::endl;
-        return 0;
+        return caps;
       }
 
-      if (reply.payload.empty())
+      caps = RemoteIoCaps();
+      if (!SendRemoteIoPacket(RemoteIoCommand::VERSION,
+                              std::string(1, static_cast<char>(REMOTE_IO_VERSION_CHUNKED)), -1))
       {
-        // Empty payload + OK = explicit end-of-listing sentinel from device.
-        return 1;
+        return caps;
       }
 
-      // Try to read the next packet.  Use a short inter-packet timeout (200 ms)
-      // so that a single-packet response exits promptly instead of hanging for
-      // the full 5-second idle timeout.
-      const int rc = TryReadRemoteIoReply(reply, 200);
-      if (rc == 0)
+      RemoteIoReply reply;
+      const int rc = TryReadRemoteIoReply(reply, REMOTE_IO_PROBE_TIMEOUT_MS);
+      if (rc != 1)
       {
-        // Timeout: no more packets — listing is complete.
-        return 1;
+        // Older firmware may drop unknown commands; discard any late bytes.
+        link.Purge();
       }
-      if (rc < 0)
+      else if (reply.status == RemoteIoStatus::OK && !reply.payload.empty())
       {
-        return 0;
+        const uint8_t version = static_cast<uint8_t>(reply.payload[0]);
+        if (version >= REMOTE_IO_VERSION_TAGGED && reply.payload.size() >= 2)
+        {
+          caps.pipeline_depth = std::min<std::size_t>(static_cast<uint8_t>(reply.payload[1]),
+                                                      REMOTE_IO_MAX_PIPELINE);
+        }
+        caps.framed_replies = (version >= REMOTE_IO_VERSION_FRAMED);
+        caps.chunked_transfers = (version >= REMOTE_IO_VERSION_CHUNKED);
       }
+      probed = &link;
+      cdbg << "[RemoteIO] Tagged request pipeline depth: " << caps.pipeline_depth
+           << ", framed replies: " << (caps.framed_replies ? "yes" : "no")
+           << ", chunked transfers: " << (caps.chunked_transfers ? "yes" : "no") << std::endl;
+      return caps;
     }
-  }
 
-  /**
-   * @copydoc xfer::DoListStr
-   */
-  int DoListStr(const char *path, std::string &out_listing)
-  {
-    if (!SendRemoteIoCommand(RemoteIoCommand::LIST, path))
+    /**
+     * @brief Whether @p reply is the last packet of a LIST or TREE reply.
+     * @details Framed replies say so in their flags. Otherwise the reply ends
+     *          with the empty OK sentinel or a non-OK status.
+     */
+    bool IsLastRemoteIoPacket(const RemoteIoReply &reply, bool framed)
     {
-      return 0;
+      if (framed && (reply.flags & (REMOTE_IO_FLAG_MORE | REMOTE_IO_FLAG_FINAL)) != 0)
+      {
+        return (reply.flags & REMOTE_IO_FLAG_MORE) == 0;
+      }
+      return reply.status != RemoteIoStatus::OK || reply.payload.empty();
     }
 
-    // First packet uses the full timeout so the device has time to respond.
-    RemoteIoReply reply;
-    if (!ReadRemoteIoReply(reply))
+    /**
+     * @brief Read every packet of an SRL1 LIST or TREE reply.
+     * @details Framed replies end at the packet flagged final. Unframed ones
+     *          end at the sentinel or, for firmware that sends none, after
+     *          200 ms without data.
+     * @param framed GetRemoteIoCaps().framed_replies, read before sending the request.
+     * @param on_packet Called for each packet.
+     * @return false on link or protocol error.
+     */
+    bool ReadRemoteIoMultiReply(bool framed, const std::function<void(const RemoteIoReply &)> &on_packet)
     {
-      return 0;
-    }
+      // First packet uses the full timeout so the device has time to respond.
+      RemoteIoReply reply;
+      if (!ReadRemoteIoReply(reply))
+      {
+        return false;
+      }
 
-    for (;;)
-    {
-      if (!reply.payload.empty())
+      for (;;)
       {
-        out_listing += reply.payload;
-        if (out_listing.back() != '\n')
+        on_packet(reply);
+        if (IsLastRemoteIoPacket(reply, framed))
         {
-          out_listing += '\n';
+          return true;
+        }
+
+        const int rc = TryReadRemoteIoReply(reply, framed ? ftdi::kAsyncIdleTimeoutMs : 200);
+        if (rc == 0)
+        {
+          if (!framed)
+          {
+            // Timeout: no more packets, listing is complete.
+            return true;
+          }
+          if (!ftdi::g_interrupt_flag)
+          {
+            std::cerr << "[RemoteIO] Timeout waiting for device reply." << std::endl;
+          }
+          return false;
+        }
+        if (rc < 0)
+        {
+          return false;
         }
       }
+    }
 
-      if (reply.status != RemoteIoStatus::OK)
+    /**
+     * @brief Run one batch request over plain SRL1 and wait for its reply.
+     * @return false on link or protocol error.
+     */
+    bool RunRemoteIoRequest(RemoteIoBatchItem &item, bool framed)
+    {
+      if (!SendRemoteIoPacket(item.command, item.argument, -1))
       {
-        std::cerr << "[DoListStr] Device returned status "
-                  << static_cast<int>(reply.status) << std::endl;
-        return 0;
+        return false;
       }
 
-      if (reply.payload.empty())
+      item.reply.clear();
+      if (IsMultiPacketRemoteIoCommand(item.command))
       {
-        // Empty payload + OK = explicit end-of-listing sentinel from device.
-        return 1;
+        return ReadRemoteIoMultiReply(framed, [&item](const RemoteIoReply &packet) {
+          item.status = packet.status;
+          item.reply += packet.payload;
+        });
       }
 
-      // Try to read the next packet.  Use a short inter-packet timeout (200 ms)
-      // so that a single-packet response exits promptly instead of hanging for
-      // the full 5-second idle timeout.
-      const int rc = TryReadRemoteIoReply(reply, 200);
-      if (rc == 0)
+      RemoteIoReply reply;
+      do
       {
-        // Timeout: no more packets — listing is complete.
-        return 1;
-      }
-      if (rc < 0)
+        if (!ReadRemoteIoReply(reply))
+        {
+          return false;
+        }
+      } while (IsRemoteIoProgressPacket(item.command, reply));
+      item.status = reply.status;
+      item.reply = reply.payload;
+      return true;
+    }
+
+    /**
+     * @brief Run batch requests as tagged SRL2 requests, @p depth at a time.
+     * @return false on link or protocol error.
+     */
+    bool RunRemoteIoPipeline(std::vector<RemoteIoBatchItem> &items, std::size_t depth, bool framed)
+    {
+      std::map<uint16_t, std::size_t> in_flight;
+      std::size_t next = 0;
+      std::size_t done = 0;
+      uint16_t next_tag = 0;
+
+      while (done < items.size())
       {
-        return 0;
+        while (in_flight.size() < depth && next < items.size())
+        {
+          if (!SendRemoteIoPacket(items[next].command, items[next].argument, next_tag))
+          {
+            return false;
+          }
+          items[next].reply.clear();
+          in_flight[next_tag++] = next++;
+        }
+
+        uint16_t tag = 0;
+        RemoteIoReply reply;
+        const int rc = TryReadTaggedRemoteIoReply(tag, reply, ftdi::kAsyncIdleTimeoutMs);
+        if (rc == 0)
+        {
+          if (!ftdi::g_interrupt_flag)
+          {
+            std::cerr << "[RemoteIO] Timeout waiting for device reply." << std::endl;
+          }
+          return false;
+        }
+        if (rc < 0)
+        {
+          return false;
+        }
+
+        const auto it = in_flight.find(tag);
+        if (it == in_flight.end())
+        {
+          std::cerr << "[RemoteIO] Reply for unknown request ID " << tag << std::endl;
+          return false;
+        }
+
+        RemoteIoBatchItem &item = items[it->second];
+        if (IsRemoteIoProgressPacket(item.command, reply))
+        {
+          continue;
+        }
+        item.status = reply.status;
+        item.reply += reply.payload;
+        if (IsMultiPacketRemoteIoCommand(item.command) && !IsLastRemoteIoPacket(reply, framed))
+        {
+          continue;
+        }
+        in_flight.erase(it);
+        ++done;
       }
+      return true;
     }
-  }
 
-  /**
-   * @copydoc xfer::DoRemove
-   */
-  int DoRemove(const char *path)
-  {
-    return ExecuteRemoteIoCommand(RemoteIoCommand::REMOVE, path, "DoRemove");
-  }
+    /**
+     * @brief Number of pooled buffers in the upload read-ahead ring.
+     */
+    constexpr std::size_t READ_AHEAD_SLOTS = 4;
 
-  /**
-   * @copydoc xfer::DoRename
-   */
-  int DoRename(const char *old_path, const char *new_path)
-  {
-    return ExecuteRemoteIoRenameCommand(old_path, new_path, "DoRename");
+    /**
+     * @brief Read-ahead stage of the file upload pipeline.
+     * @details A reader thread fills a ring of pooled buffers from the file and
+     *          folds every chunk into the running CRC-8, while the caller drains
+     *          filled buffers into the USB link. Disk reads, checksumming and
+     *          USB submission of consecutive chunks therefore overlap.
+     */
+    class ReadAheadRing
+    {
+    public:
+      /**
+       * @brief Start the reader thread.
+       * @param f Open file, read from its current position to EOF.
+       * @param slot_size Size of each pooled buffer.
+       */
+      ReadAheadRing(FILE* f, std::size_t slot_size)
+          : file_(f), buffers_(READ_AHEAD_SLOTS, std::vector<unsigned char>(slot_size)),
+            lengths_(READ_AHEAD_SLOTS, 0), reader_(&ReadAheadRing::ReaderLoop, this)
+      {
+      }
+
+      ~ReadAheadRing()
+      {
+        Abort();
+        reader_.join();
+      }
+
+      ReadAheadRing(const ReadAheadRing&) = delete;
+      ReadAheadRing& operator=(const ReadAheadRing&) = delete;
+
+      /**
+       * @brief Wait for the next filled buffer.
+       * @param[out] data Start of the chunk, valid until Release().
+       * @param[out] size Chunk length.
+       * @return false once the file is exhausted or the reader failed.
+       */
+      bool Acquire(const unsigned char*& data, std::size_t& size)
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return filled_ > 0 || done_; });
+        if (filled_ == 0)
+        {
+          return false;
+        }
+        data = buffers_[head_].data();
+        size = lengths_[head_];
+        return true;
+      }
+
+      /**
+       * @brief Hand the buffer returned by Acquire() back to the reader.
+       */
+      void Release()
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          head_ = (head_ + 1) % buffers_.size();
+          --filled_;
+        }
+        cv_.notify_all();
+      }
+
+      /**
+       * @brief Stop the reader early (consumer side failure).
+       */
+      void Abort()
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          aborted_ = true;
+        }
+        cv_.notify_all();
+      }
+
+      /**
+       * @brief True if the reader hit a file error.
+       * @note Only meaningful once Acquire() returned false.
+       */
+      bool ReadFailed() const
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return read_failed_;
+      }
+
+      /**
+       * @brief CRC-8 of everything read so far.
+       * @note Only meaningful once Acquire() returned false.
+       */
+      crc8::crc_t Checksum() const
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return checksum_;
+      }
+
+    private:
+      void ReaderLoop()
+      {
+#ifdef POSIX_FADV_SEQUENTIAL
+        // Let the kernel read ahead of the ring too (ignored for pipes).
+        (void)posix_fadvise(fileno(file_), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        crc8::crc_t checksum = 0;
+        std::size_t tail = 0;
+        bool failed = false;
+        for (;;)
+        {
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return filled_ < buffers_.size() || aborted_; });
+            if (aborted_)
+            {
+              break;
+            }
+          }
+
+          // The slot at tail is owned by this thread until it is published.
+          std::vector<unsigned char>& buffer = buffers_[tail];
+          const std::size_t bytes_read = fread(buffer.data(), 1, buffer.size(), file_);
+          if (bytes_read == 0)
+          {
+            failed = ferror(file_) != 0;
+            break;
+          }
+          checksum = crc8::crc_update(checksum, buffer.data(), bytes_read);
+
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lengths_[tail] = bytes_read;
+            ++filled_;
+          }
+          cv_.notify_all();
+          tail = (tail + 1) % buffers_.size();
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          checksum_ = checksum;
+          read_failed_ = failed;
+          done_ = true;
+        }
+        cv_.notify_all();
+      }
+
+      FILE* file_;
+      std::vector<std::vector<unsigned char>> buffers_;
+      std::vector<std::size_t> lengths_;
+      std::size_t head_ = 0;
+      std::size_t filled_ = 0;
+      bool done_ = false;
+      bool aborted_ = false;
+      bool read_failed_ = false;
+      crc8::crc_t checksum_ = 0;
+      mutable std::mutex mutex_;
+      std::condition_variable cv_;
+      std::thread reader_;
+    };
+
+    /**
+     * @brief Read a file from its current position to EOF.
+     * @param[out] data Receives the bytes.
+     * @return false on a read error.
+     */
+    bool ReadWholeFile(FILE* f, std::vector<uint8_t>& data)
+    {
+      uint8_t chunk[64 * 1024];
+      std::size_t n;
+      data.clear();
+      while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+      {
+        data.insert(data.end(), chunk, chunk + n);
+      }
+      return ferror(f) == 0;
+    }
+
+    /**
+     * @brief Read-only memory mapping of the unread part of a regular file.
+     * @details Lets uploads hand page-cache backed spans straight to the USB
+     *          write path instead of copying them into a buffer first. Mapping
+     *          fails (and callers fall back to the read-ahead ring) for pipes,
+     *          character devices, empty files and on Windows.
+     */
+    class MappedFile
+    {
+    public:
+      /**
+       * @brief Map @p f from its current position to EOF.
+       */
+      explicit MappedFile(FILE* f)
+      {
+#ifndef _WIN32
+        fd_ = fileno(f);
+        struct stat st;
+        if (fd_ < 0 || fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+          return;
+        }
+        const long pos = ftell(f);
+        if (pos < 0 || st.st_size <= pos)
+        {
+          return;
+        }
+        void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (base == MAP_FAILED)
+        {
+          cdbg << "[MappedFile] mmap failed, using buffered reads" << std::endl;
+          return;
+        }
+        (void)madvise(base, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        base_ = static_cast<unsigned char*>(base);
+        mapped_size_ = static_cast<size_t>(st.st_size);
+        offset_ = static_cast<size_t>(pos);
+#else
+        (void)f;
+#endif
+      }
+
+      ~MappedFile()
+      {
+#ifndef _WIN32
+        if (base_ != nullptr)
+        {
+          munmap(base_, mapped_size_);
+        }
+#endif
+      }
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      bool Valid() const { return base_ != nullptr; }
+      const unsigned char* Data() const { return base_ + offset_; }
+      size_t Size() const { return mapped_size_ - offset_; }
+
+      /**
+       * @brief Check that the file still covers a window before it is touched.
+       * @details Pages past the end of a truncated file raise SIGBUS. The
+       *          check narrows that to a truncation racing the window itself.
+       */
+      bool Covers(size_t offset, size_t len) const
+      {
+#ifndef _WIN32
+        struct stat st;
+        return fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) >= offset_ + offset + len;
+#else
+        (void)offset;
+        (void)len;
+        return false;
+#endif
+      }
+
+      /**
+       * @brief Ask the kernel to start reading a window ahead of its use.
+       */
+      void Prefetch(size_t offset, size_t len) const
+      {
+#ifndef _WIN32
+        // madvise wants a page-aligned start.
+        const size_t start = (offset_ + offset) & ~(static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1);
+        const size_t end = std::min(mapped_size_, offset_ + offset + len);
+        if (start < end)
+        {
+          (void)madvise(base_ + start, end - start, MADV_WILLNEED);
+        }
+#else
+        (void)offset;
+        (void)len;
+#endif
+      }
+
+    private:
+      int fd_ = -1;
+      unsigned char* base_ = nullptr;
+      size_t mapped_size_ = 0;
+      size_t offset_ = 0;
+    };
+
+    template <typename WriteFunc>
+    bool StreamAndCrc(FILE* f, crc8::crc_t& checksum_out, WriteFunc write_func)
+    {
+      // Regular files: send page-cache backed spans without copying them.
+      MappedFile mapped(f);
+      if (mapped.Valid())
+      {
+        crc8::crc_t checksum = 0;
+        for (size_t offset = 0; offset < mapped.Size(); offset += xfer::USB_READPACKET_SIZE)
+        {
+          const size_t len = std::min(xfer::USB_READPACKET_SIZE, mapped.Size() - offset);
+          if (!mapped.Covers(offset, len))
+          {
+            std::cerr << "[DoSdUpload] File was truncated during the upload." << std::endl;
+            return false;
+          }
+          // Fault the next window in while this one is on the wire.
+          mapped.Prefetch(offset + len, xfer::USB_READPACKET_SIZE);
+          checksum = crc8::crc_update(checksum, mapped.Data() + offset, len);
+          if (!write_func(mapped.Data() + offset, len))
+          {
+            return false;
+          }
+        }
+        checksum_out = checksum;
+        return true;
+      }
+
+      // Pipes and other streams: 64KB slots match the USB chunk capabilities;
+      // the reader thread keeps the ring full while the previous chunk is on
+      // the wire.
+      ReadAheadRing ring(f, xfer::USB_READPACKET_SIZE);
+      const unsigned char* data = nullptr;
+      size_t len = 0;
+      while (ring.Acquire(data, len))
+      {
+        const bool written = write_func(data, len);
+        ring.Release();
+        if (!written)
+        {
+          return false;
+        }
+      }
+      if (ring.ReadFailed())
+      {
+        std::cerr << "[DoSdUpload] File read error." << std::endl;
+        return false;
+      }
+      checksum_out = ring.Checksum();
+      return true;
+    }
   }
 
+  unsigned char SendBuf[2 * WRITE_PAYLOAD_SIZE];
+  unsigned char RecvBuf[2 * READ_PAYLOAD_SIZE];
+
   /**
-   * @copydoc xfer::DoMkdir
+   * @brief Send a command with address and length to the device.
+   * @param cmd Command code.
+   * @param address Target address.
+   * @param size Data size.
+   * @return Number of bytes written, or negative on error.
    */
-  int DoMkdir(const char *path)
+  int SendCommandWithAddressAndLength(unsigned int cmd, uint32_t address,
+                                      unsigned int size)
   {
-    return ExecuteRemoteIoCommand(RemoteIoCommand::MKDIR, path, "DoMkdir");
+    uint8_t i = 0;
+
+    // Step 1: Set the command code in the send buffer
+    SendBuf[i++] = cmd;
+    // Step 2: Extract and store the address bytes in big-endian order
+    SendBuf[i++] = static_cast<unsigned char>(address >> 24);
+    SendBuf[i++] = static_cast<unsigned char>(address >> 16);
+    SendBuf[i++] = static_cast<unsigned char>(address >> 8);
+    SendBuf[i++] = static_cast<unsigned char>(address);
+    // Step 3: Extract and store the size bytes in big-endian order
+    SendBuf[i++] = static_cast<unsigned char>(size >> 24);
+    SendBuf[i++] = static_cast<unsigned char>(size >> 16);
+    SendBuf[i++] = static_cast<unsigned char>(size >> 8);
+    SendBuf[i++] = static_cast<unsigned char>(size);
+
+    // Step 4: If the command is for execution, append four zero bytes for reset
+    // flag
+    if (USBDC_FUNC_EXEC_EXT == cmd)
+    {
+      SendBuf[i++] = 0x00;
+      SendBuf[i++] = 0x00;
+      SendBuf[i++] = 0x00;
+      SendBuf[i++] = 0x00;
+    }
+
+    // Step 5: Write the command buffer to the FTDI device
+    return WriteAllToDevice(SendBuf, i) ? i : -1;
   }
 
   /**
-   * @copydoc xfer::DoRmdir
+   * @brief Print transfer performance statistics.
+   * @param start Start time of transfer.
+   * @param end End time of transfer.
+   * @param size Number of bytes transferred.
    */
-  int DoRmdir(const char *path)
+  void ReportPerformance(const std::chrono::steady_clock::time_point &start,
+                         const std::chrono::steady_clock::time_point &end,
+                         unsigned int size)
   {
-    return ExecuteRemoteIoCommand(RemoteIoCommand::RMDIR, path, "DoRmdir");
+    using namespace std::chrono;
+    // Step 1: Calculate the duration of the transfer in microseconds
+    auto delta_us = duration_cast<microseconds>(end - start).count();
+    // Step 2: Convert duration to seconds
+    double seconds = delta_us / 1'000'000.0;
+    // Step 3: Calculate transfer speed in KB/s
+    double speed_kb_s = (size / 1024.0) / seconds;
+    // Step 4: Output transfer time
+    cdbg << "Transfer time: " << std::fixed << std::setprecision(3)
+              << seconds << " s" << std::endl;
+    // Step 5: Output transfer speed
+    cdbg << "Transfer speed: " << std::fixed << std::setprecision(2)
+              << speed_kb_s << " KB/s" << std::endl;
   }
 
   /**
-   * @copydoc xfer::DoCrc
+   * @copydoc xfer::DoBiosDump
    */
-  int DoCrc(const char *filename)
+  int DoBiosDump(const char *filename)
   {
-    return ExecuteRemoteIoCommand(RemoteIoCommand::CRC, filename, "DoCrc");
+    // Step 1: Log the start of the BIOS dump process
+    cdbg << "[DoBiosDump] Starting BIOS dump to file: " << filename
+              << std::endl;
+    // Step 2: Call DoDownload to perform the dump from the BIOS address and size
+    return DoDownload(filename, saturn::bios_address, saturn::bios_size);
   }
 
   /**
-   * @copydoc xfer::DoDownload
+   * @copydoc xfer::DoList
    */
-  int DoDownload(const char *filename, uint32_t address, std::size_t size)
+  int DoList(const char *path)
   {
-    cdbg << "[DoDownload] Starting download: file='" << filename
-         << "', address=0x" << std::hex << address << ", size=" << std::dec << size << std::endl;
-
-    std::unique_ptr<FILE, FileDeleter> file(fopen(filename, "wb"));
-    if (!file)
+    const bool framed = GetRemoteIoCaps().framed_replies;
+    if (!SendRemoteIoCommand(RemoteIoCommand::LIST, path))
     {
-      std::cerr << "[DoDownload] Error creating output file" << std::endl;
       return 0;
     }
 
-    int status = -1;
-    crc8::crc_t readChecksum = 0, calcChecksum = 0;
-    
-    auto before = std::chrono::steady_clock::now();
+    RemoteIoStatus status = RemoteIoStatus::OK;
+    const bool read_ok = ReadRemoteIoMultiReply(framed, [&status](const RemoteIoReply &packet) {
+      if (!packet.payload.empty())
+      {
+        std::cout << packet.payload;
+        if (packet.payload.back() != '\n')
+        {
+          std::cout << '\n';
+        }
+      }
+      status = packet.status;
+    });
+    if (!read_ok)
+    {
+      return 0;
+    }
+
+    if (status != RemoteIoStatus::OK)
+    {
+      std::cerr << "[DoList] Device returned status "
+                << static_cast<int>(status) << std::endl;
+      return 0;
+    }
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DoListStr
+   */
+  int DoListStr(const char *path, std::string &out_listing)
+  {
+    const bool framed = GetRemoteIoCaps().framed_replies;
+    if (!SendRemoteIoCommand(RemoteIoCommand::LIST, path))
+    {
+      return 0;
+    }
+
+    RemoteIoStatus status = RemoteIoStatus::OK;
+    const bool read_ok = ReadRemoteIoMultiReply(framed, [&](const RemoteIoReply &packet) {
+      if (!packet.payload.empty())
+      {
+        out_listing += packet.payload;
+        if (out_listing.back() != '\n')
+        {
+          out_listing += '\n';
+        }
+      }
+      status = packet.status;
+    });
+    if (!read_ok)
+    {
+      return 0;
+    }
+
+    if (status != RemoteIoStatus::OK)
+    {
+      std::cerr << "[DoListStr] Device returned status "
+                << static_cast<int>(status) << std::endl;
+      return 0;
+    }
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::SdModificationCount
+   */
+  uint32_t SdModificationCount()
+  {
+    return g_sd_modification_count;
+  }
+
+  /**
+   * @copydoc xfer::DoRemove
+   */
+  int DoRemove(const char *path)
+  {
+    return ExecuteRemoteIoCommand(RemoteIoCommand::REMOVE, path, "DoRemove");
+  }
+
+  /**
+   * @copydoc xfer::DoRename
+   */
+  int DoRename(const char *old_path, const char *new_path)
+  {
+    return ExecuteRemoteIoRenameCommand(old_path, new_path, "DoRename");
+  }
+
+  /**
+   * @copydoc xfer::DoMkdir
+   */
+  int DoMkdir(const char *path)
+  {
+    return ExecuteRemoteIoCommand(RemoteIoCommand::MKDIR, path, "DoMkdir");
+  }
+
+  /**
+   * @copydoc xfer::DoRmdir
+   */
+  int DoRmdir(const char *path)
+  {
+    return ExecuteRemoteIoCommand(RemoteIoCommand::RMDIR, path, "DoRmdir");
+  }
+
+  /**
+   * @copydoc xfer::DoCrc
+   */
+  int DoCrc(const char *filename)
+  {
+    return ExecuteRemoteIoCommand(RemoteIoCommand::CRC, filename, "DoCrc");
+  }
+
+  /**
+   * @copydoc xfer::DoRemoteIoBatch
+   */
+  int DoRemoteIoBatch(std::vector<RemoteIoBatchItem> &items)
+  {
+    for (const RemoteIoBatchItem &item : items)
+    {
+      if (item.command == RemoteIoCommand::UPLOAD || item.command == RemoteIoCommand::DOWNLOAD ||
+          item.command == RemoteIoCommand::PATCH)
+      {
+        std::cerr << "[RemoteIO] Transfers can't be batched." << std::endl;
+        return 0;
+      }
+    }
+    if (items.empty())
+    {
+      return 1;
+    }
+
+    const RemoteIoCaps &caps = GetRemoteIoCaps();
+    if (caps.pipeline_depth == 0)
+    {
+      for (RemoteIoBatchItem &item : items)
+      {
+        if (!RunRemoteIoRequest(item, caps.framed_replies))
+        {
+          return 0;
+        }
+      }
+      return 1;
+    }
+
+    if (!RunRemoteIoPipeline(items, caps.pipeline_depth, caps.framed_replies))
+    {
+      // Replies of requests still in flight would poison the next command.
+      transport::Active().Purge();
+      return 0;
+    }
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DecodeSdTree
+   */
+  bool DecodeSdTree(const std::string &stream, std::vector<SdTreeEntry> &entries)
+  {
+    const auto *p = reinterpret_cast<const uint8_t *>(stream.data());
+    std::size_t pos = 0;
+    while (pos < stream.size())
+    {
+      if (stream.size() - pos < REMOTE_IO_TREE_RECORD_HEADER_SIZE)
+      {
+        return false;
+      }
+      const uint8_t *record = p + pos;
+      const std::size_t path_len = (static_cast<std::size_t>(record[9]) << 8) | record[10];
+      pos += REMOTE_IO_TREE_RECORD_HEADER_SIZE;
+      if (stream.size() - pos < path_len)
+      {
+        return false;
+      }
+
+      SdTreeEntry entry;
+      entry.attributes = record[0];
+      entry.is_dir = (record[0] & REMOTE_IO_ATTR_DIRECTORY) != 0;
+      entry.size = (static_cast<uint32_t>(record[1]) << 24) | (static_cast<uint32_t>(record[2]) << 16) |
+                   (static_cast<uint32_t>(record[3]) << 8) | record[4];
+      entry.fat_date = static_cast<uint16_t>((record[5] << 8) | record[6]);
+      entry.fat_time = static_cast<uint16_t>((record[7] << 8) | record[8]);
+      entry.path.assign(stream, pos, path_len);
+      pos += path_len;
+      entries.push_back(std::move(entry));
+    }
+    return true;
+  }
+
+  /**
+   * @copydoc xfer::DoListTree
+   */
+  int DoListTree(const char *path, std::vector<SdTreeEntry> &entries)
+  {
+    if (path == nullptr)
+    {
+      std::cerr << "[RemoteIO] Missing command argument." << std::endl;
+      return 0;
+    }
+
+    std::vector<RemoteIoBatchItem> batch(1);
+    batch[0].command = RemoteIoCommand::TREE;
+    batch[0].argument = path;
+    if (DoRemoteIoBatch(batch) != 1)
+    {
+      return 0;
+    }
+    if (batch[0].status == RemoteIoStatus::UNSUPPORTED)
+    {
+      return -1;
+    }
+    if (batch[0].status != RemoteIoStatus::OK)
+    {
+      std::cerr << "[DoListTree] Device returned status "
+                << static_cast<int>(batch[0].status) << std::endl;
+      return 0;
+    }
+    if (!DecodeSdTree(batch[0].reply, entries))
+    {
+      std::cerr << "[DoListTree] Truncated tree record from device." << std::endl;
+      return 0;
+    }
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DoDownload
+   */
+  int DoDownload(const char *filename, uint32_t address, std::size_t size)
+  {
+    cdbg << "[DoDownload] Starting download: file='" << filename
+         << "', address=0x" << std::hex << address << ", size=" << std::dec << size << std::endl;
+
+    std::unique_ptr<FILE, FileDeleter> file(fopen(filename, "wb"));
+    if (!file)
+    {
+      std::cerr << "[DoDownload] Error creating output file" << std::endl;
+      return 0;
+    }
+
+    int status = -1;
+    crc8::crc_t readChecksum = 0, calcChecksum = 0;
+    
+    auto before = std::chrono::steady_clock::now();
+
+    cdbg << "[DoDownload] Sending download command..." << std::endl;
+    status = xfer::SendCommandWithAddressAndLength(USBDC_FUNC_DOWNLOAD, address, size);
+    if (status < 0)
+    {
+      std::cerr << "[DoDownload] Send download command error: " << transport::Active().LastError() << std::endl;
+      return 0;
+    }
+
+    cdbg << "[DoDownload] Reading data from device..." << std::endl;
+    
+    // Allocate a buffer matching the configured FTDI read chunk size to maximize USB throughput
+    std::vector<unsigned char> buffer(xfer::USB_READPACKET_SIZE);
+    std::size_t received = 0;
+    while (size - received > 0)
+    {
+      size_t to_read = std::min<size_t>(buffer.size(), size - received);
+      if (!ReadExactFromDevice(buffer.data(), to_read))
+      {
+        std::cerr << "[DoDownload] Read data error after " << received << "/" << size << " bytes" << std::endl;
+        return 0;
+      }
+      if (fwrite(buffer.data(), 1, to_read, file.get()) != to_read)
+      {
+        std::cerr << "[DoDownload] File write error" << std::endl;
+        return 0;
+      }
+      calcChecksum = crc8::crc_update(calcChecksum, buffer.data(), to_read);
+      received += to_read;
+      cdbg << "[DoDownload] Received " << received << "/" << size << " bytes..." << std::endl;
+    }
+
+    cdbg << "[DoDownload] Waiting for checksum byte..." << std::endl;
+    if (!ReadExactFromDevice(&readChecksum, 1))
+    {
+      std::cerr << "[DoDownload] Read checksum error" << std::endl;
+      return 0;
+    }
+
+    auto after = std::chrono::steady_clock::now();
+    cdbg << "[DoDownload] Data received. Calculating performance..." << std::endl;
+    xfer::ReportPerformance(before, after, size);
+
+    if (readChecksum != calcChecksum)
+    {
+      std::cerr << "[DoDownload] Checksum error (" << std::hex
+                << static_cast<int>(calcChecksum) << ", should be "
+                << static_cast<int>(readChecksum) << ")" << std::endl;
+      return 0;
+    }
+
+    cdbg << "[DoDownload] Download complete." << std::endl;
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DoUpload
+   */
+  int DoUpload(const char *filename, uint32_t address, const bool execute)
+  {
+    std::string functnName = execute ? "DoUploadExecute" : "DoUpload";
+    cdbg << "[" << functnName << "] Starting upload: file='" << filename
+         << "', address=0x" << std::hex << address << std::dec << std::endl;
+
+    std::error_code ec;
+    uintmax_t file_size_raw = std::filesystem::file_size(filename, ec);
+    if (ec || file_size_raw == 0)
+    {
+      std::cerr << "[" << functnName << "] File is empty or error reading size: " << ec.message() << std::endl;
+      return 0;
+    }
+    
+    if (file_size_raw > std::numeric_limits<uint32_t>::max())
+    {
+      std::cerr << "[" << functnName << "] File is too large for 32-bit address space." << std::endl;
+      return 0;
+    }
+    const uint32_t size = static_cast<uint32_t>(file_size_raw);
+
+    std::unique_ptr<FILE, FileDeleter> file(fopen(filename, "rb"));
+    if (!file)
+    {
+      std::cerr << "[" << functnName << "] Can't open the file '" << filename << "'" << std::endl;
+      return 0;
+    }
+
+    auto before = std::chrono::steady_clock::now();
+
+    if (execute)
+    {
+      cdbg << "[" << functnName << "] Uploading and executing at address 0x" << std::hex << address << std::dec << std::endl;
+      SendBuf[0] = USBDC_FUNC_EXEC_EXT;
+    }
+    else
+    {
+      cdbg << "[" << functnName << "] Uploading to address 0x" << std::hex << address << std::dec << std::endl;
+      SendBuf[0] = USBDC_FUNC_UPLOAD;
+    }
+
+    int status = xfer::SendCommandWithAddressAndLength(SendBuf[0], address, size);
+    if (status < 0)
+    {
+      std::cerr << "[" << functnName << "] Send upload command error: " << transport::Active().LastError() << std::endl;
+      return 0;
+    }
+
+    crc8::crc_t checksum = 0;
+    if (!StreamAndCrc(file.get(), checksum, [&](const unsigned char* data, size_t len) {
+        if (!WriteAllToDevice(data, len))
+        {
+          std::cerr << "[" << functnName << "] Send data error" << std::endl;
+          return false;
+        }
+        cdbg << "[" << functnName << "] Sent chunk..." << std::endl;
+        return true;
+    }))
+    {
+        return 0;
+    }
+
+    SendBuf[0] = static_cast<unsigned char>(checksum);
+    if (!WriteAllToDevice(SendBuf, 1))
+    {
+      std::cerr << "[" << functnName << "] Send checksum error" << std::endl;
+      return 0;
+    }
+
+    if (!ReadResultFromDevice(RecvBuf))
+    {
+      std::cerr << "[" << functnName << "] Read upload result failed" << std::endl;
+      return 0;
+    }
+
+    if (RecvBuf[0] != 0)
+    {
+      std::cerr << "[" << functnName << "] Device reported upload error." << std::endl;
+      return 0;
+    }
+
+    auto after = std::chrono::steady_clock::now();
+    xfer::ReportPerformance(before, after, size);
+    cdbg << "[" << functnName << "] Upload complete." << std::endl;
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DoRun
+   */
+  int DoRun(uint32_t address)
+  {
+    cdbg << "[DoRun] Executing at address 0x" << std::hex << address
+              << std::dec << std::endl;
+
+    // Issue the standard execution command followed by the 4-byte big-endian address
+    SendBuf[0] = USBDC_FUNC_EXEC;
+    SendBuf[1] = static_cast<unsigned char>(address >> 24);
+    SendBuf[2] = static_cast<unsigned char>(address >> 16);
+    SendBuf[3] = static_cast<unsigned char>(address >> 8);
+    SendBuf[4] = static_cast<unsigned char>(address);
+
+    if (!WriteAllToDevice(SendBuf, 5))
+    {
+      std::cerr << "[DoRun] Send execute error" << std::endl;
+      return 0;
+    }
+    
+    cdbg << "[DoRun] Execute command sent successfully." << std::endl;
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DoExecute
+   */
+  int DoExecute(const char *filename, uint32_t address)
+  {
+    cdbg << "[DoExecute] Uploading and executing: file='" << filename
+              << "', address=0x" << std::hex << address << std::dec << std::endl;
+
+    // Delegate to DoUpload with the execute flag enabled, and return its status
+    if (DoUpload(filename, address, true))
+    {
+      cdbg << "[DoExecute] Upload successful. Executing..." << std::endl;
+      return 1;
+    }
+    else
+    {
+      std::cerr << "[DoExecute] Upload failed. Execution aborted." << std::endl;
+      return 0;
+    }
+  }
+
+  namespace
+  {
+    /**
+     * @brief Upload an in-memory buffer with USBDC_FUNC_UPLOAD and check the result byte.
+     * @return 1 on success, 0 on error.
+     */
+    int UploadMemory(const char *label, uint32_t address, const unsigned char *data, size_t size)
+    {
+      if (xfer::SendCommandWithAddressAndLength(USBDC_FUNC_UPLOAD, address, static_cast<unsigned int>(size)) < 0)
+      {
+        std::cerr << "[" << label << "] Send upload command error: " << transport::Active().LastError() << std::endl;
+        return 0;
+      }
+      if (!WriteAllToDevice(data, size))
+      {
+        std::cerr << "[" << label << "] Send data error" << std::endl;
+        return 0;
+      }
+      const crc8::crc_t checksum = crc8::crc_update(0, data, size);
+      if (!WriteAllToDevice(&checksum, 1))
+      {
+        std::cerr << "[" << label << "] Send checksum error" << std::endl;
+        return 0;
+      }
+      unsigned char result = 0;
+      if (!ReadResultFromDevice(&result))
+      {
+        std::cerr << "[" << label << "] Read upload result failed" << std::endl;
+        return 0;
+      }
+      if (result != 0)
+      {
+        std::cerr << "[" << label << "] Device reported upload error." << std::endl;
+        return 0;
+      }
+      return 1;
+    }
+
+    /**
+     * @brief One comp_exec() record of the compressed upload stream.
+     */
+    struct LzfBlock
+    {
+      std::vector<unsigned char> data; ///< comp_exec() output
+      size_t raw_size = 0;             ///< Decompressed size
+    };
+
+    /**
+     * @brief Compress @p data in LZF_UPLOAD_CHUNK_SIZE blocks on all cores.
+     */
+    std::vector<LzfBlock> CompressBlocks(const unsigned char *data, size_t size)
+    {
+      const size_t count = (size + LZF_UPLOAD_CHUNK_SIZE - 1) / LZF_UPLOAD_CHUNK_SIZE;
+      std::vector<LzfBlock> blocks(count);
+      std::atomic<size_t> next{0};
+
+      auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+        {
+          const size_t offset = i * LZF_UPLOAD_CHUNK_SIZE;
+          const size_t len = std::min(LZF_UPLOAD_CHUNK_SIZE, size - offset);
+          LzfBlock &block = blocks[i];
+          block.raw_size = len;
+          block.data.resize(len + SC_COMP_HEADER_MAXSIZE);
+          // comp_exec does not modify its input despite the non-const signature.
+          const unsigned long out_len = comp_exec(const_cast<unsigned char *>(data + offset),
+                                                  static_cast<unsigned long>(len), block.data.data());
+          block.data.resize(out_len);
+        }
+      };
+
+      const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+      std::vector<std::thread> pool;
+      for (size_t w = 1; w < std::min(count, hw); ++w)
+      {
+        pool.emplace_back(worker);
+      }
+      worker();
+      for (std::thread &t : pool)
+      {
+        t.join();
+      }
+      return blocks;
+    }
+
+    void AppendBe32(std::vector<unsigned char> &out, uint32_t value)
+    {
+      out.push_back(static_cast<unsigned char>(value >> 24));
+      out.push_back(static_cast<unsigned char>(value >> 16));
+      out.push_back(static_cast<unsigned char>(value >> 8));
+      out.push_back(static_cast<unsigned char>(value));
+    }
+  }
+
+  /**
+   * @copydoc xfer::DoUploadBuffer
+   */
+  int DoUploadBuffer(uint32_t address, const unsigned char *data, size_t size)
+  {
+    cdbg << "[DoUploadBuffer] Uploading " << size << " bytes to address 0x"
+         << std::hex << address << std::dec << std::endl;
+    return UploadMemory("DoUploadBuffer", address, data, size);
+  }
+
+  /**
+   * @copydoc xfer::DoCompressedUpload
+   */
+  int DoCompressedUpload(const char *filename, uint32_t address, const char *decompressor, const bool execute)
+  {
+    const char *functnName = execute ? "DoCompressedExecute" : "DoCompressedUpload";
+
+    std::ifstream stub_file(decompressor, std::ios::binary);
+    if (!stub_file)
+    {
+      std::cerr << "[" << functnName << "] Can't open the decompressor stub '" << decompressor << "'" << std::endl;
+      return 0;
+    }
+    const std::vector<unsigned char> stub((std::istreambuf_iterator<char>(stub_file)), std::istreambuf_iterator<char>());
+    if (stub.empty() || stub.size() > LZF_UPLOAD_STUB_MAX_SIZE)
+    {
+      std::cerr << "[" << functnName << "] Decompressor stub must be 1.." << LZF_UPLOAD_STUB_MAX_SIZE
+                << " bytes (got " << stub.size() << ")" << std::endl;
+      return 0;
+    }
+
+    std::unique_ptr<FILE, FileDeleter> file(fopen(filename, "rb"));
+    if (!file)
+    {
+      std::cerr << "[" << functnName << "] Can't open the file '" << filename << "'" << std::endl;
+      return 0;
+    }
+
+    // Compression needs the whole image.
+    std::vector<unsigned char> buffered;
+    if (!ReadWholeFile(file.get(), buffered))
+    {
+      std::cerr << "[" << functnName << "] File read error." << std::endl;
+      return 0;
+    }
+    const unsigned char *image = buffered.data();
+    const size_t size = buffered.size();
+    if (size == 0 || size > std::numeric_limits<uint32_t>::max())
+    {
+      std::cerr << "[" << functnName << "] File is empty or too large." << std::endl;
+      return 0;
+    }
+
+    auto before = std::chrono::steady_clock::now();
+    const std::vector<LzfBlock> blocks = CompressBlocks(image, size);
+
+    // Build the stream and find the lowest offset inside the destination at
+    // which it can sit so that no block's output reaches its own input.
+    std::vector<unsigned char> stream;
+    size_t stream_offset = 0;
+    size_t out_end = 0;
+    for (const LzfBlock &block : blocks)
+    {
+      out_end += block.raw_size;
+      if (out_end > stream.size())
+      {
+        stream_offset = std::max(stream_offset, out_end - stream.size());
+      }
+      AppendBe32(stream, static_cast<uint32_t>(block.data.size()));
+      stream.insert(stream.end(), block.data.begin(), block.data.end());
+    }
+    stream_offset = (stream_offset + 3) & ~static_cast<size_t>(3);
+
+    cdbg << "[" << functnName << "] Compressed " << size << " -> " << stream.size() << " bytes in "
+         << blocks.size() << " blocks" << std::endl;
+    if (stream.size() + stub.size() >= size)
+    {
+      cdbg << "[" << functnName << "] Image does not compress, sending it uncompressed" << std::endl;
+      return DoUpload(filename, address, execute);
+    }
+
+    const uint64_t footprint_end = static_cast<uint64_t>(address) + std::max(size, stream_offset + stream.size());
+    const uint64_t stub_end = static_cast<uint64_t>(LZF_UPLOAD_STUB_ADDRESS) + stub.size();
+    if (address < stub_end && footprint_end > LZF_UPLOAD_PARAMS_ADDRESS)
+    {
+      std::cerr << "[" << functnName << "] Destination 0x" << std::hex << address << "..0x" << footprint_end
+                << " overlaps the decompressor area at 0x" << LZF_UPLOAD_PARAMS_ADDRESS << std::dec << std::endl;
+      return 0;
+    }
+
+    const uint32_t stream_address = address + static_cast<uint32_t>(stream_offset);
+    if (!UploadMemory(functnName, stream_address, stream.data(), stream.size()))
+    {
+      return 0;
+    }
+
+    uint32_t params[LZF_UPLOAD_PARAM_COUNT] = {};
+    params[FC_PDATALEN_INDEX] = static_cast<uint32_t>(size);
+    params[FC_EXEADDRS_INDEX] = address;
+    params[FC_COMPDATALEN_INDEX] = static_cast<uint32_t>(stream.size());
+    params[FC_COMPDATACRC_INDEX] = crc8::crc_update(0, stream.data(), stream.size());
+    params[LZF_UPLOAD_STREAMADDR_INDEX] = stream_address;
+    params[LZF_UPLOAD_FLAGS_INDEX] = execute ? LZF_UPLOAD_FLAG_EXECUTE : 0;
+
+    std::vector<unsigned char> stub_image;
+    stub_image.reserve(sizeof(params) + stub.size());
+    for (uint32_t value : params)
+    {
+      AppendBe32(stub_image, value);
+    }
+    stub_image.insert(stub_image.end(), stub.begin(), stub.end());
+    if (!UploadMemory(functnName, LZF_UPLOAD_PARAMS_ADDRESS, stub_image.data(), stub_image.size()))
+    {
+      return 0;
+    }
+
+    if (!DoRun(LZF_UPLOAD_STUB_ADDRESS))
+    {
+      return 0;
+    }
+
+    auto after = std::chrono::steady_clock::now();
+    xfer::ReportPerformance(before, after, size);
+    cdbg << "[" << functnName << "] Compressed upload complete." << std::endl;
+    return 1;
+  }
+
+  namespace
+  {
+    // READ/WRITE chunks per pipelined batch; progress is committed between batches.
+    constexpr std::size_t CHUNKED_BATCH_SIZE = 16;
+
+    // Batches in a row without progress before a chunked transfer gives up.
+    constexpr int CHUNKED_RETRIES = 3;
+
+    std::string Be32String(uint32_t value)
+    {
+      return {static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8),
+              static_cast<char>(value)};
+    }
+
+    uint32_t PayloadBe32(const std::string &payload, std::size_t pos = 0)
+    {
+      const auto *p = reinterpret_cast<const uint8_t *>(payload.data()) + pos;
+      return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+             (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    // Size of a card file; false if it is missing or on error.
+    bool QuerySdFileSize(const char *saturn_sd_path, uint32_t &size)
+    {
+      std::vector<RemoteIoBatchItem> batch(1);
+      batch[0].command = RemoteIoCommand::READ;
+      batch[0].argument = Be32String(0) + Be32String(0) + saturn_sd_path;
+      if (DoRemoteIoBatch(batch) != 1 || batch[0].status != RemoteIoStatus::OK || batch[0].reply.size() < 5)
+      {
+        return false;
+      }
+      size = PayloadBe32(batch[0].reply);
+      return true;
+    }
+
+    // Block signature of the card copy of a file, decoded from a BLOCK_SUMS reply.
+    struct BlockSignature
+    {
+      uint32_t file_size = 0;
+      std::vector<uint32_t> weak;
+      std::vector<uint8_t> strong; ///< REMOTE_IO_BLOCK_STRONG_SIZE bytes per block
+      std::unordered_map<uint32_t, std::vector<uint32_t>> blocks; ///< Weak sum -> block indexes
+    };
+
+    bool DecodeBlockSignature(const std::string &stream, BlockSignature &sig)
+    {
+      const auto *p = reinterpret_cast<const uint8_t *>(stream.data());
+      if (stream.size() < 4)
+      {
+        return false;
+      }
+      sig.file_size = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                      (static_cast<uint32_t>(p[2]) << 8) | p[3];
+      const std::size_t count = sig.file_size / REMOTE_IO_DELTA_BLOCK_SIZE;
+      if (stream.size() != 4 + count * REMOTE_IO_BLOCK_SUM_SIZE)
+      {
+        return false;
+      }
+      sig.weak.resize(count);
+      sig.strong.resize(count * REMOTE_IO_BLOCK_STRONG_SIZE);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const uint8_t *record = p + 4 + i * REMOTE_IO_BLOCK_SUM_SIZE;
+        sig.weak[i] = (static_cast<uint32_t>(record[0]) << 24) | (static_cast<uint32_t>(record[1]) << 16) |
+                      (static_cast<uint32_t>(record[2]) << 8) | record[3];
+        std::memcpy(&sig.strong[i * REMOTE_IO_BLOCK_STRONG_SIZE], record + 4, REMOTE_IO_BLOCK_STRONG_SIZE);
+        sig.blocks[sig.weak[i]].push_back(static_cast<uint32_t>(i));
+      }
+      return true;
+    }
+
+    // A size match alone would splice a rewritten or stale card file into the
+    // resumed result, so the card confirms the prefix before it is trusted.
+
+    // Resume offset of a download that the card file confirms: the partial
+    // @p host_file before @p offset is compared with the card's BLOCK_SUMS of
+    // @p saturn_sd_path. Only whole blocks count, and any mismatch or missing
+    // BLOCK_SUMS support restarts from 0.
+    uint32_t VerifiedDownloadOffset(const char *saturn_sd_path, FILE *host_file, uint32_t offset)
+    {
+      const uint32_t verified = offset - offset % REMOTE_IO_DELTA_BLOCK_SIZE;
+      if (verified == 0)
+      {
+        return 0;
+      }
+      std::vector<RemoteIoBatchItem> batch(1);
+      batch[0].command = RemoteIoCommand::BLOCK_SUMS;
+      batch[0].argument = saturn_sd_path;
+      BlockSignature sig;
+      if (DoRemoteIoBatch(batch) != 1 || batch[0].status != RemoteIoStatus::OK ||
+          !DecodeBlockSignature(batch[0].reply, sig) || sig.file_size < verified)
+      {
+        cdbg << "[RemoteIO] Can't verify '" << saturn_sd_path << "' for resuming" << std::endl;
+        return 0;
+      }
+      if (fseek(host_file, 0, SEEK_SET) != 0)
+      {
+        return 0;
+      }
+      uint8_t block[REMOTE_IO_DELTA_BLOCK_SIZE];
+      for (uint32_t i = 0; i < verified / REMOTE_IO_DELTA_BLOCK_SIZE; ++i)
+      {
+        if (fread(block, 1, sizeof(block), host_file) != sizeof(block) ||
+            RemoteIoWeakSum(block, sizeof(block)) != sig.weak[i] ||
+            std::memcmp(sha1::hash(block, sizeof(block)).data(), &sig.strong[i * REMOTE_IO_BLOCK_STRONG_SIZE],
+                        REMOTE_IO_BLOCK_STRONG_SIZE) != 0)
+        {
+          std::cerr << "[RemoteIO] '" << saturn_sd_path << "' changed since the interrupted transfer, starting over."
+                    << std::endl;
+          return 0;
+        }
+      }
+      return verified;
+    }
+
+    // Whether the partial card file @p saturn_sd_path of an upload holds the
+    // first @p card_size bytes of @p host_file, by its HASH. WRITE only
+    // appends at the card file size, so the whole card file must match.
+    bool VerifiedUploadPrefix(const char *saturn_sd_path, FILE *host_file, uint32_t card_size)
+    {
+      if (card_size == 0)
+      {
+        return true;
+      }
+      std::vector<RemoteIoBatchItem> batch(1);
+      batch[0].command = RemoteIoCommand::HASH;
+      batch[0].argument = saturn_sd_path;
+      if (DoRemoteIoBatch(batch) != 1 || batch[0].status != RemoteIoStatus::OK ||
+          batch[0].reply.size() != REMOTE_IO_HASH_REPLY_SIZE || PayloadBe32(batch[0].reply) != card_size ||
+          fseek(host_file, 0, SEEK_SET) != 0)
+      {
+        cdbg << "[RemoteIO] Can't verify '" << saturn_sd_path << "' for resuming" << std::endl;
+        return false;
+      }
+      sha1::Hasher hasher;
+      uint8_t chunk[64 * 1024];
+      for (uint32_t done = 0; done < card_size;)
+      {
+        const std::size_t n = std::min<std::size_t>(sizeof(chunk), card_size - done);
+        if (fread(chunk, 1, n, host_file) != n)
+        {
+          return false;
+        }
+        hasher.update(chunk, n);
+        done += static_cast<uint32_t>(n);
+      }
+      const sha1::digest_t digest = hasher.finish();
+      if (std::memcmp(digest.data(), batch[0].reply.data() + 4, digest.size()) != 0)
+      {
+        std::cerr << "[RemoteIO] '" << saturn_sd_path << "' doesn't hold the interrupted upload, starting over."
+                  << std::endl;
+        return false;
+      }
+      return true;
+    }
+
+    // --resume state, kept next to the host file until the transfer completes:
+    // a "ftx-resume 1" line, "<direction> <size> <mtime>" and the card path.
+    // Progress itself is the size of the partial file.
+    struct ResumeState
+    {
+      std::string direction; ///< "put" or "get"
+      uint64_t size = 0;     ///< Source file size
+      int64_t mtime = 0;     ///< Local source mtime (uploads)
+      std::string saturn_path;
+
+      bool operator==(const ResumeState &other) const
+      {
+        return direction == other.direction && size == other.size && mtime == other.mtime &&
+               saturn_path == other.saturn_path;
+      }
+    };
+
+    std::filesystem::path ResumeStatePath(const char *host_filename)
+    {
+      return std::filesystem::path(std::string(host_filename) + ".ftxpart");
+    }
+
+    bool LoadResumeState(const std::filesystem::path &state_path, ResumeState &state)
+    {
+      std::ifstream in(state_path);
+      std::string header;
+      if (!std::getline(in, header) || header != "ftx-resume 1")
+      {
+        return false;
+      }
+      in >> state.direction >> state.size >> state.mtime;
+      in.ignore(1);
+      return static_cast<bool>(std::getline(in, state.saturn_path));
+    }
+
+    void SaveResumeState(const std::filesystem::path &state_path, const ResumeState &state)
+    {
+      std::ofstream out(state_path, std::ios::trunc);
+      out << "ftx-resume 1\n" << state.direction << ' ' << state.size << ' ' << state.mtime << '\n'
+          << state.saturn_path << '\n';
+      if (!out)
+      {
+        std::cerr << "[RemoteIO] Can't write resume state " << state_path << std::endl;
+      }
+    }
+
+    // Upload from byte @p start with pipelined WRITE chunks pulled from
+    // @p source. The last batch stays buffered, so a failed batch is retried
+    // from the card file size and only unacknowledged chunks are sent again.
+    bool ChunkedSdUpload(const SdUploadSource &source, const char *saturn_sd_path, uint32_t start)
+    {
+      const std::string path(saturn_sd_path);
+      if (path.size() > 0xFFFF)
+      {
+        std::cerr << "[RemoteIO] Path/file argument too long." << std::endl;
+        return false;
+      }
+      const std::string path_field = std::string{static_cast<char>(path.size() >> 8), static_cast<char>(path.size())} + path;
+      const std::size_t window_size = CHUNKED_BATCH_SIZE * REMOTE_IO_CHUNK_SIZE;
+
+      uint32_t acked = start;
+      bool created = (start != 0);
+      bool eof = false;
+      int failures = 0;
+      std::vector<uint8_t> window;
+      uint32_t window_start = start;
+      for (;;)
+      {
+        if (ftdi::g_interrupt_flag)
+        {
+          return false;
+        }
+
+        // Drop what the card acknowledged and top the window up from the source
+        window.erase(window.begin(), window.begin() + (acked - window_start));
+        window_start = acked;
+        while (!eof && window.size() < window_size)
+        {
+          const std::size_t used = window.size();
+          window.resize(window_size);
+          const long n = source(window.data() + used, window_size - used);
+          if (n < 0)
+          {
+            std::cerr << "[DoSdUpload] File read error." << std::endl;
+            return false;
+          }
+          window.resize(used + static_cast<std::size_t>(n));
+          eof = (n == 0);
+        }
+        if (window.empty() && created)
+        {
+          return true;
+        }
+        if (window_start + static_cast<uint64_t>(window.size()) > std::numeric_limits<uint32_t>::max())
+        {
+          std::cerr << "[DoSdUpload] File is too large." << std::endl;
+          return false;
+        }
+        const uint32_t window_end = window_start + static_cast<uint32_t>(window.size());
+
+        std::vector<RemoteIoBatchItem> batch;
+        std::size_t pos = 0;
+        do
+        {
+          const std::size_t len = std::min(REMOTE_IO_CHUNK_SIZE, window.size() - pos);
+          RemoteIoBatchItem item;
+          item.command = RemoteIoCommand::WRITE;
+          item.argument = Be32String(window_start + static_cast<uint32_t>(pos)) + path_field;
+          item.argument.append(reinterpret_cast<const char *>(window.data() + pos), len);
+          item.argument.push_back(static_cast<char>(crc8::crc_update(0, window.data() + pos, len)));
+          batch.push_back(std::move(item));
+          pos += len;
+        } while (pos < window.size());
+
+        const uint32_t before = acked;
+        bool complete = false;
+        if (DoRemoteIoBatch(batch) == 1)
+        {
+          complete = true;
+          for (const RemoteIoBatchItem &item : batch)
+          {
+            if (item.reply.size() < 4)
+            {
+              std::cerr << "[DoSdUpload] Device rejected write: " << static_cast<int>(item.status) << std::endl;
+              return false;
+            }
+            if (!created && item.status != RemoteIoStatus::OK)
+            {
+              // Creating the file failed; the reply is the size of the old one
+              complete = false;
+              break;
+            }
+            // The card holds a verified prefix of the file, whatever the status
+            const uint32_t card_size = PayloadBe32(item.reply);
+            if (card_size < window_start || card_size > window_end)
+            {
+              std::cerr << "[DoSdUpload] Card file size " << card_size << " is outside the data sent." << std::endl;
+              return false;
+            }
+            if (item.status != RemoteIoStatus::OK)
+            {
+              acked = card_size;
+              complete = false;
+              break;
+            }
+            created = true;
+            acked = card_size;
+          }
+        }
+        else
+        {
+          // Replies were lost: the next batch starts where the card says
+          uint32_t card_size = 0;
+          if (created && QuerySdFileSize(saturn_sd_path, card_size) && card_size >= window_start &&
+              card_size <= window_end)
+          {
+            acked = card_size;
+          }
+        }
+
+        if (complete)
+        {
+          failures = 0;
+          continue;
+        }
+        failures = (acked > before) ? 0 : failures + 1;
+        if (failures > CHUNKED_RETRIES)
+        {
+          std::cerr << "[DoSdUpload] Giving up at byte " << acked << "." << std::endl;
+          return false;
+        }
+        std::cerr << "[DoSdUpload] Transfer interrupted, resuming at byte " << acked << std::endl;
+      }
+    }
+
+    // Download up to @p length bytes from byte @p start with pipelined READ
+    // chunks, each checked against its CRC-8 before it is passed to @p sink.
+    // A failed batch is retried from the last verified byte.
+    bool ChunkedSdDownload(const char *saturn_sd_path, uint32_t start, const SdSizeCallback &on_size,
+                           const SdDownloadSink &sink,
+                           uint32_t length = std::numeric_limits<uint32_t>::max())
+    {
+      uint32_t acked = start;
+      bool size_known = false;
+      uint32_t file_size = 0;
+      // End of the requested bytes, clamped to the file size once known
+      uint32_t end = static_cast<uint32_t>(
+          std::min<uint64_t>(static_cast<uint64_t>(start) + length, std::numeric_limits<uint32_t>::max()));
+      int failures = 0;
+      while (!size_known || acked < end)
+      {
+        if (ftdi::g_interrupt_flag)
+        {
+          return false;
+        }
+
+        // The first request learns the file size
+        std::vector<RemoteIoBatchItem> batch;
+        const std::size_t count = size_known ? CHUNKED_BATCH_SIZE : 1;
+        for (uint32_t offset = acked; batch.size() < count && offset < end;
+             offset += static_cast<uint32_t>(REMOTE_IO_CHUNK_SIZE))
+        {
+          const uint32_t chunk = std::min<uint32_t>(static_cast<uint32_t>(REMOTE_IO_CHUNK_SIZE), end - offset);
+          RemoteIoBatchItem item;
+          item.command = RemoteIoCommand::READ;
+          item.argument = Be32String(offset) + Be32String(chunk) + saturn_sd_path;
+          batch.push_back(std::move(item));
+        }
+        if (batch.empty())
+        {
+          // Zero-length range: only the size is needed
+          RemoteIoBatchItem item;
+          item.command = RemoteIoCommand::READ;
+          item.argument = Be32String(acked) + Be32String(0) + saturn_sd_path;
+          batch.push_back(std::move(item));
+        }
+
+        const uint32_t before = acked;
+        bool complete = false;
+        if (DoRemoteIoBatch(batch) == 1)
+        {
+          complete = true;
+          for (const RemoteIoBatchItem &item : batch)
+          {
+            if (item.status != RemoteIoStatus::OK || item.reply.size() < 5)
+            {
+              std::cerr << "[DoSdDownload] Device rejected read: " << static_cast<int>(item.status) << std::endl;
+              return false;
+            }
+            const uint32_t size = PayloadBe32(item.reply);
+            if (size_known && size != file_size)
+            {
+              std::cerr << "[DoSdDownload] File changed on the card during the transfer." << std::endl;
+              return false;
+            }
+            if (!size_known && start > size)
+            {
+              std::cerr << "[DoSdDownload] Partial file is larger than the card file." << std::endl;
+              return false;
+            }
+            if (!size_known && on_size && !on_size(size))
+            {
+              return false;
+            }
+            file_size = size;
+            size_known = true;
+            end = std::min(end, file_size);
+
+            const auto *data = reinterpret_cast<const uint8_t *>(item.reply.data()) + 4;
+            const std::size_t len = item.reply.size() - 5;
+            if (crc8::crc_update(0, data, len) != static_cast<uint8_t>(item.reply.back()) ||
+                (len == 0 && acked < end))
+            {
+              // Corrupted in transit: fetch again from here
+              complete = false;
+              break;
+            }
+            if (len != 0 && !sink(data, len))
+            {
+              return false;
+            }
+            acked += static_cast<uint32_t>(len);
+          }
+        }
+
+        if (complete)
+        {
+          failures = 0;
+          continue;
+        }
+        failures = (acked > before) ? 0 : failures + 1;
+        if (failures > CHUNKED_RETRIES)
+        {
+          std::cerr << "[DoSdDownload] Giving up at byte " << acked << "." << std::endl;
+          return false;
+        }
+        std::cerr << "[DoSdDownload] Transfer interrupted, resuming at byte " << acked << std::endl;
+      }
+      return true;
+    }
+  }
+
+  /**
+   * @copydoc xfer::DoSdUpload
+   */
+  int DoSdUpload(const char *host_filename, const char *saturn_sd_path, bool resume)
+  {
+    std::error_code ec;
+    uintmax_t file_size_raw = std::filesystem::file_size(host_filename, ec);
+    if (ec)
+    {
+      std::cerr << "[DoSdUpload] Failed to determine file size: " << ec.message() << std::endl;
+      return 0;
+    }
+    if (file_size_raw > std::numeric_limits<uint32_t>::max())
+    {
+      std::cerr << "[DoSdUpload] File is too large." << std::endl;
+      return 0;
+    }
+    const uint32_t file_size = static_cast<uint32_t>(file_size_raw);
+
+    std::unique_ptr<FILE, FileDeleter> file(fopen(host_filename, "rb"));
+    if (!file)
+    {
+      std::cerr << "[DoSdUpload] Can't open file '" << host_filename << "'" << std::endl;
+      return 0;
+    }
+
+    if (saturn_sd_path != nullptr && saturn_sd_path[0] == '/')
+    {
+      // Warn if target path violates 8.3 filename limits (Saturn side limitation)
+      std::string path_str(saturn_sd_path);
+      size_t start = 0;
+      while (start < path_str.size())
+      {
+        size_t end = path_str.find('/', start);
+        if (end == std::string::npos)
+        {
+          end = path_str.size();
+        }
+        std::string component = path_str.substr(start, end - start);
+        if (!component.empty())
+        {
+          size_t dot = component.rfind('.');
+          std::string name = (dot == std::string::npos) ? component : component.substr(0, dot);
+          std::string ext = (dot == std::string::npos) ? "" : component.substr(dot + 1);
+          size_t dot_count = std::count(component.begin(), component.end(), '.');
+          if (name.length() > 8 || ext.length() > 3 || dot_count > 1)
+          {
+            std::cerr << "[DoSdUpload] Warning: Target path component \"" << component 
+                      << "\" violates strict 8.3 conventions (max 8 chars name, 3 chars extension). "
+                      << "Saturn device is likely to reject this upload." << std::endl;
+            break;
+          }
+        }
+        start = end + 1;
+      }
+
+      if (GetRemoteIoCaps().chunked_transfers)
+      {
+        const std::filesystem::path state_path = ResumeStatePath(host_filename);
+        ResumeState state;
+        state.direction = "put";
+        state.size = file_size;
+        state.saturn_path = saturn_sd_path;
+        std::error_code mtime_ec;
+        state.mtime = static_cast<int64_t>(
+            std::filesystem::last_write_time(host_filename, mtime_ec).time_since_epoch().count());
+
+        uint32_t offset = 0;
+        if (resume)
+        {
+          ResumeState saved;
+          uint32_t card_size = 0;
+          if (LoadResumeState(state_path, saved) && saved == state &&
+              QuerySdFileSize(saturn_sd_path, card_size) && card_size <= file_size)
+          {
+            offset = VerifiedUploadPrefix(saturn_sd_path, file.get(), card_size) ? card_size : 0;
+          }
+          if (offset != 0)
+          {
+            std::cout << "[DoSdUpload] Resuming at byte " << offset << " of " << file_size << std::endl;
+          }
+          SaveResumeState(state_path, state);
+        }
+        FILE *f = file.get();
+        if (fseek(f, static_cast<long>(offset), SEEK_SET) != 0)
+        {
+          std::cerr << "[DoSdUpload] File seek error." << std::endl;
+          return 0;
+        }
+        const SdUploadSource source = [f](uint8_t *data, std::size_t size) -> long
+        {
+          const std::size_t n = fread(data, 1, size, f);
+          return (n == 0 && ferror(f)) ? -1 : static_cast<long>(n);
+        };
+        if (!ChunkedSdUpload(source, saturn_sd_path, offset))
+        {
+          return 0;
+        }
+        if (resume)
+        {
+          std::error_code remove_ec;
+          std::filesystem::remove(state_path, remove_ec);
+        }
+        return 1;
+      }
+      if (resume)
+      {
+        std::cerr << "[DoSdUpload] Firmware can't resume transfers, sending the whole file." << std::endl;
+      }
+
+      if (!SendRemoteIoCommand(RemoteIoCommand::UPLOAD, saturn_sd_path))
+      {
+        return 0;
+      }
+
+      RemoteIoReply reply;
+      if (!ReadRemoteIoReply(reply))
+      {
+        return 0;
+      }
+
+      if (reply.status != RemoteIoStatus::OK)
+      {
+        std::cerr << "[DoSdUpload] Device rejected upload: "
+                  << static_cast<int>(reply.status) << std::endl;
+        return 0;
+      }
+
+      const unsigned char size_buf[4] = {
+          static_cast<unsigned char>(file_size >> 24),
+          static_cast<unsigned char>(file_size >> 16),
+          static_cast<unsigned char>(file_size >> 8),
+          static_cast<unsigned char>(file_size)};
+      if (!WriteAllToDevice(size_buf, 4))
+      {
+        return 0;
+      }
+
+      crc8::crc_t checksum = 0;
+      if (!StreamAndCrc(file.get(), checksum, [](const unsigned char* data, size_t len) {
+            return WriteAllToDevice(data, len);
+          }))
+      {
+        return 0;
+      }
+
+      if (!WriteAllToDevice(&checksum, 1))
+      {
+        return 0;
+      }
+
+      unsigned char result;
+      if (!ReadResultFromDevice(&result))
+      {
+        return 0;
+      }
+
+      if (result != 0x00)
+      {
+        std::cerr << "[DoSdUpload] Device reported CRC error." << std::endl;
+        return 0;
+      }
+
+      return 1;
+    }
+
+    auto write_all = [](const unsigned char *data, size_t length,
+                        const char *stage) -> bool
+    {
+      if (!WriteAllToDevice(data, length))
+      {
+        std::cerr << "[DoSdUpload] " << stage << " write error" << std::endl;
+        return false;
+      }
+      return true;
+    };
+
+    auto read_one = [](unsigned char *outByte) -> bool
+    {
+      if (!ReadResultFromDevice(outByte))
+      {
+        std::cerr << "[DoSdUpload] Read result error" << std::endl;
+        return false;
+      }
+      return true;
+    };
 
-    cdbg << "[DoDownload] Sending download command..." << std::endl;
-    status = xfer::SendCommandWithAddressAndLength(USBDC_FUNC_DOWNLOAD, address, size);
-    if (status < 0)
+    SdUploadTarget target;
+    if (!ParseSdUploadTarget(saturn_sd_path, target))
     {
-      std::cerr << "[DoDownload] Send download command error: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
       return 0;
     }
 
-    cdbg << "[DoDownload] Reading data from device..." << std::endl;
-    
-    // Allocate a buffer matching the configured FTDI read chunk size to maximize USB throughput
-    std::vector<unsigned char> buffer(xfer::USB_READPACKET_SIZE);
-    std::size_t received = 0;
-    while (size - received > 0 && !ftdi::g_interrupt_flag)
+    const char *filename_for_display = host_filename;
+    for (const char *p = host_filename; *p != '\0'; ++p)
     {
-      size_t to_read = std::min<size_t>(buffer.size(), size - received);
-      status = ftdi_read_data(&ftdi::g_Device, buffer.data(), to_read);
-      if (status < 0)
-      {
-        std::cerr << "[DoDownload] Read data error: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-        return 0;
-      }
-      if (status > 0)
+      if (*p == '/' || *p == '\\')
       {
-        if (fwrite(buffer.data(), 1, status, file.get()) != static_cast<size_t>(status))
-        {
-          std::cerr << "[DoDownload] File write error" << std::endl;
-          return 0;
-        }
-        calcChecksum = crc8::crc_update(calcChecksum, buffer.data(), status);
-        received += status;
-        cdbg << "[DoDownload] Received " << received << "/" << size << " bytes..." << std::endl;
+        filename_for_display = p + 1;
       }
     }
 
-    cdbg << "[DoDownload] Waiting for checksum byte..." << std::endl;
-    do
+    const uint32_t filename_len =
+        static_cast<uint32_t>(std::strlen(filename_for_display));
+
+    if (target.has_range)
     {
-      status = ftdi_read_data(&ftdi::g_Device, reinterpret_cast<unsigned char *>(&readChecksum), 1);
-      if (status < 0)
+      const uint64_t max_bytes = static_cast<uint64_t>(target.sector_count) *
+                                 static_cast<uint64_t>(SDC_BLOCK_SIZE);
+      if (static_cast<uint64_t>(file_size) > max_bytes)
       {
-        std::cerr << "[DoDownload] Read data error: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
+        std::cerr << "[DoSdUpload] File is too large for target range '"
+                  << saturn_sd_path << "' (" << file_size << " bytes > "
+                  << max_bytes << " bytes)." << std::endl;
         return 0;
       }
-    } while (status == 0 && !ftdi::g_interrupt_flag);
-
-    auto after = std::chrono::steady_clock::now();
-    cdbg << "[DoDownload] Data received. Calculating performance..." << std::endl;
-    xfer::ReportPerformance(before, after, size);
-
-    if (readChecksum != calcChecksum)
-    {
-      std::cerr << "[DoDownload] Checksum error (" << std::hex
-                << static_cast<int>(calcChecksum) << ", should be "
-                << static_cast<int>(readChecksum) << ")" << std::endl;
-      return 0;
     }
 
-    cdbg << "[DoDownload] Download complete." << std::endl;
-    return 1;
-  }
-
-  /**
-   * @copydoc xfer::DoUpload
-   */
-  int DoUpload(const char *filename, uint32_t address, const bool execute)
-  {
-    std::string functnName = execute ? "DoUploadExecute" : "DoUpload";
-    cdbg << "[" << functnName << "] Starting upload: file='" << filename
-         << "', address=0x" << std::hex << address << std::dec << std::endl;
-
-    std::error_code ec;
-    uintmax_t file_size_raw = std::filesystem::file_size(filename, ec);
-    if (ec || file_size_raw == 0)
+    // 1. Send Command (0x10)
+    ++g_sd_modification_count;
+    unsigned char cmd = SDRAW_UPLOAD_COMMAND;
+    if (!write_all(&cmd, 1, "Command"))
     {
-      std::cerr << "[" << functnName << "] File is empty or error reading size: " << ec.message() << std::endl;
       return 0;
     }
-    
-    if (file_size_raw > std::numeric_limits<uint32_t>::max())
+
+    // 2. Send display filename length (Big Endian)
+    const unsigned char filename_len_buf[4] = {
+        static_cast<unsigned char>(filename_len >> 24),
+        static_cast<unsigned char>(filename_len >> 16),
+        static_cast<unsigned char>(filename_len >> 8),
+        static_cast<unsigned char>(filename_len)};
+    if (!write_all(filename_len_buf, 4, "Filename length"))
     {
-      std::cerr << "[" << functnName << "] File is too large for 32-bit address space." << std::endl;
       return 0;
     }
-    const uint32_t size = static_cast<uint32_t>(file_size_raw);
 
-    std::unique_ptr<FILE, FileDeleter> file(fopen(filename, "rb"));
-    if (!file)
+    // 3. Send display filename bytes
+    if (filename_len != 0 &&
+        !write_all(reinterpret_cast<const unsigned char *>(filename_for_display),
+                   filename_len, "Filename"))
     {
-      std::cerr << "[" << functnName << "] Can't open the file '" << filename << "'" << std::endl;
       return 0;
     }
 
-    auto before = std::chrono::steady_clock::now();
-
-    if (execute)
-    {
-      cdbg << "[" << functnName << "] Uploading and executing at address 0x" << std::hex << address << std::dec << std::endl;
-      SendBuf[0] = USBDC_FUNC_EXEC_EXT;
-    }
-    else
+    // 4. Send SD start sector (Big Endian)
+    const unsigned char sector_buf[4] = {
+      static_cast<unsigned char>(target.start_sector >> 24),
+      static_cast<unsigned char>(target.start_sector >> 16),
+      static_cast<unsigned char>(target.start_sector >> 8),
+      static_cast<unsigned char>(target.start_sector)};
+    if (!write_all(sector_buf, 4, "Start sector"))
     {
-      cdbg << "[" << functnName << "] Uploading to address 0x" << std::hex << address << std::dec << std::endl;
-      SendBuf[0] = USBDC_FUNC_UPLOAD;
+      return 0;
     }
 
-    int status = xfer::SendCommandWithAddressAndLength(SendBuf[0], address, size);
-    if (status < 0)
+    // 5. Send File Size (Big Endian)
+    const unsigned char size_buf[4] = {
+        static_cast<unsigned char>(file_size >> 24),
+        static_cast<unsigned char>(file_size >> 16),
+        static_cast<unsigned char>(file_size >> 8),
+        static_cast<unsigned char>(file_size)};
+    if (!write_all(size_buf, 4, "File size"))
     {
-      std::cerr << "[" << functnName << "] Send upload command error: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
       return 0;
     }
 
+    // 6. Send File Data & Calculate CRC
     crc8::crc_t checksum = 0;
     if (!StreamAndCrc(file.get(), checksum, [&](const unsigned char* data, size_t len) {
-        size_t sent = 0;
-        while (sent < len && !ftdi::g_interrupt_flag)
-        {
-          int write_status = ftdi_write_data(&ftdi::g_Device, const_cast<unsigned char*>(data + sent), len - sent);
-          if (write_status < 0)
-          {
-            std::cerr << "[" << functnName << "] Send data error: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-            return false;
-          }
-          if (write_status == 0) continue;
-          sent += write_status;
-          cdbg << "[" << functnName << "] Sent chunk..." << std::endl;
-        }
-        return true;
-    }))
+          return write_all(data, len, "File data");
+        }))
     {
-        return 0;
+      return 0;
     }
 
-    SendBuf[0] = static_cast<unsigned char>(checksum);
-    status = ftdi_write_data(&ftdi::g_Device, SendBuf, 1);
-    if (status < 0)
+    // 7. Send Checksum
+    if (!write_all(&checksum, 1, "Checksum"))
     {
-      std::cerr << "[" << functnName << "] Send checksum error: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
       return 0;
     }
 
-    do
-    {
-      status = ftdi_read_data(&ftdi::g_Device, RecvBuf, 1);
-      if (status < 0)
-      {
-        std::cerr << "[" << functnName << "] Read upload result failed: " << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-        return 0;
-      }
-    } while (status == 0 && !ftdi::g_interrupt_flag);
-
-    if (RecvBuf[0] != 0)
+    // 8. Read Result
+    unsigned char result;
+    if (!read_one(&result))
     {
-      std::cerr << "[" << functnName << "] Device reported upload error." << std::endl;
       return 0;
     }
 
-    auto after = std::chrono::steady_clock::now();
-    xfer::ReportPerformance(before, after, size);
-    cdbg << "[" << functnName << "] Upload complete." << std::endl;
-    return 1;
+    return (result == 0x00) ? 1 : 0;
   }
 
-  /**
-   * @copydoc xfer::DoRun
-   */
-  int DoRun(uint32_t address)
+  namespace
   {
-    cdbg << "[DoRun] Executing at address 0x" << std::hex << address
-              << std::dec << std::endl;
-
-    // Issue the standard execution command followed by the 4-byte big-endian address
-    SendBuf[0] = USBDC_FUNC_EXEC;
-    SendBuf[1] = static_cast<unsigned char>(address >> 24);
-    SendBuf[2] = static_cast<unsigned char>(address >> 16);
-    SendBuf[3] = static_cast<unsigned char>(address >> 8);
-    SendBuf[4] = static_cast<unsigned char>(address);
+    // Rsync-style matching: rolls the weak checksum over @p data one byte at a
+    // time, confirms hits with the strong checksum and turns the result into a
+    // PATCH script. Unchanged blocks, shifted or not, become COPY operations.
+    std::vector<uint8_t> BuildDeltaScript(const uint8_t *data, std::size_t size, const BlockSignature &sig,
+                                          std::size_t &literal_bytes, std::size_t &reused_blocks)
+    {
+      const std::size_t n = REMOTE_IO_DELTA_BLOCK_SIZE;
+      std::vector<uint8_t> script;
+      auto append_be32 = [&script](std::size_t value)
+      {
+        script.push_back(static_cast<uint8_t>(value >> 24));
+        script.push_back(static_cast<uint8_t>(value >> 16));
+        script.push_back(static_cast<uint8_t>(value >> 8));
+        script.push_back(static_cast<uint8_t>(value));
+      };
+
+      uint32_t copy_first = 0;
+      uint32_t copy_count = 0;
+      auto flush_copy = [&]()
+      {
+        if (copy_count != 0)
+        {
+          script.push_back(REMOTE_IO_PATCH_COPY);
+          append_be32(copy_first);
+          append_be32(copy_count);
+          copy_count = 0;
+        }
+      };
+      auto emit_data = [&](std::size_t from, std::size_t to)
+      {
+        if (to > from)
+        {
+          flush_copy();
+          script.push_back(REMOTE_IO_PATCH_DATA);
+          append_be32(to - from);
+          script.insert(script.end(), data + from, data + to);
+          literal_bytes += to - from;
+        }
+      };
+      auto strong_matches = [&](uint32_t block, const sha1::digest_t &digest)
+      {
+        return std::memcmp(&sig.strong[block * REMOTE_IO_BLOCK_STRONG_SIZE], digest.data(),
+                           REMOTE_IO_BLOCK_STRONG_SIZE) == 0;
+      };
+
+      literal_bytes = 0;
+      reused_blocks = 0;
+      std::size_t literal_start = 0;
+      std::size_t pos = 0;
+      uint32_t a = 0;
+      uint32_t b = 0;
+      bool have_sum = false;
+      while (pos + n <= size)
+      {
+        if (!have_sum)
+        {
+          const uint32_t weak = RemoteIoWeakSum(data + pos, n);
+          a = weak & 0xFFFF;
+          b = weak >> 16;
+          have_sum = true;
+        }
+        const uint32_t weak = ((b & 0xFFFF) << 16) | (a & 0xFFFF);
+        const auto hit = sig.blocks.find(weak);
+        if (hit != sig.blocks.end())
+        {
+          const sha1::digest_t digest = sha1::hash(data + pos, n);
+          // Try the block that keeps the copy contiguous (or in place) first
+          const std::size_t expected = (copy_count != 0) ? copy_first + copy_count : pos / n;
+          int64_t match = -1;
+          if (expected < sig.weak.size() && sig.weak[expected] == weak &&
+              strong_matches(static_cast<uint32_t>(expected), digest))
+          {
+            match = static_cast<int64_t>(expected);
+          }
+          for (std::size_t i = 0; match < 0 && i < hit->second.size(); ++i)
+          {
+            if (strong_matches(hit->second[i], digest))
+            {
+              match = hit->second[i];
+            }
+          }
+          if (match >= 0)
+          {
+            emit_data(literal_start, pos);
+            const auto block = static_cast<uint32_t>(match);
+            if (copy_count == 0 || copy_first + copy_count != block)
+            {
+              flush_copy();
+              copy_first = block;
+            }
+            copy_count++;
+            reused_blocks++;
+            pos += n;
+            literal_start = pos;
+            have_sum = false;
+            continue;
+          }
+        }
 
-    int status = ftdi_write_data(&ftdi::g_Device, SendBuf, 5);
-    if (status < 0)
-    {
-      std::cerr << "[DoRun] Send execute error: "
-                << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-      return 0;
+        if (pos + n < size)
+        {
+          const uint32_t out = data[pos];
+          a = a - out + data[pos + n];
+          b = b - static_cast<uint32_t>(n) * out + a;
+        }
+        pos++;
+      }
+      emit_data(literal_start, size);
+      flush_copy();
+      return script;
     }
-    
-    cdbg << "[DoRun] Execute command sent successfully." << std::endl;
-    return 1;
   }
 
   /**
-   * @copydoc xfer::DoExecute
+   * @copydoc xfer::DoSdDeltaUpload
+   * @details The FAT layer of the firmware can only write whole files or
+   *          append, so the device rebuilds the file from the PATCH script
+   *          (reading unchanged blocks from the old copy, appending the rest)
+   *          and swaps it in once size and SHA-1 match.
    */
-  int DoExecute(const char *filename, uint32_t address)
+  int DoSdDeltaUpload(const char *host_filename, const char *saturn_sd_path)
   {
-    cdbg << "[DoExecute] Uploading and executing: file='" << filename
-              << "', address=0x" << std::hex << address << std::dec << std::endl;
+    if (host_filename == nullptr || saturn_sd_path == nullptr || saturn_sd_path[0] != '/')
+    {
+      // Raw SD ranges have no previous file to diff against
+      return DoSdUpload(host_filename, saturn_sd_path);
+    }
 
-    // Delegate to DoUpload with the execute flag enabled, and return its status
-    if (DoUpload(filename, address, true))
+    std::unique_ptr<FILE, FileDeleter> file(fopen(host_filename, "rb"));
+    if (!file)
     {
-      cdbg << "[DoExecute] Upload successful. Executing..." << std::endl;
-      return 1;
+      std::cerr << "[DoSdDeltaUpload] Can't open file '" << host_filename << "'" << std::endl;
+      return 0;
     }
-    else
+    std::vector<uint8_t> buffered;
+    if (!ReadWholeFile(file.get(), buffered))
     {
-      std::cerr << "[DoExecute] Upload failed. Execution aborted." << std::endl;
+      std::cerr << "[DoSdDeltaUpload] File read error." << std::endl;
       return 0;
     }
-  }
+    const uint8_t *data = buffered.data();
+    const std::size_t size = buffered.size();
+    if (size < REMOTE_IO_DELTA_BLOCK_SIZE || size > std::numeric_limits<uint32_t>::max())
+    {
+      return DoSdUpload(host_filename, saturn_sd_path);
+    }
 
-  /**
-   * @copydoc xfer::DoSdUpload
-   */
-  int DoSdUpload(const char *host_filename, const char *saturn_sd_path)
-  {
-    std::error_code ec;
-    uintmax_t file_size_raw = std::filesystem::file_size(host_filename, ec);
-    if (ec)
+    std::vector<RemoteIoBatchItem> batch(1);
+    batch[0].command = RemoteIoCommand::BLOCK_SUMS;
+    batch[0].argument = saturn_sd_path;
+    if (DoRemoteIoBatch(batch) != 1)
     {
-      std::cerr << "[DoSdUpload] Failed to determine file size: " << ec.message() << std::endl;
       return 0;
     }
-    if (file_size_raw > std::numeric_limits<uint32_t>::max())
+    if (batch[0].status != RemoteIoStatus::OK)
     {
-      std::cerr << "[DoSdUpload] File is too large." << std::endl;
-      return 0;
+      // Unsupported by the firmware, or no file to patch yet
+      cdbg << "[DoSdDeltaUpload] No block sums for '" << saturn_sd_path << "' (status "
+           << static_cast<int>(batch[0].status) << "), sending the whole file" << std::endl;
+      return DoSdUpload(host_filename, saturn_sd_path);
     }
-    const uint32_t file_size = static_cast<uint32_t>(file_size_raw);
-
-    std::unique_ptr<FILE, FileDeleter> file(fopen(host_filename, "rb"));
-    if (!file)
+    BlockSignature sig;
+    if (!DecodeBlockSignature(batch[0].reply, sig))
     {
-      std::cerr << "[DoSdUpload] Can't open file '" << host_filename << "'" << std::endl;
+      std::cerr << "[DoSdDeltaUpload] Malformed block sums from device." << std::endl;
       return 0;
     }
 
-    if (saturn_sd_path != nullptr && saturn_sd_path[0] == '/')
+    std::size_t literal_bytes = 0;
+    std::size_t reused_blocks = 0;
+    const std::vector<uint8_t> script = BuildDeltaScript(data, size, sig, literal_bytes, reused_blocks);
+    if (script.size() + REMOTE_IO_PATCH_HEADER_SIZE >= size)
     {
-      // Warn if target path violates 8.3 filename limits (Saturn side limitation)
-      std::string path_str(saturn_sd_path);
-      size_t start = 0;
-      while (start < path_str.size())
-      {
-        size_t end = path_str.find('/', start);
-        if (end == std::string::npos)
-        {
-          end = path_str.size();
-        }
-        std::string component = path_str.substr(start, end - start);
-        if (!component.empty())
-        {
-          size_t dot = component.rfind('.');
-          std::string name = (dot == std::string::npos) ? component : component.substr(0, dot);
-          std::string ext = (dot == std::string::npos) ? "" : component.substr(dot + 1);
-          size_t dot_count = std::count(component.begin(), component.end(), '.');
-          if (name.length() > 8 || ext.length() > 3 || dot_count > 1)
-          {
-            std::cerr << "[DoSdUpload] Warning: Target path component \"" << component 
-                      << "\" violates strict 8.3 conventions (max 8 chars name, 3 chars extension). "
-                      << "Saturn device is likely to reject this upload." << std::endl;
-            break;
-          }
-        }
-        start = end + 1;
-      }
+      cdbg << "[DoSdDeltaUpload] Nothing to reuse, sending the whole file" << std::endl;
+      return DoSdUpload(host_filename, saturn_sd_path);
+    }
 
-      if (!SendRemoteIoCommand(RemoteIoCommand::UPLOAD, saturn_sd_path))
-      {
-        return 0;
-      }
+    if (!SendRemoteIoCommand(RemoteIoCommand::PATCH, saturn_sd_path))
+    {
+      return 0;
+    }
+    RemoteIoReply reply;
+    if (!ReadRemoteIoReply(reply))
+    {
+      return 0;
+    }
+    if (reply.status != RemoteIoStatus::OK)
+    {
+      std::cerr << "[DoSdDeltaUpload] Device rejected patch: "
+                << static_cast<int>(reply.status) << std::endl;
+      return 0;
+    }
 
-      RemoteIoReply reply;
-      if (!ReadRemoteIoReply(reply))
+    const sha1::digest_t digest = sha1::hash(data, size);
+    const uint32_t new_size = static_cast<uint32_t>(size);
+    const uint32_t script_size = static_cast<uint32_t>(script.size());
+    unsigned char header[REMOTE_IO_PATCH_HEADER_SIZE] = {
+        static_cast<unsigned char>(new_size >> 24), static_cast<unsigned char>(new_size >> 16),
+        static_cast<unsigned char>(new_size >> 8), static_cast<unsigned char>(new_size)};
+    std::memcpy(header + 4, digest.data(), digest.size());
+    header[24] = static_cast<unsigned char>(script_size >> 24);
+    header[25] = static_cast<unsigned char>(script_size >> 16);
+    header[26] = static_cast<unsigned char>(script_size >> 8);
+    header[27] = static_cast<unsigned char>(script_size);
+    if (!WriteAllToDevice(header, sizeof(header)))
+    {
+      return 0;
+    }
+    for (std::size_t offset = 0; offset < script.size(); offset += xfer::USB_READPACKET_SIZE)
+    {
+      const std::size_t len = std::min(xfer::USB_READPACKET_SIZE, script.size() - offset);
+      if (!WriteAllToDevice(script.data() + offset, len))
       {
         return 0;
       }
+    }
+    const crc8::crc_t checksum = crc8::crc_update(0, script.data(), script.size());
+    if (!WriteAllToDevice(&checksum, 1))
+    {
+      return 0;
+    }
 
-      if (reply.status != RemoteIoStatus::OK)
-      {
-        std::cerr << "[DoSdUpload] Device rejected upload: "
-                  << static_cast<int>(reply.status) << std::endl;
-        return 0;
-      }
+    unsigned char result;
+    if (!ReadResultFromDevice(&result))
+    {
+      return 0;
+    }
+    if (result != 0x00)
+    {
+      std::cerr << "[DoSdDeltaUpload] Device could not apply the patch." << std::endl;
+      return 0;
+    }
 
-      const unsigned char size_buf[4] = {
-          static_cast<unsigned char>(file_size >> 24),
-          static_cast<unsigned char>(file_size >> 16),
-          static_cast<unsigned char>(file_size >> 8),
-          static_cast<unsigned char>(file_size)};
-      if (!WriteAllToDevice(size_buf, 4))
-      {
-        return 0;
-      }
+    std::cout << "[DoSdDeltaUpload] " << saturn_sd_path << ": sent " << literal_bytes << " of " << size
+              << " bytes, " << reused_blocks << " blocks reused." << std::endl;
+    return 1;
+  }
 
-      crc8::crc_t checksum = 0;
-      if (!StreamAndCrc(file.get(), checksum, [](const unsigned char* data, size_t len) {
-            return WriteAllToDevice(data, len);
-          }))
-      {
-        return 0;
-      }
+  /**
+   * @copydoc xfer::DoSdDownload
+   */
+  int DoSdDownload(const char *saturn_sd_path, const char *host_filename, bool resume)
+  {
+    if (saturn_sd_path == nullptr || host_filename == nullptr)
+    {
+      std::cerr << "[DoSdDownload] Missing path/filename argument." << std::endl;
+      return 0;
+    }
 
-      if (!WriteAllToDevice(&checksum, 1))
+    const std::filesystem::path state_path = ResumeStatePath(host_filename);
+    const bool chunked = GetRemoteIoCaps().chunked_transfers;
+    uint32_t offset = 0;
+    if (resume && !chunked)
+    {
+      std::cerr << "[DoSdDownload] Firmware can't resume transfers, downloading the whole file." << std::endl;
+      resume = false;
+    }
+    if (resume)
+    {
+      ResumeState state;
+      state.direction = "get";
+      state.saturn_path = saturn_sd_path;
+      uint32_t card_size = 0;
+      if (!QuerySdFileSize(saturn_sd_path, card_size))
       {
+        std::cerr << "[DoSdDownload] Can't read '" << saturn_sd_path << "' on the card." << std::endl;
         return 0;
       }
+      state.size = card_size;
 
-      unsigned char result;
-      if (!ReadExactFromDevice(&result, 1))
+      // Everything already in the local file was verified when written
+      ResumeState saved;
+      std::error_code ec;
+      const uintmax_t partial = std::filesystem::file_size(host_filename, ec);
+      if (!ec && LoadResumeState(state_path, saved) && saved == state && partial <= card_size)
       {
-        return 0;
+        std::unique_ptr<FILE, FileDeleter> existing(fopen(host_filename, "rb"));
+        if (existing)
+        {
+          offset = VerifiedDownloadOffset(saturn_sd_path, existing.get(), static_cast<uint32_t>(partial));
+        }
       }
-
-      if (result != 0x00)
+      if (offset != 0)
       {
-        std::cerr << "[DoSdUpload] Device reported CRC error." << std::endl;
-        return 0;
+        std::cout << "[DoSdDownload] Resuming at byte " << offset << " of " << card_size << std::endl;
       }
-
-      return 1;
+      SaveResumeState(state_path, state);
     }
 
-    auto write_all = [](const unsigned char *data, size_t length,
-                        const char *stage) -> bool
+    std::unique_ptr<FILE, FileDeleter> file(fopen(host_filename, offset != 0 ? "r+b" : "wb"));
+    if (!file)
     {
-      size_t sent = 0;
-      while (sent < length && !ftdi::g_interrupt_flag)
-      {
-        const int status =
-            ftdi_write_data(&ftdi::g_Device, data + sent, length - sent);
-        if (status < 0)
-        {
-          std::cerr << "[DoSdUpload] " << stage
-                    << " write error: "
-                    << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-          return false;
-        }
-        if (status == 0)
-        {
-          continue;
-        }
-        sent += static_cast<size_t>(status);
-      }
-      return true;
-    };
-
-    auto read_one = [](unsigned char *outByte) -> bool
+      std::cerr << "[DoSdDownload] Can't open file '" << host_filename << "' for writing" << std::endl;
+      return 0;
+    }
+    FILE *f = file.get();
+    if (fseek(f, static_cast<long>(offset), SEEK_SET) != 0)
     {
-      int status = 0;
-      do
+      std::cerr << "[DoSdDownload] File seek error." << std::endl;
+      return 0;
+    }
+    const SdDownloadSink sink = [f](const uint8_t *data, std::size_t size)
+    {
+      if (fwrite(data, 1, size, f) != size)
       {
-        status = ftdi_read_data(&ftdi::g_Device, outByte, 1);
-        if (status < 0)
-        {
-          std::cerr << "[DoSdUpload] Read result error: "
-                    << ftdi_get_error_string(&ftdi::g_Device) << std::endl;
-          return false;
-        }
-      } while (status == 0 && !ftdi::g_interrupt_flag);
-
+        std::cerr << "[DoSdDownload] Write file error." << std::endl;
+        return false;
+      }
       return true;
     };
 
-    SdUploadTarget target;
-    if (!ParseSdUploadTarget(saturn_sd_path, target))
+    const bool ok = chunked ? ChunkedSdDownload(saturn_sd_path, offset, nullptr, sink)
+                            : DoSdDownloadStream(saturn_sd_path, nullptr, sink) == 1;
+    if (!ok)
     {
       return 0;
     }
+    if (resume)
+    {
+      std::error_code ec;
+      std::filesystem::remove(state_path, ec);
+    }
+    return 1;
+  }
 
-    const char *filename_for_display = host_filename;
-    for (const char *p = host_filename; *p != '\0'; ++p)
+
+  /**
+   * @brief Finish an unframed UPLOAD whose source ended early.
+   * @details Sends @p remaining zero bytes and a CRC that can't match, then
+   *          reads the device's (error) result, so the partial file is
+   *          rejected and the link is back in sync.
+   * @param checksum CRC-8 of the bytes sent so far.
+   */
+  static void AbortSdUploadStream(uint32_t remaining, crc8::crc_t checksum)
+  {
+    const std::vector<uint8_t> padding(std::min<std::size_t>(xfer::USB_READPACKET_SIZE, remaining), 0);
+    while (remaining > 0)
     {
-      if (*p == '/' || *p == '\\')
+      const std::size_t len = std::min<std::size_t>(padding.size(), remaining);
+      if (!WriteAllToDevice(padding.data(), len))
       {
-        filename_for_display = p + 1;
+        return;
       }
+      checksum = crc8::crc_update(checksum, padding.data(), len);
+      remaining -= static_cast<uint32_t>(len);
     }
+    const crc8::crc_t bad_checksum = static_cast<crc8::crc_t>(checksum ^ 0xFF);
+    unsigned char result;
+    if (WriteAllToDevice(&bad_checksum, 1) && ReadResultFromDevice(&result) && result == 0x00)
+    {
+      std::cerr << "[DoSdUpload] Device kept the incomplete file." << std::endl;
+    }
+  }
 
-    const uint32_t filename_len =
-        static_cast<uint32_t>(std::strlen(filename_for_display));
-
-    if (target.has_range)
+  /**
+   * @brief Read and drop the rest of an unframed DOWNLOAD.
+   * @details The device sends the whole file and its CRC whatever the host
+   *          does, so an aborted download reads @p remaining data bytes and
+   *          the CRC before the link is used again.
+   */
+  static void DrainSdDownloadStream(uint32_t remaining)
+  {
+    std::vector<uint8_t> buffer(xfer::USB_READPACKET_SIZE);
+    uint64_t left = static_cast<uint64_t>(remaining) + 1;
+    while (left > 0 && !ftdi::g_interrupt_flag)
     {
-      const uint64_t max_bytes = static_cast<uint64_t>(target.sector_count) *
-                                 static_cast<uint64_t>(SDC_BLOCK_SIZE);
-      if (static_cast<uint64_t>(file_size) > max_bytes)
+      const std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(buffer.size(), left));
+      if (!ReadExactFromDevice(buffer.data(), chunk))
       {
-        std::cerr << "[DoSdUpload] File is too large for target range '"
-                  << saturn_sd_path << "' (" << file_size << " bytes > "
-                  << max_bytes << " bytes)." << std::endl;
-        return 0;
+        return;
       }
+      left -= chunk;
     }
+  }
 
-    // 1. Send Command (0x10)
-    unsigned char cmd = 0x10;
-    if (!write_all(&cmd, 1, "Command"))
+  /**
+   * @copydoc xfer::DoSdUploadStream
+   */
+  int DoSdUploadStream(const char *saturn_sd_path, const SdUploadSource &source, int64_t size)
+  {
+    if (saturn_sd_path == nullptr || saturn_sd_path[0] != '/')
     {
+      std::cerr << "[DoSdUpload] Streamed uploads need an absolute FAT path." << std::endl;
       return 0;
     }
-
-    // 2. Send display filename length (Big Endian)
-    const unsigned char filename_len_buf[4] = {
-        static_cast<unsigned char>(filename_len >> 24),
-        static_cast<unsigned char>(filename_len >> 16),
-        static_cast<unsigned char>(filename_len >> 8),
-        static_cast<unsigned char>(filename_len)};
-    if (!write_all(filename_len_buf, 4, "Filename length"))
+    if (GetRemoteIoCaps().chunked_transfers)
     {
+      return ChunkedSdUpload(source, saturn_sd_path, 0) ? 1 : 0;
+    }
+    if (size < 0 || size > std::numeric_limits<uint32_t>::max())
+    {
+      std::cerr << "[DoSdUpload] Firmware needs the upload size up front." << std::endl;
       return 0;
     }
 
-    // 3. Send display filename bytes
-    if (filename_len != 0 &&
-        !write_all(reinterpret_cast<const unsigned char *>(filename_for_display),
-                   filename_len, "Filename"))
+    if (!SendRemoteIoCommand(RemoteIoCommand::UPLOAD, saturn_sd_path))
     {
       return 0;
     }
-
-    // 4. Send SD start sector (Big Endian)
-    const unsigned char sector_buf[4] = {
-      static_cast<unsigned char>(target.start_sector >> 24),
-      static_cast<unsigned char>(target.start_sector >> 16),
-      static_cast<unsigned char>(target.start_sector >> 8),
-      static_cast<unsigned char>(target.start_sector)};
-    if (!write_all(sector_buf, 4, "Start sector"))
+    RemoteIoReply reply;
+    if (!ReadRemoteIoReply(reply))
+    {
+      return 0;
+    }
+    if (reply.status != RemoteIoStatus::OK)
     {
+      std::cerr << "[DoSdUpload] Device rejected upload: " << static_cast<int>(reply.status) << std::endl;
       return 0;
     }
 
-    // 5. Send File Size (Big Endian)
+    const uint32_t file_size = static_cast<uint32_t>(size);
     const unsigned char size_buf[4] = {
-        static_cast<unsigned char>(file_size >> 24),
-        static_cast<unsigned char>(file_size >> 16),
-        static_cast<unsigned char>(file_size >> 8),
-        static_cast<unsigned char>(file_size)};
-    if (!write_all(size_buf, 4, "File size"))
+        static_cast<unsigned char>(file_size >> 24), static_cast<unsigned char>(file_size >> 16),
+        static_cast<unsigned char>(file_size >> 8), static_cast<unsigned char>(file_size)};
+    if (!WriteAllToDevice(size_buf, 4))
     {
       return 0;
     }
 
-    // 6. Send File Data & Calculate CRC
+    // The device expects exactly file_size bytes. If the source ends early,
+    // the rest is padded and sent with a wrong CRC so the device drops the
+    // file and is ready for the next request.
+    std::vector<uint8_t> buffer(xfer::USB_READPACKET_SIZE);
     crc8::crc_t checksum = 0;
-    if (!StreamAndCrc(file.get(), checksum, [&](const unsigned char* data, size_t len) {
-          return write_all(data, len, "File data");
-        }))
+    uint32_t sent = 0;
+    while (sent < file_size)
     {
-      return 0;
+      const std::size_t want = std::min<std::size_t>(buffer.size(), file_size - sent);
+      const long n = source(buffer.data(), want);
+      if (n <= 0)
+      {
+        std::cerr << "[DoSdUpload] Upload data ended after " << sent << " of " << file_size << " bytes." << std::endl;
+        AbortSdUploadStream(file_size - sent, checksum);
+        return 0;
+      }
+      if (!WriteAllToDevice(buffer.data(), static_cast<std::size_t>(n)))
+      {
+        return 0;
+      }
+      checksum = crc8::crc_update(checksum, buffer.data(), static_cast<std::size_t>(n));
+      sent += static_cast<uint32_t>(n);
     }
-
-    // 7. Send Checksum
-    if (!write_all(&checksum, 1, "Checksum"))
+    if (!WriteAllToDevice(&checksum, 1))
     {
       return 0;
     }
 
-    // 8. Read Result
     unsigned char result;
-    if (!read_one(&result))
+    if (!ReadResultFromDevice(&result))
     {
       return 0;
     }
-
-    return (result == 0x00) ? 1 : 0;
+    if (result != 0x00)
+    {
+      std::cerr << "[DoSdUpload] Device reported CRC error." << std::endl;
+      return 0;
+    }
+    return 1;
   }
 
   /**
-   * @copydoc xfer::DoSdDownload
-   * @details Downloads files from the Sega Saturn SD card over HostIO.
-   * Protocol sequence:
+   * @copydoc xfer::DoSdDownloadStream
+   * @details Older firmware streams the whole file:
    * 1. Host sends RemoteIoCommand::DOWNLOAD with target path payload.
    * 2. Saturn replies with RemoteIoStatus and a 4-byte big-endian file size payload.
    * 3. Host reads file data sequentially, accumulating CRC-8 checksum.
    * 4. Saturn sends 1-byte final CRC-8 checksum for verification.
    */
-  int DoSdDownload(const char *saturn_sd_path, const char *host_filename)
+  int DoSdDownloadStream(const char *saturn_sd_path, const SdSizeCallback &on_size, const SdDownloadSink &sink)
   {
-    // Step 1: Validate parameters and attempt to open destination file on the host machine.
-    if (saturn_sd_path == nullptr || host_filename == nullptr)
+    if (saturn_sd_path == nullptr)
     {
       std::cerr << "[DoSdDownload] Missing path/filename argument." << std::endl;
       return 0;
     }
-
-    std::unique_ptr<FILE, FileDeleter> file(fopen(host_filename, "wb"));
-    if (!file)
+    if (GetRemoteIoCaps().chunked_transfers)
     {
-      std::cerr << "[DoSdDownload] Can't open file '" << host_filename << "' for writing" << std::endl;
-      return 0;
+      return ChunkedSdDownload(saturn_sd_path, 0, on_size, sink) ? 1 : 0;
     }
 
-    // Step 2: Send DOWNLOAD command packet containing target SD card path to the console.
     if (!SendRemoteIoCommand(RemoteIoCommand::DOWNLOAD, saturn_sd_path))
     {
       return 0;
     }
-
-    // Step 3: Wait and parse the Remote I/O response status from the console.
     RemoteIoReply reply;
     if (!ReadRemoteIoReply(reply))
     {
       std::cerr << "[DoSdDownload] Failed to read reply." << std::endl;
       return 0;
     }
-
-    if (reply.status != RemoteIoStatus::OK)
+    if (reply.status != RemoteIoStatus::OK || reply.payload.size() < 4)
     {
-      std::cerr << "[DoSdDownload] Device rejected download: "
-                << static_cast<int>(reply.status) << std::endl;
+      std::cerr << "[DoSdDownload] Device rejected download: " << static_cast<int>(reply.status) << std::endl;
       return 0;
     }
 
-    // Step 4: Extract the 32-bit big-endian file size from the reply payload.
-    if (reply.payload.size() < 4)
+    const uint32_t file_size = PayloadBe32(reply.payload);
+    if (on_size && !on_size(file_size))
     {
-      std::cerr << "[DoSdDownload] Invalid response payload size." << std::endl;
+      // The data is already on its way
+      DrainSdDownloadStream(file_size);
       return 0;
     }
 
-    const uint32_t file_size =
-        (static_cast<uint32_t>(static_cast<uint8_t>(reply.payload[0])) << 24) |
-        (static_cast<uint32_t>(static_cast<uint8_t>(reply.payload[1])) << 16) |
-        (static_cast<uint32_t>(static_cast<uint8_t>(reply.payload[2])) << 8) |
-        static_cast<uint32_t>(static_cast<uint8_t>(reply.payload[3]));
-
-    // Step 5: Read the file stream chunk-by-chunk from FTDI and calculate local checksum.
-    uint8_t buffer[4096];
+    std::vector<uint8_t> buffer(xfer::USB_READPACKET_SIZE);
     uint32_t received = 0;
     crc8::crc_t checksum = 0;
     while (received < file_size)
     {
-      uint32_t chunk = file_size - received;
-      if (chunk > sizeof(buffer))
-      {
-        chunk = sizeof(buffer);
-      }
-
-      if (!ReadExactFromDevice(buffer, chunk))
+      const std::size_t chunk = std::min<std::size_t>(buffer.size(), file_size - received);
+      if (!ReadExactFromDevice(buffer.data(), chunk))
       {
         std::cerr << "[DoSdDownload] Read data failed." << std::endl;
         return 0;
       }
-
-      checksum = crc8::crc_update(checksum, buffer, chunk);
-      if (fwrite(buffer, 1, chunk, file.get()) != chunk)
+      checksum = crc8::crc_update(checksum, buffer.data(), chunk);
+      received += static_cast<uint32_t>(chunk);
+      if (!sink(buffer.data(), chunk))
       {
-        std::cerr << "[DoSdDownload] Write file error." << std::endl;
+        DrainSdDownloadStream(file_size - received);
         return 0;
       }
-
-      received += chunk;
     }
 
-    // Step 6: Retrieve and verify the trailing CRC-8 checksum sent by the Saturn.
     uint8_t device_checksum = 0;
     if (!ReadExactFromDevice(&device_checksum, 1))
     {
       std::cerr << "[DoSdDownload] Read checksum failed." << std::endl;
       return 0;
     }
-
     if (device_checksum != checksum)
     {
       std::cerr << "[DoSdDownload] Checksum mismatch." << std::endl;
       return 0;
     }
+    return 1;
+  }
+
+  /**
+   * @copydoc xfer::DoSdDownloadRange
+   */
+  int DoSdDownloadRange(const char *saturn_sd_path, uint32_t offset, uint32_t length,
+                        const SdSizeCallback &on_size, const SdDownloadSink &sink)
+  {
+    if (saturn_sd_path == nullptr)
+    {
+      std::cerr << "[DoSdDownload] Missing path/filename argument." << std::endl;
+      return 0;
+    }
+    if (GetRemoteIoCaps().chunked_transfers)
+    {
+      return ChunkedSdDownload(saturn_sd_path, offset, on_size, sink, length) ? 1 : 0;
+    }
+
+    // Older firmware only streams whole files: drop the bytes outside the range
+    const uint64_t end = static_cast<uint64_t>(offset) + length;
+    uint64_t position = 0;
+    const SdDownloadSink range_sink = [&](const uint8_t *data, std::size_t size)
+    {
+      const uint64_t first = std::max<uint64_t>(position, offset);
+      const uint64_t last = std::min<uint64_t>(position + size, end);
+      const bool ok = (first >= last) || sink(data + (first - position), static_cast<std::size_t>(last - first));
+      position += size;
+      return ok;
+    };
+    return DoSdDownloadStream(saturn_sd_path, on_size, range_sink);
+  }
+
+  /**
+   * @copydoc xfer::DoSdCopy
+   */
+  int DoSdCopy(const char *saturn_source, const char *saturn_target)
+  {
+    if (saturn_source == nullptr || saturn_target == nullptr)
+    {
+      std::cerr << "[DoSdCopy] Missing source/target argument." << std::endl;
+      return 0;
+    }
+    std::string source_key = saturn_source;
+    std::string target_key = saturn_target;
+    std::transform(source_key.begin(), source_key.end(), source_key.begin(), ::tolower);
+    std::transform(target_key.begin(), target_key.end(), target_key.begin(), ::tolower);
+    if (source_key == target_key)
+    {
+      std::cerr << "[DoSdCopy] Source and target are the same file." << std::endl;
+      return 0;
+    }
 
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    do
+    {
+      if (ftdi::g_interrupt_flag)
+      {
+        return 0;
+      }
+      std::vector<RemoteIoBatchItem> batch(1);
+      batch[0].command = RemoteIoCommand::COPY;
+      batch[0].argument = Be32String(offset) + saturn_source + '\0' + saturn_target;
+      if (DoRemoteIoBatch(batch) != 1)
+      {
+        return 0;
+      }
+      const RemoteIoBatchItem &item = batch[0];
+      if (item.status == RemoteIoStatus::UNSUPPORTED && offset == 0)
+      {
+        // Older firmware: the data crosses the link twice
+        std::cerr << "[DoSdCopy] Firmware can't copy on the card, copying through the host." << std::endl;
+        const std::filesystem::path temp = std::filesystem::temp_directory_path() /
+            ("ftx_sdcp_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp");
+        const int status = (DoSdDownload(saturn_source, temp.string().c_str()) == 1)
+            ? DoSdUpload(temp.string().c_str(), saturn_target)
+            : 0;
+        std::error_code ec;
+        std::filesystem::remove(temp, ec);
+        return status;
+      }
+      if (item.status != RemoteIoStatus::OK || item.reply.size() < 8)
+      {
+        std::cerr << "[DoSdCopy] Device returned status "
+                  << static_cast<int>(item.status) << std::endl;
+        return 0;
+      }
+      size = PayloadBe32(item.reply);
+      const uint32_t copied = PayloadBe32(item.reply, 4);
+      if (copied == 0 && offset < size)
+      {
+        std::cerr << "[DoSdCopy] Device stopped copying at byte " << offset << "." << std::endl;
+        return 0;
+      }
+      offset += copied;
+      cdbg << "[DoSdCopy] " << offset << " of " << size << " bytes copied." << std::endl;
+    } while (offset < size);
     return 1;
   }
 
@@ -1301,16 +3235,9 @@ namespace xfer
     std::string mtime;
   };
 
-  static std::vector<SdSyncEntry> ListSaturnDirForSync(const std::string &saturn_dir)
+  static std::vector<SdSyncEntry> ParseSaturnListingForSync(const std::string &listing)
   {
     std::vector<SdSyncEntry> entries;
-    std::string listing;
-    std::string path_arg = "-l " + saturn_dir;
-    if (xfer::DoListStr(path_arg.c_str(), listing) != 1)
-    {
-      return entries;
-    }
-
     std::istringstream iss(listing);
     std::string line;
     while (std::getline(iss, line))
@@ -1347,62 +3274,156 @@ namespace xfer
     return entries;
   }
 
-  static void GetSaturnTreeRecursive(const std::string &saturn_base, const std::string &current_rel, std::vector<SdSyncEntry> &out_list)
+  // Uses the TREE command when the device has it, else walks the tree one level
+  // at a time so that all listings of a level share one request batch.
+  static void GetSaturnTree(const std::string &saturn_base, std::vector<SdSyncEntry> &out_list)
   {
-    std::string current_saturn = saturn_base;
-    if (!current_rel.empty())
+    std::vector<SdTreeEntry> tree;
+    const int tree_status = xfer::DoListTree(saturn_base.c_str(), tree);
+    if (tree_status >= 0)
     {
-      if (current_saturn.back() != '/') current_saturn += '/';
-      current_saturn += current_rel;
+      for (const auto &item : tree)
+      {
+        char mtime[32];
+        std::snprintf(mtime, sizeof(mtime), "%04u-%02u-%02u %02u:%02u:%02u",
+                      1980U + (item.fat_date >> 9), (item.fat_date >> 5) & 0x0FU, item.fat_date & 0x1FU,
+                      static_cast<unsigned>(item.fat_time >> 11), (item.fat_time >> 5) & 0x3FU,
+                      (item.fat_time & 0x1FU) * 2U);
+        SdSyncEntry node;
+        node.rel_path = item.path;
+        node.is_dir = item.is_dir;
+        node.size = item.size;
+        node.mtime = mtime;
+        out_list.push_back(node);
+      }
+      return;
     }
 
-    auto items = ListSaturnDirForSync(current_saturn);
-    for (const auto &item : items)
+    std::vector<std::string> level{""};
+    while (!level.empty())
     {
-      std::string rel = current_rel.empty() ? item.rel_path : (current_rel + "/" + item.rel_path);
-      SdSyncEntry node;
-      node.rel_path = rel;
-      node.is_dir = item.is_dir;
-      node.size = item.size;
-      node.mtime = item.mtime;
-      out_list.push_back(node);
+      std::vector<RemoteIoBatchItem> batch(level.size());
+      for (std::size_t i = 0; i < level.size(); ++i)
+      {
+        std::string current_saturn = saturn_base;
+        if (!level[i].empty())
+        {
+          if (current_saturn.back() != '/') current_saturn += '/';
+          current_saturn += level[i];
+        }
+        batch[i].command = RemoteIoCommand::LIST;
+        batch[i].argument = "-l " + current_saturn;
+      }
+      if (xfer::DoRemoteIoBatch(batch) != 1)
+      {
+        return;
+      }
 
-      if (item.is_dir)
+      std::vector<std::string> next_level;
+      for (std::size_t i = 0; i < level.size(); ++i)
       {
-        GetSaturnTreeRecursive(saturn_base, rel, out_list);
+        if (batch[i].status != RemoteIoStatus::OK)
+        {
+          continue;
+        }
+        for (const auto &item : ParseSaturnListingForSync(batch[i].reply))
+        {
+          SdSyncEntry node = item;
+          node.rel_path = level[i].empty() ? item.rel_path : (level[i] + "/" + item.rel_path);
+          out_list.push_back(node);
+          if (node.is_dir)
+          {
+            next_level.push_back(node.rel_path);
+          }
+        }
       }
+      level.swap(next_level);
     }
   }
 
-  static void GetLocalTreeRecursive(const std::filesystem::path &local_base, const std::string &current_rel, std::vector<SdSyncEntry> &out_list)
+  // Creates directories in one request batch; parents must precede their children.
+  static void MakeSaturnDirs(const std::vector<std::string> &saturn_dirs)
   {
-    std::filesystem::path current_local = local_base;
-    if (!current_rel.empty())
+    std::vector<RemoteIoBatchItem> batch(saturn_dirs.size());
+    for (std::size_t i = 0; i < saturn_dirs.size(); ++i)
     {
-      current_local /= current_rel;
+      batch[i].command = RemoteIoCommand::MKDIR;
+      batch[i].argument = saturn_dirs[i];
     }
+    xfer::DoRemoteIoBatch(batch);
+  }
 
-    std::error_code ec;
-    if (!std::filesystem::exists(current_local, ec)) return;
+  // Walks the local tree on a pool of worker threads, one directory per task.
+  // Entries come back sorted by relative path.
+  static std::vector<SdSyncEntry> ScanLocalTree(const std::filesystem::path &local_base)
+  {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> pending{""};
+    std::size_t busy = 0;
+    std::vector<SdSyncEntry> entries;
 
-    for (const auto &entry : std::filesystem::directory_iterator(current_local, ec))
-    {
-      std::string name = entry.path().filename().string();
-      std::string rel = current_rel.empty() ? name : (current_rel + "/" + name);
-      SdSyncEntry node;
-      node.rel_path = rel;
-      node.is_dir = entry.is_directory(ec);
-      if (!node.is_dir)
+    auto worker = [&]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      for (;;)
       {
-        node.size = static_cast<uint32_t>(entry.file_size(ec));
-      }
-      out_list.push_back(node);
+        cv.wait(lock, [&] { return !pending.empty() || busy == 0; });
+        if (pending.empty())
+        {
+          return;
+        }
+        const std::string current_rel = std::move(pending.back());
+        pending.pop_back();
+        ++busy;
+        lock.unlock();
+
+        std::vector<SdSyncEntry> found;
+        std::vector<std::string> subdirs;
+        const std::filesystem::path current_local = current_rel.empty() ? local_base : local_base / current_rel;
+        std::error_code ec;
+        if (std::filesystem::exists(current_local, ec))
+        {
+          for (const auto &entry : std::filesystem::directory_iterator(current_local, ec))
+          {
+            std::string name = entry.path().filename().string();
+            SdSyncEntry node;
+            node.rel_path = current_rel.empty() ? name : (current_rel + "/" + name);
+            node.is_dir = entry.is_directory(ec);
+            if (node.is_dir)
+            {
+              subdirs.push_back(node.rel_path);
+            }
+            else
+            {
+              node.size = static_cast<uint32_t>(entry.file_size(ec));
+            }
+            found.push_back(std::move(node));
+          }
+        }
 
-      if (node.is_dir)
-      {
-        GetLocalTreeRecursive(local_base, rel, out_list);
+        lock.lock();
+        std::move(found.begin(), found.end(), std::back_inserter(entries));
+        std::move(subdirs.begin(), subdirs.end(), std::back_inserter(pending));
+        --busy;
+        cv.notify_all();
       }
+    };
+
+    const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w < hw; ++w)
+    {
+      pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &t : pool)
+    {
+      t.join();
     }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const SdSyncEntry &a, const SdSyncEntry &b) { return a.rel_path < b.rel_path; });
+    return entries;
   }
 
   static std::string CombineSaturnPath(const std::string &base, const std::string &rel)
@@ -1412,211 +3433,543 @@ namespace xfer
     return base + "/" + rel;
   }
 
-  int DoSdSync(const char *local_path, const char *saturn_sd_path, int mode)
+  // Content-hash cache, kept next to the synchronized folder so that
+  // unchanged files are not re-read on every sync, locally or on the card.
+  struct SyncManifestEntry {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    sha1::digest_t hash{};
+  };
+
+  // Card-side entry, keyed by the size and FAT timestamp listed by TREE.
+  struct SyncCardEntry {
+    uint64_t size = 0;
+    std::string mtime;
+    sha1::digest_t hash{};
+  };
+
+  struct SyncManifest {
+    std::map<std::string, SyncManifestEntry> local;
+    std::map<std::string, SyncCardEntry> card;
+  };
+
+  static const char SYNC_MANIFEST_HEADER[] = "ftx-sync-manifest 1";
+
+  static std::filesystem::path SyncManifestPath(const std::filesystem::path &local_base)
   {
-    if (!local_path || !saturn_sd_path)
+    std::error_code ec;
+    std::filesystem::path folder = std::filesystem::weakly_canonical(std::filesystem::absolute(local_base, ec), ec);
+    if (!folder.has_filename())
     {
-      std::cerr << "[DoSdSync] Missing local or Saturn SD path." << std::endl;
-      return 0;
+      folder = folder.parent_path();
     }
-
-    std::string saturn_base = saturn_sd_path;
-    if (saturn_base.empty() || saturn_base[0] != '/')
+    if (!folder.has_filename())
     {
-      saturn_base = "/" + saturn_base;
+      return folder / ".ftxsync";
     }
-    if (saturn_base.size() > 1 && saturn_base.back() == '/')
+    return folder.parent_path() / (folder.filename().string() + ".ftxsync");
+  }
+
+  static SyncManifest LoadSyncManifest(const std::filesystem::path &manifest_path)
+  {
+    SyncManifest manifest;
+    std::ifstream in(manifest_path);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != SYNC_MANIFEST_HEADER)
     {
-      saturn_base.pop_back();
+      return manifest;
     }
 
-    std::filesystem::path local_base(local_path);
-    std::error_code ec;
+    // Local files:  <sha1 hex> <size> <mtime> <relative path>
+    // Card files:   card <sha1 hex> <size> <date> <time> <relative path>
+    while (std::getline(in, line))
+    {
+      std::istringstream fields(line);
+      std::string hex;
+      std::string rel;
+      if (line.compare(0, 5, "card ") == 0)
+      {
+        SyncCardEntry entry;
+        std::string keyword, date, time_str;
+        if (!(fields >> keyword >> hex >> entry.size >> date >> time_str) || !sha1::from_hex(hex, entry.hash) ||
+            !std::getline(fields, rel) || rel.size() < 2)
+        {
+          continue;
+        }
+        entry.mtime = date + " " + time_str;
+        manifest.card[rel.substr(1)] = entry;
+        continue;
+      }
 
-    std::cout << "[DoSdSync] Synchronizing (Mode " << mode << "): '"
-              << local_base.string() << "' <-> Saturn:'" << saturn_base << "'" << std::endl;
+      SyncManifestEntry entry;
+      if (!(fields >> hex >> entry.size >> entry.mtime) || !sha1::from_hex(hex, entry.hash) ||
+          !std::getline(fields, rel) || rel.size() < 2)
+      {
+        continue;
+      }
+      manifest.local[rel.substr(1)] = entry;
+    }
+    return manifest;
+  }
 
-    if (mode == 1)
+  static void SaveSyncManifest(const std::filesystem::path &manifest_path, const SyncManifest &manifest)
+  {
+    std::filesystem::path temp_path = manifest_path;
+    temp_path += ".tmp";
     {
-      // Mode 1: Copy local -> Saturn SD (default)
-      if (!std::filesystem::exists(local_base, ec))
+      std::ofstream out(temp_path, std::ios::trunc);
+      out << SYNC_MANIFEST_HEADER << '\n';
+      for (const auto &it : manifest.local)
       {
-        std::cerr << "[DoSdSync] Local directory does not exist: " << local_base << std::endl;
-        return 0;
+        out << sha1::to_hex(it.second.hash) << ' ' << it.second.size << ' ' << it.second.mtime << ' '
+            << it.first << '\n';
+      }
+      for (const auto &it : manifest.card)
+      {
+        out << "card " << sha1::to_hex(it.second.hash) << ' ' << it.second.size << ' ' << it.second.mtime << ' '
+            << it.first << '\n';
+      }
+      if (!out)
+      {
+        std::cerr << "[DoSdSync] Can't write the sync manifest " << temp_path << std::endl;
+        return;
       }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, manifest_path, ec);
+    if (ec)
+    {
+      std::cerr << "[DoSdSync] Can't update the sync manifest " << manifest_path << ": " << ec.message() << std::endl;
+    }
+  }
+
+  static bool LocalFileStamp(const std::filesystem::path &file, uint64_t &size, int64_t &mtime)
+  {
+    std::error_code ec;
+    size = std::filesystem::file_size(file, ec);
+    if (ec)
+    {
+      return false;
+    }
+    mtime = static_cast<int64_t>(std::filesystem::last_write_time(file, ec).time_since_epoch().count());
+    return !ec;
+  }
+
+  // Hash of a local file. The previous manifest entry is reused while size and
+  // mtime are unchanged. Safe to call from several threads.
+  static bool LocalSyncHash(const std::filesystem::path &local_base, const std::string &rel,
+                            const SyncManifest &previous, SyncManifestEntry &entry)
+  {
+    const std::filesystem::path file = local_base / rel;
+    if (!LocalFileStamp(file, entry.size, entry.mtime))
+    {
+      return false;
+    }
 
-      std::vector<SdSyncEntry> local_items;
-      GetLocalTreeRecursive(local_base, "", local_items);
+    const auto it = previous.local.find(rel);
+    if (it != previous.local.end() && it->second.size == entry.size && it->second.mtime == entry.mtime)
+    {
+      entry.hash = it->second.hash;
+      return true;
+    }
 
-      // Create base folder on Saturn SD
-      xfer::DoMkdir(saturn_base.c_str());
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+    {
+      return false;
+    }
+    sha1::Hasher hasher;
+    std::vector<char> buffer(1 << 20);
+    while (in)
+    {
+      in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      hasher.update(reinterpret_cast<const unsigned char *>(buffer.data()), static_cast<std::size_t>(in.gcount()));
+    }
+    if (in.bad())
+    {
+      return false;
+    }
+    entry.hash = hasher.finish();
+    return true;
+  }
 
-      // Create all directories first
-      for (const auto &item : local_items)
+  namespace
+  {
+    // Hashes local files on worker threads in plan order, so that transfers
+    // can start on the first entries while later ones are still being hashed.
+    class SyncHashQueue
+    {
+    public:
+      SyncHashQueue(const std::filesystem::path &local_base, const std::vector<std::string> &rels,
+                    const SyncManifest &previous)
+          : local_base_(local_base), rels_(rels), previous_(previous), results_(rels.size())
       {
-        if (item.is_dir)
+        const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t w = 0; w < std::min(rels_.size(), hw); ++w)
         {
-          std::string target_saturn = CombineSaturnPath(saturn_base, item.rel_path);
-          xfer::DoMkdir(target_saturn.c_str());
+          workers_.emplace_back([this] { Run(); });
         }
       }
 
-      // Copy all files
-      int success_count = 0;
-      int fail_count = 0;
-      for (const auto &item : local_items)
+      ~SyncHashQueue()
       {
-        if (!item.is_dir)
+        Cancel();
+        for (std::thread &t : workers_)
         {
-          std::filesystem::path src = local_base / item.rel_path;
-          std::string target_saturn = CombineSaturnPath(saturn_base, item.rel_path);
-          std::cout << "[DoSdSync] Uploading " << item.rel_path << " -> " << target_saturn << std::endl;
-          if (xfer::DoSdUpload(src.string().c_str(), target_saturn.c_str()) == 1)
-          {
-            success_count++;
-          }
-          else
+          t.join();
+        }
+      }
+
+      SyncHashQueue(const SyncHashQueue &) = delete;
+      SyncHashQueue &operator=(const SyncHashQueue &) = delete;
+
+      // Stops hashing entries not started yet; Wait() must not be called afterwards.
+      void Cancel()
+      {
+        cancel_ = true;
+      }
+
+      // Blocks until entry @p index is hashed; false if the file can't be read.
+      bool Wait(std::size_t index, SyncManifestEntry &entry)
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return results_[index].done; });
+        entry = results_[index].entry;
+        return results_[index].ok;
+      }
+
+    private:
+      struct Result
+      {
+        bool done = false;
+        bool ok = false;
+        SyncManifestEntry entry;
+      };
+
+      void Run()
+      {
+        for (std::size_t i = next_++; i < rels_.size() && !cancel_; i = next_++)
+        {
+          Result result;
+          result.ok = LocalSyncHash(local_base_, rels_[i], previous_, result.entry);
+          result.done = true;
           {
-            fail_count++;
+            std::lock_guard<std::mutex> lock(mutex_);
+            results_[i] = result;
           }
+          cv_.notify_all();
         }
       }
-      std::cout << "[DoSdSync] Upload sync complete. " << success_count << " succeeded, " << fail_count << " failed." << std::endl;
-      return (fail_count == 0) ? 1 : 0;
-    }
-    else if (mode == 2)
-    {
-      // Mode 2: Copy Saturn SD -> local
-      std::filesystem::create_directories(local_base, ec);
 
-      std::vector<SdSyncEntry> saturn_items;
-      GetSaturnTreeRecursive(saturn_base, "", saturn_items);
+      const std::filesystem::path local_base_;
+      const std::vector<std::string> &rels_;
+      const SyncManifest &previous_;
+      std::vector<Result> results_;
+      std::mutex mutex_;
+      std::condition_variable cv_;
+      std::atomic<std::size_t> next_{0};
+      std::atomic<bool> cancel_{false};
+      std::vector<std::thread> workers_;
+    };
+  }
+
+  // What DoSdSync does with one path present on either side.
+  enum class SyncAction
+  {
+    NONE,
+    MKDIR_SATURN,
+    MKDIR_LOCAL,
+    UPLOAD,
+    DOWNLOAD,
+    UPDATE_SATURN, // file on both sides, uploaded if the contents differ
+    UPDATE_LOCAL   // file on both sides, downloaded if the contents differ
+  };
+
+  struct SyncPlanEntry {
+    const SdSyncEntry *local = nullptr;
+    const SdSyncEntry *saturn = nullptr;
+    SyncAction action = SyncAction::NONE;
+    std::size_t hash_index = 0; // UPDATE_*: index in the local hash queue
+  };
+
+  // Merges both trees, sorted by relative path, into one flat plan and
+  // picks the action of every entry for the sync @p mode.
+  static std::vector<SyncPlanEntry> BuildSyncPlan(const std::vector<SdSyncEntry> &local_items,
+                                                  const std::vector<SdSyncEntry> &saturn_items, int mode)
+  {
+    const bool push = (mode == 1 || mode == 3);
+    const bool pull = (mode == 2 || mode == 3);
+    std::vector<SyncPlanEntry> plan;
+    plan.reserve(std::max(local_items.size(), saturn_items.size()));
+
+    auto l = local_items.begin();
+    auto r = saturn_items.begin();
+    while (l != local_items.end() || r != saturn_items.end())
+    {
+      SyncPlanEntry entry;
+      if (r == saturn_items.end() || (l != local_items.end() && l->rel_path < r->rel_path))
+      {
+        entry.local = &*l++;
+      }
+      else if (l == local_items.end() || r->rel_path < l->rel_path)
+      {
+        entry.saturn = &*r++;
+      }
+      else
+      {
+        entry.local = &*l++;
+        entry.saturn = &*r++;
+      }
 
-      // Create all local directories first
-      for (const auto &item : saturn_items)
+      if (entry.local && entry.saturn)
       {
-        if (item.is_dir)
+        if (!entry.local->is_dir && !entry.saturn->is_dir)
         {
-          std::filesystem::path target_local = local_base / item.rel_path;
-          std::filesystem::create_directories(target_local, ec);
+          entry.action = (mode == 2) ? SyncAction::UPDATE_LOCAL : SyncAction::UPDATE_SATURN;
         }
       }
+      else if (entry.local && push)
+      {
+        entry.action = entry.local->is_dir ? SyncAction::MKDIR_SATURN : SyncAction::UPLOAD;
+      }
+      else if (entry.saturn && pull)
+      {
+        entry.action = entry.saturn->is_dir ? SyncAction::MKDIR_LOCAL : SyncAction::DOWNLOAD;
+      }
+
+      if (entry.action != SyncAction::NONE)
+      {
+        plan.push_back(entry);
+      }
+    }
+    return plan;
+  }
+
+  // Card-side hashes of @p files below @p saturn_base. Entries of the
+  // previous manifest are reused while the listed size and timestamp are
+  // unchanged; the rest are fetched in one request batch. Every known hash
+  // goes to @p current. Files missing on the card are left out. Returns
+  // false if the firmware lacks the HASH command.
+  static bool GetSaturnHashes(const std::string &saturn_base, const std::vector<const SdSyncEntry *> &files,
+                              const SyncManifest &previous, SyncManifest &current,
+                              std::map<std::string, sha1::digest_t> &hashes)
+  {
+    std::vector<const SdSyncEntry *> pending;
+    for (const SdSyncEntry *file : files)
+    {
+      const auto it = previous.card.find(file->rel_path);
+      if (it != previous.card.end() && it->second.size == file->size && it->second.mtime == file->mtime)
+      {
+        hashes[file->rel_path] = it->second.hash;
+        current.card[file->rel_path] = it->second;
+      }
+      else
+      {
+        pending.push_back(file);
+      }
+    }
+
+    std::vector<RemoteIoBatchItem> batch(pending.size());
+    for (std::size_t i = 0; i < pending.size(); ++i)
+    {
+      batch[i].command = RemoteIoCommand::HASH;
+      batch[i].argument = CombineSaturnPath(saturn_base, pending[i]->rel_path);
+    }
+    if (xfer::DoRemoteIoBatch(batch) != 1)
+    {
+      return false;
+    }
 
-      // Download all files
-      int success_count = 0;
-      int fail_count = 0;
-      for (const auto &item : saturn_items)
+    for (std::size_t i = 0; i < pending.size(); ++i)
+    {
+      if (batch[i].status == RemoteIoStatus::UNSUPPORTED)
       {
-        if (!item.is_dir)
+        return false;
+      }
+      if (batch[i].status == RemoteIoStatus::OK && batch[i].reply.size() == REMOTE_IO_HASH_REPLY_SIZE)
+      {
+        sha1::digest_t &digest = hashes[pending[i]->rel_path];
+        std::memcpy(digest.data(), batch[i].reply.data() + 4, digest.size());
+        if (!pending[i]->mtime.empty())
         {
-          std::string src_saturn = CombineSaturnPath(saturn_base, item.rel_path);
-          std::filesystem::path target_local = local_base / item.rel_path;
-          std::cout << "[DoSdSync] Downloading " << src_saturn << " -> " << target_local.string() << std::endl;
-          if (xfer::DoSdDownload(src_saturn.c_str(), target_local.string().c_str()) == 1)
-          {
-            success_count++;
-          }
-          else
-          {
-            fail_count++;
-          }
+          SyncCardEntry &entry = current.card[pending[i]->rel_path];
+          entry.size = pending[i]->size;
+          entry.mtime = pending[i]->mtime;
+          entry.hash = digest;
         }
       }
-      std::cout << "[DoSdSync] Download sync complete. " << success_count << " succeeded, " << fail_count << " failed." << std::endl;
-      return (fail_count == 0) ? 1 : 0;
     }
-    else if (mode == 3)
+    return true;
+  }
+
+  int DoSdSync(const char *local_path, const char *saturn_sd_path, int mode)
+  {
+    if (!local_path || !saturn_sd_path)
     {
-      // Mode 3: Synchronize both folders recursively (bidirectional)
-      std::filesystem::create_directories(local_base, ec);
+      std::cerr << "[DoSdSync] Missing local or Saturn SD path." << std::endl;
+      return 0;
+    }
 
-      std::vector<SdSyncEntry> local_items;
-      GetLocalTreeRecursive(local_base, "", local_items);
+    std::string saturn_base = saturn_sd_path;
+    if (saturn_base.empty() || saturn_base[0] != '/')
+    {
+      saturn_base = "/" + saturn_base;
+    }
+    if (saturn_base.size() > 1 && saturn_base.back() == '/')
+    {
+      saturn_base.pop_back();
+    }
+
+    if (mode < 1 || mode > 3)
+    {
+      std::cerr << "[DoSdSync] Invalid sync mode: " << mode << std::endl;
+      return 0;
+    }
+
+    std::filesystem::path local_base(local_path);
+    std::error_code ec;
 
-      std::vector<SdSyncEntry> saturn_items;
-      GetSaturnTreeRecursive(saturn_base, "", saturn_items);
+    std::cout << "[DoSdSync] Synchronizing (Mode " << mode << "): '"
+              << local_base.string() << "' <-> Saturn:'" << saturn_base << "'" << std::endl;
 
-      std::map<std::string, SdSyncEntry> local_map;
-      for (const auto &it : local_items) local_map[it.rel_path] = it;
+    if (mode == 1 && !std::filesystem::exists(local_base, ec))
+    {
+      std::cerr << "[DoSdSync] Local directory does not exist: " << local_base << std::endl;
+      return 0;
+    }
+    if (mode != 1)
+    {
+      std::filesystem::create_directories(local_base, ec);
+    }
+    if (mode != 2)
+    {
+      MakeSaturnDirs({saturn_base});
+    }
 
-      std::map<std::string, SdSyncEntry> saturn_map;
-      for (const auto &it : saturn_items) saturn_map[it.rel_path] = it;
+    // The local walk runs on worker threads while the card is listed over USB.
+    std::future<std::vector<SdSyncEntry>> local_scan =
+        std::async(std::launch::async, ScanLocalTree, local_base);
+    std::vector<SdSyncEntry> saturn_items;
+    GetSaturnTree(saturn_base, saturn_items);
+    std::sort(saturn_items.begin(), saturn_items.end(),
+              [](const SdSyncEntry &a, const SdSyncEntry &b) { return a.rel_path < b.rel_path; });
+    const std::vector<SdSyncEntry> local_items = local_scan.get();
 
-      std::set<std::string> all_paths;
-      for (const auto &it : local_items) all_paths.insert(it.rel_path);
-      for (const auto &it : saturn_items) all_paths.insert(it.rel_path);
+    std::vector<SyncPlanEntry> plan = BuildSyncPlan(local_items, saturn_items, mode);
 
-      xfer::DoMkdir(saturn_base.c_str());
+    // Directories first; sorting puts parents before their children
+    std::vector<std::string> saturn_dirs;
+    std::vector<std::string> compare_files;
+    std::vector<const SdSyncEntry *> compare_saturn;
+    for (SyncPlanEntry &entry : plan)
+    {
+      if (entry.action == SyncAction::MKDIR_SATURN)
+      {
+        saturn_dirs.push_back(CombineSaturnPath(saturn_base, entry.local->rel_path));
+      }
+      else if (entry.action == SyncAction::MKDIR_LOCAL)
+      {
+        std::filesystem::create_directories(local_base / entry.saturn->rel_path, ec);
+      }
+      else if (entry.action == SyncAction::UPDATE_SATURN || entry.action == SyncAction::UPDATE_LOCAL)
+      {
+        entry.hash_index = compare_files.size();
+        compare_files.push_back(entry.local->rel_path);
+        compare_saturn.push_back(entry.saturn);
+      }
+    }
+    MakeSaturnDirs(saturn_dirs);
 
-      int success_count = 0;
-      int fail_count = 0;
+    // Files on both sides are compared by content: local hashing starts now
+    // and overlaps with the card hashing them.
+    const std::filesystem::path manifest_path = SyncManifestPath(local_base);
+    const SyncManifest previous = LoadSyncManifest(manifest_path);
+    SyncManifest current;
+    SyncHashQueue local_hashes(local_base, compare_files, previous);
+    std::map<std::string, sha1::digest_t> saturn_hashes;
+    const bool have_hashes = GetSaturnHashes(saturn_base, compare_saturn, previous, current, saturn_hashes);
+    if (!have_hashes)
+    {
+      local_hashes.Cancel();
+    }
 
-      for (const auto &rel : all_paths)
+    int success_count = 0;
+    int fail_count = 0;
+    int unchanged_count = 0;
+    for (const SyncPlanEntry &entry : plan)
+    {
+      if (ftdi::g_interrupt_flag)
       {
-        bool in_local = local_map.count(rel) > 0;
-        bool in_saturn = saturn_map.count(rel) > 0;
+        break;
+      }
 
-        if (in_local && in_saturn)
+      const std::string &rel = entry.local ? entry.local->rel_path : entry.saturn->rel_path;
+      const auto saturn_hash = saturn_hashes.find(rel);
+      bool upload = (entry.action == SyncAction::UPLOAD);
+      bool download = (entry.action == SyncAction::DOWNLOAD);
+
+      if (entry.action == SyncAction::UPDATE_SATURN || entry.action == SyncAction::UPDATE_LOCAL)
+      {
+        // Without card hashes, mode 3 compares sizes and modes 1/2 always copy
+        bool differs = (mode != 3) || entry.local->size != entry.saturn->size;
+        SyncManifestEntry local_entry;
+        if (have_hashes && local_hashes.Wait(entry.hash_index, local_entry))
         {
-          const auto &loc = local_map[rel];
-          const auto &sat = saturn_map[rel];
-          if (loc.is_dir && sat.is_dir)
-          {
-            continue;
-          }
-          else if (!loc.is_dir && !sat.is_dir)
-          {
-            // Both are files. If size differs, update from local to Saturn
-            if (loc.size != sat.size)
-            {
-              std::cout << "[DoSdSync] File size mismatch for " << rel << " (Local: " << loc.size << ", Saturn: " << sat.size << "). Updating Saturn." << std::endl;
-              std::filesystem::path src_local = local_base / rel;
-              std::string dst_saturn = CombineSaturnPath(saturn_base, rel);
-              if (xfer::DoSdUpload(src_local.string().c_str(), dst_saturn.c_str()) == 1) success_count++;
-              else fail_count++;
-            }
-          }
+          current.local[rel] = local_entry;
+          differs = (saturn_hash == saturn_hashes.end() || saturn_hash->second != local_entry.hash);
         }
-        else if (in_local && !in_saturn)
+        if (!differs)
         {
-          const auto &loc = local_map[rel];
-          std::string dst_saturn = CombineSaturnPath(saturn_base, rel);
-          if (loc.is_dir)
-          {
-            xfer::DoMkdir(dst_saturn.c_str());
-          }
-          else
-          {
-            std::filesystem::path src_local = local_base / rel;
-            std::cout << "[DoSdSync] Uploading missing file to Saturn: " << rel << std::endl;
-            if (xfer::DoSdUpload(src_local.string().c_str(), dst_saturn.c_str()) == 1) success_count++;
-            else fail_count++;
-          }
+          unchanged_count++;
+          continue;
         }
-        else if (!in_local && in_saturn)
+        upload = (entry.action == SyncAction::UPDATE_SATURN);
+        download = (entry.action == SyncAction::UPDATE_LOCAL);
+      }
+
+      const std::filesystem::path local_file = local_base / rel;
+      const std::string saturn_file = CombineSaturnPath(saturn_base, rel);
+      if (upload)
+      {
+        std::cout << "[DoSdSync] Uploading " << rel << " -> " << saturn_file << std::endl;
+        // Files already on the card only get their changed blocks
+        const int status = (entry.action == SyncAction::UPDATE_SATURN)
+                               ? xfer::DoSdDeltaUpload(local_file.string().c_str(), saturn_file.c_str())
+                               : xfer::DoSdUpload(local_file.string().c_str(), saturn_file.c_str());
+        // The card timestamp changed; hash the file again next time
+        current.card.erase(rel);
+        if (status == 1) success_count++;
+        else fail_count++;
+      }
+      else if (download)
+      {
+        std::cout << "[DoSdSync] Downloading " << saturn_file << " -> " << local_file.string() << std::endl;
+        if (xfer::DoSdDownload(saturn_file.c_str(), local_file.string().c_str()) == 1)
         {
-          const auto &sat = saturn_map[rel];
-          std::filesystem::path dst_local = local_base / rel;
-          std::string src_saturn = CombineSaturnPath(saturn_base, rel);
-          if (sat.is_dir)
-          {
-            std::filesystem::create_directories(dst_local, ec);
-          }
-          else
+          success_count++;
+          // The local copy now has the card content
+          SyncManifestEntry local_entry;
+          if (saturn_hash != saturn_hashes.end() && LocalFileStamp(local_file, local_entry.size, local_entry.mtime))
           {
-            std::cout << "[DoSdSync] Downloading missing file to local: " << rel << std::endl;
-            if (xfer::DoSdDownload(src_saturn.c_str(), dst_local.string().c_str()) == 1) success_count++;
-            else fail_count++;
+            local_entry.hash = saturn_hash->second;
+            current.local[rel] = local_entry;
           }
         }
+        else
+        {
+          fail_count++;
+        }
       }
-
-      std::cout << "[DoSdSync] Bidirectional sync complete. " << success_count << " operations succeeded, " << fail_count << " failed." << std::endl;
-      return (fail_count == 0) ? 1 : 0;
     }
 
-    std::cerr << "[DoSdSync] Invalid sync mode: " << mode << std::endl;
-    return 0;
+    if (have_hashes)
+    {
+      SaveSyncManifest(manifest_path, current);
+    }
+    static const char *const summary[] = {"Upload", "Download", "Bidirectional"};
+    std::cout << "[DoSdSync] " << summary[mode - 1] << " sync complete. " << success_count << " succeeded, "
+              << fail_count << " failed, " << unchanged_count << " unchanged." << std::endl;
+    return (fail_count == 0 && !ftdi::g_interrupt_flag) ? 1 : 0;
   }
 
 } // namespace xfer
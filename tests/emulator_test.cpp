@@ -0,0 +1,483 @@
+/**
+ * @file emulator_test.cpp
+ * @brief Round-trip regression tests against the in-process cartridge emulator.
+ * @details Built when FTX_BUILD_TESTS is enabled (the default) and run by ctest:
+ *          @code
+ *          cmake -S . -B build
+ *          cmake --build build
+ *          ctest --test-dir build --output-on-failure
+ *          @endcode
+ *          Every test case installs a fresh emulator transport and drives the
+ *          same xfer entry points as the command line (`-u`/`-d`, `--cp`/`--get`),
+ *          so no hardware is needed. Each transfer also prints its duration
+ *          and throughput to keep an eye on protocol overhead in the ctest log.
+ *          The crc_kernels case checks the CRC-8 kernels all transfers rely on.
+ *
+ *          Usage: `ftx_emulator_test <case>`.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "crc.hpp"
+#include "emulator.hpp"
+#include "remote_io.hpp"
+#include "transport.hpp"
+#include "xfer.hpp"
+
+// Logging switches (log.hpp), defined by ftx.cpp in the command line tool.
+bool g_verbose = false;
+int g_verbose_level = 0;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Scratch directory removed when the test case ends.
+ */
+class ScratchDir
+{
+public:
+    ScratchDir()
+    {
+        std::random_device rd;
+        path_ = fs::temp_directory_path() / ("ftx-test-" + std::to_string(rd()));
+        fs::create_directories(path_);
+    }
+
+    ~ScratchDir()
+    {
+        std::error_code ec;
+        fs::remove_all(path_, ec);
+    }
+
+    std::string File(const std::string& name) const
+    {
+        return (path_ / name).string();
+    }
+
+private:
+    fs::path path_;
+};
+
+std::vector<uint8_t> MakeData(std::size_t size, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+bool WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Report a failed expectation.
+ * @return @p ok, so checks can be chained with &&.
+ */
+bool Check(bool ok, const std::string& what)
+{
+    if (!ok)
+    {
+        std::cerr << "[EmulatorTest] FAILED: " << what << std::endl;
+    }
+    return ok;
+}
+
+/**
+ * @brief Run one transfer and print its throughput.
+ * @return true if @p transfer returned 1.
+ */
+bool Timed(const std::string& label, std::size_t bytes, const std::function<int()>& transfer)
+{
+    const auto before = std::chrono::steady_clock::now();
+    const int status = transfer();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+    std::cout << "[EmulatorTest] " << label << ": " << bytes << " bytes in " << seconds * 1000.0 << " ms ("
+              << (seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0) << " MB/s)" << std::endl;
+    return Check(status == 1, label + " returned " + std::to_string(status));
+}
+
+bool UseFreshEmulator()
+{
+    std::unique_ptr<transport::Transport> link = transport::MakeEmulatorTransport("");
+    if (!Check(link != nullptr, "emulator transport creation"))
+    {
+        return false;
+    }
+    transport::SetActive(std::move(link));
+    return true;
+}
+
+/**
+ * @brief The dispatched CRC-8 kernels match the bytewise table reference,
+ *        including lengths below one 8-byte word and one 16-byte fold and
+ *        buffers at every alignment.
+ */
+bool TestCrcKernels()
+{
+    const std::vector<uint8_t> data = MakeData(70000, 9);
+    std::mt19937 rng(10);
+#if FTX_CRC8_HAVE_CLMUL
+    const bool clmul = std::strcmp(crc8::kernel_name(), "pclmul") == 0;
+#endif
+    std::cout << "[EmulatorTest] crc kernel: " << crc8::kernel_name() << std::endl;
+    for (int i = 0; i < 4000; ++i)
+    {
+        const std::size_t offset = rng() % 16;
+        const std::size_t length = (i < 600) ? static_cast<std::size_t>(i % 40) : rng() % (data.size() - offset);
+        const crc8::crc_t seed = static_cast<crc8::crc_t>(rng());
+        const unsigned char* p = data.data() + offset;
+        const crc8::crc_t expected = crc8::detail::crc_update_bytewise(seed, p, length);
+        const std::string what = " at offset " + std::to_string(offset) + ", length " + std::to_string(length);
+        if (!Check(crc8::crc_update(seed, p, length) == expected, "crc_update" + what) ||
+            !Check(crc8::detail::crc_update_slice8(seed, p, length) == expected, "slice8" + what))
+        {
+            return false;
+        }
+#if FTX_CRC8_HAVE_CLMUL
+        if (clmul && !Check(crc8::detail::crc_update_clmul(seed, p, length) == expected, "clmul" + what))
+        {
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+/**
+ * @brief `-u` then `-d` of the same work RAM range.
+ */
+bool TestMemoryRoundTrip()
+{
+    ScratchDir dir;
+    const uint32_t address = 0x06004000;
+    const std::vector<uint8_t> data = MakeData(768 * 1024 + 13, 1);
+    const std::string in = dir.File("in.bin");
+    const std::string out = dir.File("out.bin");
+
+    return UseFreshEmulator() && Check(WriteFile(in, data), "write input file") &&
+           Timed("upload", data.size(), [&] { return xfer::DoUpload(in.c_str(), address); }) &&
+           Timed("download", data.size(), [&] { return xfer::DoDownload(out.c_str(), address, data.size()); }) &&
+           Check(ReadFile(out) == data, "downloaded memory matches the upload");
+}
+
+/**
+ * @brief `--cp` then `--get` of SD card files, including an empty file and an on-card copy.
+ */
+bool TestSdRoundTrip()
+{
+    ScratchDir dir;
+    const std::vector<uint8_t> data = MakeData(300 * 1024 + 7, 2);
+    const std::string in = dir.File("in.bin");
+    const std::string out = dir.File("out.bin");
+    const std::string empty_in = dir.File("empty.bin");
+    const std::string empty_out = dir.File("empty_out.bin");
+    const std::string copy_out = dir.File("copy_out.bin");
+
+    return UseFreshEmulator() && Check(WriteFile(in, data), "write input file") &&
+           Check(WriteFile(empty_in, {}), "write empty input file") &&
+           Check(xfer::DoMkdir("/TEST") == 1, "mkdir /TEST") &&
+           Timed("sd upload", data.size(), [&] { return xfer::DoSdUpload(in.c_str(), "/TEST/DATA.BIN"); }) &&
+           Timed("sd download", data.size(), [&] { return xfer::DoSdDownload("/TEST/DATA.BIN", out.c_str()); }) &&
+           Check(ReadFile(out) == data, "downloaded file matches the upload") &&
+           Check(xfer::DoSdUpload(empty_in.c_str(), "/TEST/EMPTY.BIN") == 1, "upload empty file") &&
+           Check(xfer::DoSdDownload("/TEST/EMPTY.BIN", empty_out.c_str()) == 1, "download empty file") &&
+           Check(fs::exists(empty_out) && ReadFile(empty_out).empty(), "empty file round trip") &&
+           Check(xfer::DoSdCopy("/TEST/DATA.BIN", "/TEST/COPY.BIN") == 1, "on-card copy") &&
+           Check(xfer::DoSdDownload("/TEST/COPY.BIN", copy_out.c_str()) == 1, "download copy") &&
+           Check(ReadFile(copy_out) == data, "copied file matches the upload");
+}
+
+/**
+ * @brief `--delta --cp` of @p data over @p card_path, checked with `--get`.
+ * @param sent Set to the host to cartridge bytes of the upload.
+ */
+bool DeltaRoundTrip(const ScratchDir& dir, const std::string& label, const std::vector<uint8_t>& data,
+                    const char* card_path, uint64_t& sent)
+{
+    emu::CartEmulator* emulator = emu::EmulatorOf(transport::Active());
+    const std::string in = dir.File(label + ".bin");
+    const std::string out = dir.File(label + "_out.bin");
+    if (!Check(emulator != nullptr, "emulator transport") || !Check(WriteFile(in, data), "write " + label))
+    {
+        return false;
+    }
+    const uint64_t before = emulator->BytesReceived();
+    if (!Timed(label, data.size(), [&] { return xfer::DoSdDeltaUpload(in.c_str(), card_path); }))
+    {
+        return false;
+    }
+    sent = emulator->BytesReceived() - before;
+    return Check(xfer::DoSdDownload(card_path, out.c_str()) == 1, "download after " + label) &&
+           Check(ReadFile(out) == data, label + " result matches");
+}
+
+/**
+ * @brief `--delta --cp` of an edited and of a shifted file.
+ */
+bool TestSdDelta()
+{
+    ScratchDir dir;
+    std::vector<uint8_t> data = MakeData(64 * 1024 + 100, 5);
+    uint64_t sent = 0;
+    if (!UseFreshEmulator() || !DeltaRoundTrip(dir, "initial", data, "/DELTA.BIN", sent))
+    {
+        return false;
+    }
+
+    data[10] ^= 0x01;
+    data[30000] ^= 0x80;
+    data[data.size() - 1] ^= 0xFF;
+    if (!DeltaRoundTrip(dir, "changed", data, "/DELTA.BIN", sent) ||
+        !Check(sent < data.size() / 4, "changed file sent only its changed blocks"))
+    {
+        return false;
+    }
+
+    const std::vector<uint8_t> inserted = MakeData(300, 6);
+    data.insert(data.begin() + 20000, inserted.begin(), inserted.end());
+    return DeltaRoundTrip(dir, "inserted", data, "/DELTA.BIN", sent) &&
+           Check(sent < data.size() / 4, "shifted blocks were reused");
+}
+
+/**
+ * @brief `--delta --cp` falling back to a whole file upload.
+ * @details Covers a rewrite that shares no block with the card copy (the
+ *          script would be larger than the file) and firmware without
+ *          BLOCK_SUMS.
+ */
+bool TestSdDeltaFallback()
+{
+    ScratchDir dir;
+    std::vector<uint8_t> data = MakeData(64 * 1024 + 100, 7);
+    uint64_t sent = 0;
+    if (!UseFreshEmulator() || !DeltaRoundTrip(dir, "initial", data, "/DELTA.BIN", sent))
+    {
+        return false;
+    }
+
+    data = MakeData(data.size(), 8);
+    if (!DeltaRoundTrip(dir, "rewritten", data, "/DELTA.BIN", sent) ||
+        !Check(sent >= data.size(), "rewritten file was sent whole"))
+    {
+        return false;
+    }
+
+    emu::EmulatorOf(transport::Active())->DisableRemoteIoCommand(
+        static_cast<uint8_t>(xfer::RemoteIoCommand::BLOCK_SUMS));
+    data[100] ^= 0x01;
+    return DeltaRoundTrip(dir, "no-block-sums", data, "/DELTA.BIN", sent) &&
+           Check(sent >= data.size(), "file was sent whole without block sums");
+}
+
+/**
+ * @brief Aborted streamed transfers on firmware without chunked transfers.
+ * @details The device must drop the partial upload, and the link must be
+ *          usable by the next request after either abort.
+ */
+bool TestSdStreamAbort()
+{
+    ScratchDir dir;
+    const std::vector<uint8_t> data = MakeData(100 * 1024 + 3, 9);
+    const std::string in = dir.File("in.bin");
+    const std::string out = dir.File("out.bin");
+    if (!UseFreshEmulator())
+    {
+        return false;
+    }
+    emu::CartEmulator* emulator = emu::EmulatorOf(transport::Active());
+    emulator->DisableRemoteIoCommand(static_cast<uint8_t>(xfer::RemoteIoCommand::VERSION));
+
+    // The source stops halfway through the announced size
+    std::size_t position = 0;
+    const xfer::SdUploadSource short_source = [&](uint8_t* buffer, std::size_t size) -> long {
+        const std::size_t n = std::min(size, data.size() / 2 - position);
+        std::memcpy(buffer, data.data() + position, n);
+        position += n;
+        return static_cast<long>(n);
+    };
+    std::size_t delivered = 0;
+    const xfer::SdDownloadSink failing_sink = [&](const uint8_t*, std::size_t size) {
+        delivered += size;
+        return delivered < data.size() / 2;
+    };
+
+    return Check(WriteFile(in, data), "write input file") &&
+           Check(xfer::DoSdUploadStream("/ABORT.BIN", short_source, data.size()) == 0, "short upload fails") &&
+           Check(emulator->FindSd("/ABORT.BIN") == nullptr, "device dropped the short upload") &&
+           Check(xfer::DoSdUpload(in.c_str(), "/DATA.BIN") == 1, "upload after the aborted upload") &&
+           Check(xfer::DoSdDownloadStream("/DATA.BIN", nullptr, failing_sink) == 0, "aborted download fails") &&
+           Check(xfer::DoSdDownload("/DATA.BIN", out.c_str()) == 1, "download after the aborted download") &&
+           Check(ReadFile(out) == data, "downloaded file matches the upload");
+}
+
+/**
+ * @brief `--sync` of a folder holding a file larger than one HASH progress
+ *        interval, then again after a same-size edit.
+ */
+bool TestSdSync()
+{
+    ScratchDir dir;
+    const std::string local = dir.File("local");
+    const std::vector<uint8_t> big = MakeData(1024 * 1024 + 5, 3);
+    std::vector<uint8_t> small = MakeData(4096, 4);
+    const std::string big_out = dir.File("big_out.bin");
+    const std::string small_out = dir.File("small_out.bin");
+
+    if (!UseFreshEmulator() || !Check(fs::create_directories(local), "create local folder") ||
+        !Check(WriteFile(local + "/BIG.BIN", big) && WriteFile(local + "/SMALL.BIN", small), "write local files") ||
+        !Timed("first sync", big.size() + small.size(), [&] { return xfer::DoSdSync(local.c_str(), "/SYNC", 1); }) ||
+        !Timed("unchanged sync", big.size() + small.size(), [&] { return xfer::DoSdSync(local.c_str(), "/SYNC", 1); }))
+    {
+        return false;
+    }
+
+    small[100] ^= 0xFF;
+    return Check(WriteFile(local + "/SMALL.BIN", small), "edit local file") &&
+           Timed("edit sync", small.size(), [&] { return xfer::DoSdSync(local.c_str(), "/SYNC", 1); }) &&
+           Check(xfer::DoSdDownload("/SYNC/BIG.BIN", big_out.c_str()) == 1, "download large file") &&
+           Check(xfer::DoSdDownload("/SYNC/SMALL.BIN", small_out.c_str()) == 1, "download edited file") &&
+           Check(ReadFile(big_out) == big, "large file matches") &&
+           Check(ReadFile(small_out) == small, "same-size edit reached the card");
+}
+
+/**
+ * @brief Leave `--resume` state as an interrupted transfer of @p host_file would.
+ */
+bool WriteResumeState(const std::string& host_file, const std::string& direction, std::size_t size,
+                      const std::string& saturn_path)
+{
+    int64_t mtime = 0;
+    if (direction == "put")
+    {
+        mtime = static_cast<int64_t>(fs::last_write_time(host_file).time_since_epoch().count());
+    }
+    std::ofstream out(host_file + ".ftxpart");
+    out << "ftx-resume 1\n" << direction << ' ' << size << ' ' << mtime << '\n' << saturn_path << '\n';
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief `--resume` continues a partial transfer only if the card file
+ *        still holds the same prefix.
+ */
+bool TestSdResume()
+{
+    ScratchDir dir;
+    const std::vector<uint8_t> data = MakeData(20000, 6);
+    const std::vector<uint8_t> rewritten = MakeData(data.size(), 7);
+    const std::vector<uint8_t> head(data.begin(), data.begin() + 3000);
+    const std::vector<uint8_t> stale = MakeData(head.size(), 8);
+    const std::string in = dir.File("in.bin");
+    const std::string other = dir.File("other.bin");
+    const std::string out = dir.File("out.bin");
+    const std::string card_out = dir.File("card_out.bin");
+    if (!UseFreshEmulator() || !Check(WriteFile(in, data) && WriteFile(other, rewritten), "write input files") ||
+        !Check(xfer::DoSdUpload(in.c_str(), "/GET.BIN") == 1, "seed card file"))
+    {
+        return false;
+    }
+    emu::CartEmulator* emulator = emu::EmulatorOf(transport::Active());
+
+    // Download: the unchanged card file resumes, a rewritten one starts over
+    if (!Check(WriteFile(out, head) && WriteResumeState(out, "get", data.size(), "/GET.BIN"), "partial download") ||
+        !Check(xfer::DoSdDownload("/GET.BIN", out.c_str(), true) == 1, "resumed download") ||
+        !Check(ReadFile(out) == data, "resumed download matches") ||
+        !Check(xfer::DoSdUpload(other.c_str(), "/GET.BIN") == 1, "rewrite card file") ||
+        !Check(WriteFile(out, head) && WriteResumeState(out, "get", data.size(), "/GET.BIN"), "stale partial download") ||
+        !Check(xfer::DoSdDownload("/GET.BIN", out.c_str(), true) == 1, "download of the rewritten file") ||
+        !Check(ReadFile(out) == rewritten, "rewritten file downloaded whole"))
+    {
+        return false;
+    }
+
+    // Upload: a matching card prefix resumes, a stale card file is replaced
+    const std::string prefix = dir.File("prefix.bin");
+    if (!Check(WriteFile(prefix, head) && xfer::DoSdUpload(prefix.c_str(), "/PUT.BIN") == 1, "partial upload") ||
+        !Check(WriteResumeState(in, "put", data.size(), "/PUT.BIN"), "upload resume state"))
+    {
+        return false;
+    }
+    const uint64_t before = emulator->BytesReceived();
+    if (!Check(xfer::DoSdUpload(in.c_str(), "/PUT.BIN", true) == 1, "resumed upload") ||
+        !Check(emulator->BytesReceived() - before < data.size(), "resumed upload skipped the prefix") ||
+        !Check(xfer::DoSdDownload("/PUT.BIN", card_out.c_str()) == 1 && ReadFile(card_out) == data,
+               "resumed upload matches"))
+    {
+        return false;
+    }
+    return Check(WriteFile(prefix, stale) && xfer::DoSdUpload(prefix.c_str(), "/PUT.BIN") == 1, "stale card file") &&
+           Check(WriteResumeState(in, "put", data.size(), "/PUT.BIN"), "stale upload resume state") &&
+           Check(xfer::DoSdUpload(in.c_str(), "/PUT.BIN", true) == 1, "upload over the stale file") &&
+           Check(xfer::DoSdDownload("/PUT.BIN", card_out.c_str()) == 1 && ReadFile(card_out) == data,
+                 "stale card file replaced");
+}
+
+struct TestCase
+{
+    const char* name;
+    bool (*run)();
+};
+
+const TestCase kTestCases[] = {
+    {"crc_kernels", TestCrcKernels},
+    {"memory_roundtrip", TestMemoryRoundTrip},
+    {"sd_roundtrip", TestSdRoundTrip},
+    {"sd_delta", TestSdDelta},
+    {"sd_delta_fallback", TestSdDeltaFallback},
+    {"sd_stream_abort", TestSdStreamAbort},
+    {"sd_sync", TestSdSync},
+    {"sd_resume", TestSdResume},
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc == 2)
+    {
+        for (const TestCase& test : kTestCases)
+        {
+            if (std::strcmp(argv[1], test.name) == 0)
+            {
+                const bool ok = test.run();
+                std::cout << "[EmulatorTest] " << test.name << (ok ? " passed" : " failed") << std::endl;
+                return ok ? 0 : 1;
+            }
+        }
+    }
+
+    std::cerr << "Usage: " << argv[0] << " <case>\nCases:";
+    for (const TestCase& test : kTestCases)
+    {
+        std::cerr << " " << test.name;
+    }
+    std::cerr << std::endl;
+    return 2;
+}